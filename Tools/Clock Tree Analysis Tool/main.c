@@ -3,10 +3,16 @@
 #include <string.h>
 #include <math.h>
 #include <float.h>
+#include <limits.h>
+#include <time.h>
 
-#define MAX_NODES 1000
-#define MAX_NAME_LENGTH 50
-#define MAX_CHILDREN 10
+#include "../trace.h"
+
+#define INITIAL_NODE_CAPACITY 64
+#define SKEW_REPORT_COUNT 5          // Worst local skew pairs kept
+#define BENCH_DEFAULT_FANOUT 32
+#define BENCH_WIRE_LENGTH 50.0       // Sink wire length; each level up doubles it
+#define BENCH_EDITS 10000            // What-if edits timed by the benchmark
 
 // Enum for clock tree node types
 typedef enum {
@@ -16,245 +22,805 @@ typedef enum {
     CLOCK_ENDPOINT
 } ClockNodeType;
 
+// Nodes are referred to by their index in the tree's node pool
+typedef int ClockNodeId;
+
 // Clock tree node structure
 typedef struct ClockNode {
-    char name[MAX_NAME_LENGTH];
+    size_t name_offset;              // Into the tree's name pool
     ClockNodeType type;
-    
-    // Timing parameters
-    double arrival_time;
-    double insertion_delay;
-    double wire_length;
-    double capacitance;
-    
-    // Tree structure
-    struct ClockNode* parent;
-    struct ClockNode* children[MAX_CHILDREN];
+
+    // Timing parameters. Resistance is in kilohms and capacitance in
+    // picofarads, so their product is in nanoseconds.
+    double arrival_time;             // At the node's input
+    double insertion_delay;          // From the root's arrival
+    double wire_length;              // Of the wire from the parent
+    double resistance;               // Per unit of wire length
+    double capacitance;              // Per unit of wire length
+    double pin_capacitance;          // Input load of the node itself
+    double drive_resistance;         // Sources and buffers: output resistance
+    double intrinsic_delay;          // Sources and buffers: delay with no load
+    double downstream_capacitance;   // Load below the node up to the next buffers
+
+    // Tree structure. Children form a list in the order they were added;
+    // -1 ends it and marks a missing parent.
+    ClockNodeId parent;
+    ClockNodeId first_child;
+    ClockNodeId last_child;
+    ClockNodeId next_sibling;
     int child_count;
-    
+
     // Skew-related information
-    double skew_to_siblings;
-    double skew_to_endpoints;
+    double skew_to_siblings;         // Largest arrival difference to a sibling
+    double skew_to_endpoints;        // Sinks: arrival after the earliest sink
+    double subtree_skew;             // Spread of sink arrivals below this node
+
+    int position;                    // Index in the tree's preorder, -1 if unreached
 } ClockNode;
 
+// Two sinks and the skew between them
+typedef struct {
+    ClockNodeId early;
+    ClockNodeId late;
+    double skew;
+} SkewPair;
+
 // Clock tree structure
 typedef struct {
-    ClockNode* root;
-    ClockNode* nodes[MAX_NODES];
+    ClockNodeId root;                // -1 while the tree is empty
+    ClockNode* nodes;                // One pool, grown by doubling
     int node_count;
+    int node_capacity;
+    char* name_pool;                 // Every node name, NUL-terminated
+    size_t name_pool_size;
+    size_t name_pool_capacity;
+
+    // The tree reached from root flattened into preorder, so each subtree
+    // is a contiguous range and every parent comes before its children.
+    // Rebuilt by flatten_clock_tree() after the tree changes.
+    int flattened;
+    int order_count;
+    ClockNodeId* order;              // Node at each position
+    int* parent_position;            // -1 for the root
+    int* subtree_end;                // One past the last position in the subtree
+    int* depth;
+    int timing_valid;                // Delays match the current flattening
+
+    // Earliest and latest sink over ranges of preorder positions, as a
+    // segment tree: leaves at bounds_size + position, entry k covering
+    // entries 2k and 2k + 1, -1 where a range holds no sink. Built by
+    // compute_clock_skew() and patched by update_clock_timing(), so the
+    // global skew stays current after every edit.
+    int bounds_size;
+    ClockNodeId* earliest;
+    ClockNodeId* latest;
+
+    // Filled by compute_clock_skew(). Global skew spans every sink; local
+    // skew spans the sinks driven by one node, the closest stand-in for
+    // sequentially adjacent flops the tree itself records.
+    SkewPair global_skew;
+    SkewPair worst_local[SKEW_REPORT_COUNT];
+    int worst_local_count;
 } ClockTree;
 
 // Function prototypes
 ClockTree* create_clock_tree();
-ClockNode* create_clock_node(ClockTree* tree, const char* name, ClockNodeType type);
-void add_clock_node(ClockTree* tree, ClockNode* parent, ClockNode* child);
+void free_clock_tree(ClockTree* tree);
+void reserve_clock_tree(ClockTree* tree, int node_count, size_t name_bytes);
+ClockNodeId create_clock_node(ClockTree* tree, const char* name, ClockNodeType type);
+int add_clock_node(ClockTree* tree, ClockNodeId parent, ClockNodeId child);
+const char* clock_node_name(const ClockTree* tree, ClockNodeId node);
+void flatten_clock_tree(ClockTree* tree);
 void compute_insertion_delays(ClockTree* tree);
 void compute_clock_skew(ClockTree* tree);
 void print_clock_tree_analysis(ClockTree* tree);
+void print_clock_skew(const ClockTree* tree);
+void update_clock_timing(ClockTree* tree, ClockNodeId node);
+void set_clock_wire_length(ClockTree* tree, ClockNodeId node, double wire_length);
+void resize_clock_buffer(ClockTree* tree, ClockNodeId node, double drive_resistance, double intrinsic_delay,
+                         double pin_capacitance);
+int run_clock_tree_benchmark(int sink_count, int fanout);
+
+// Grow an array, exiting if memory runs out
+static void* grow_array(void* array, size_t count, size_t element_size) {
+    void* grown = realloc(array, count * element_size);
+    if (!grown) {
+        fprintf(stderr, "Out of memory growing clock tree to %zu entries\n", count);
+        exit(1);
+    }
+    return grown;
+}
 
 // Create a new clock tree
 ClockTree* create_clock_tree() {
-    ClockTree* tree = malloc(sizeof(ClockTree));
-    tree->root = NULL;
-    tree->node_count = 0;
+    ClockTree* tree = calloc(1, sizeof(ClockTree));
+    tree->root = -1;
+    tree->global_skew = (SkewPair){-1, -1, 0.0};
     return tree;
 }
 
-// Create a new clock node
-ClockNode* create_clock_node(ClockTree* tree, const char* name, ClockNodeType type) {
-    if (tree->node_count >= MAX_NODES) {
+void free_clock_tree(ClockTree* tree) {
+    free(tree->nodes);
+    free(tree->name_pool);
+    free(tree->order);
+    free(tree->parent_position);
+    free(tree->subtree_end);
+    free(tree->depth);
+    free(tree->earliest);
+    free(tree->latest);
+    free(tree);
+}
+
+// Size the node pool and name pool for a tree of known size up front, so
+// building it takes no further allocations
+void reserve_clock_tree(ClockTree* tree, int node_count, size_t name_bytes) {
+    if (node_count > tree->node_capacity) {
+        tree->nodes = grow_array(tree->nodes, node_count, sizeof(ClockNode));
+        tree->node_capacity = node_count;
+    }
+    if (name_bytes > tree->name_pool_capacity) {
+        tree->name_pool = grow_array(tree->name_pool, name_bytes, 1);
+        tree->name_pool_capacity = name_bytes;
+    }
+}
+
+// Create a new clock node. Returns its id, or -1 if the tree is full.
+ClockNodeId create_clock_node(ClockTree* tree, const char* name, ClockNodeType type) {
+    if (tree->node_count == INT_MAX) {
         fprintf(stderr, "Clock tree node limit exceeded\n");
-        return NULL;
+        return -1;
+    }
+    if (tree->node_count == tree->node_capacity) {
+        int capacity = tree->node_capacity ? tree->node_capacity : INITIAL_NODE_CAPACITY;
+        capacity = capacity > INT_MAX / 2 ? INT_MAX : capacity * 2;
+        tree->nodes = grow_array(tree->nodes, capacity, sizeof(ClockNode));
+        tree->node_capacity = capacity;
+    }
+
+    // Append the name to the name pool
+    size_t length = strlen(name);
+    if (tree->name_pool_size + length + 1 > tree->name_pool_capacity) {
+        size_t capacity = tree->name_pool_capacity ? tree->name_pool_capacity : 16 * INITIAL_NODE_CAPACITY;
+        while (tree->name_pool_size + length + 1 > capacity) capacity *= 2;
+        tree->name_pool = grow_array(tree->name_pool, capacity, 1);
+        tree->name_pool_capacity = capacity;
     }
 
-    ClockNode* node = malloc(sizeof(ClockNode));
-    strncpy(node->name, name, MAX_NAME_LENGTH - 1);
+    ClockNodeId id = tree->node_count++;
+    ClockNode* node = &tree->nodes[id];
+    node->name_offset = tree->name_pool_size;
+    memcpy(tree->name_pool + tree->name_pool_size, name, length + 1);
+    tree->name_pool_size += length + 1;
     node->type = type;
-    
+
     // Initialize timing parameters
     node->arrival_time = 0.0;
     node->insertion_delay = 0.0;
     node->wire_length = 0.0;
+    node->resistance = 0.0;
     node->capacitance = 0.0;
-    
+    node->pin_capacitance = 0.0;
+    node->drive_resistance = 0.0;
+    node->intrinsic_delay = 0.0;
+    node->downstream_capacitance = 0.0;
+
     // Initialize tree structure
-    node->parent = NULL;
+    node->parent = -1;
+    node->first_child = -1;
+    node->last_child = -1;
+    node->next_sibling = -1;
     node->child_count = 0;
-    
+
     // Initialize skew parameters
     node->skew_to_siblings = 0.0;
     node->skew_to_endpoints = 0.0;
+    node->subtree_skew = 0.0;
+    node->position = -1;
 
     // Set as root if it's the first node
-    if (tree->node_count == 0) {
-        tree->root = node;
+    if (id == 0) {
+        tree->root = id;
+        tree->flattened = 0;
     }
-
-    // Add to tree's node list
-    tree->nodes[tree->node_count++] = node;
-    
-    return node;
+    return id;
 }
 
-// Add a child node to the clock tree
-void add_clock_node(ClockTree* tree, ClockNode* parent, ClockNode* child) {
-    if (parent->child_count >= MAX_CHILDREN) {
-        fprintf(stderr, "Maximum children limit reached for node %s\n", parent->name);
-        return;
+// Add a child node to the clock tree. Returns 0 on success, -1 if the
+// child already has a parent.
+int add_clock_node(ClockTree* tree, ClockNodeId parent, ClockNodeId child) {
+    if (tree->nodes[child].parent >= 0) {
+        fprintf(stderr, "Node %s is already driven by %s\n", clock_node_name(tree, child),
+                clock_node_name(tree, tree->nodes[child].parent));
+        return -1;
+    }
+
+    // Append child to parent's children
+    ClockNode* node = &tree->nodes[parent];
+    if (node->last_child >= 0) {
+        tree->nodes[node->last_child].next_sibling = child;
+    } else {
+        node->first_child = child;
     }
+    node->last_child = child;
+    node->child_count++;
 
-    // Add child to parent's children
-    parent->children[parent->child_count++] = child;
-    
     // Set parent reference
-    child->parent = parent;
+    tree->nodes[child].parent = parent;
+    tree->flattened = 0;
+    return 0;
 }
 
-// Compute insertion delays through the clock tree
-void compute_insertion_delays(ClockTree* tree) {
-    // Recursive depth-first traversal
-    void traverse_and_compute(ClockNode* node, double parent_delay) {
-        if (!node) return;
-
-        // Compute insertion delay based on wire length and capacitance
-        // Simple model: delay = wire_length * capacitance
-        node->insertion_delay = parent_delay + (node->wire_length * node->capacitance);
-        
-        // Compute arrival time
-        if (node->parent) {
-            node->arrival_time = node->parent->arrival_time + node->insertion_delay;
-        }
+const char* clock_node_name(const ClockTree* tree, ClockNodeId node) {
+    return tree->name_pool + tree->nodes[node].name_offset;
+}
 
-        // Recursively compute for children
-        for (int i = 0; i < node->child_count; i++) {
-            traverse_and_compute(node->children[i], node->insertion_delay);
+// Flatten the tree reached from the root into preorder with an explicit
+// stack, so depth is bounded by memory rather than the call stack.
+// Children keep the order they were added in. A node reached a second
+// time (through a cycle) is skipped.
+void flatten_clock_tree(ClockTree* tree) {
+    TRACE_SCOPE("flatten_clock_tree");
+    int n = tree->node_count;
+    free(tree->order);
+    free(tree->parent_position);
+    free(tree->subtree_end);
+    free(tree->depth);
+    tree->order = malloc((n + 1) * sizeof(ClockNodeId));
+    tree->parent_position = malloc((n + 1) * sizeof(int));
+    tree->subtree_end = malloc((n + 1) * sizeof(int));
+    tree->depth = malloc((n + 1) * sizeof(int));
+    ClockNodeId* stack = malloc((n + 1) * sizeof(ClockNodeId));
+    int* stack_parent = malloc((n + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) tree->nodes[i].position = -1;
+
+    int count = 0;
+    int stack_count = 0;
+    if (tree->root >= 0) {
+        stack[stack_count] = tree->root;
+        stack_parent[stack_count++] = -1;
+    }
+    while (stack_count > 0) {
+        ClockNodeId id = stack[--stack_count];
+        int parent = stack_parent[stack_count];
+        ClockNode* node = &tree->nodes[id];
+        if (node->position >= 0) continue;
+
+        node->position = count;
+        tree->order[count] = id;
+        tree->parent_position[count] = parent;
+        tree->depth[count] = parent < 0 ? 0 : tree->depth[parent] + 1;
+        tree->subtree_end[count] = count + 1;
+        // Reversed once pushed so the first child is visited first
+        int first = stack_count;
+        for (ClockNodeId child = node->first_child; child >= 0; child = tree->nodes[child].next_sibling) {
+            if (tree->nodes[child].position >= 0) continue;
+            stack[stack_count] = child;
+            stack_parent[stack_count++] = count;
         }
+        for (int i = first, j = stack_count - 1; i < j; i++, j--) {
+            ClockNodeId swap = stack[i];
+            stack[i] = stack[j];
+            stack[j] = swap;
+        }
+        count++;
+    }
+
+    // Children follow their parent, so one backward sweep closes every range
+    for (int i = count - 1; i > 0; i--) {
+        int parent = tree->parent_position[i];
+        if (tree->subtree_end[i] > tree->subtree_end[parent]) tree->subtree_end[parent] = tree->subtree_end[i];
+    }
+
+    free(stack);
+    free(stack_parent);
+    tree->order_count = count;
+    tree->flattened = 1;
+    tree->timing_valid = 0;
+    tree->bounds_size = 0;
+}
+
+// Sources and buffers drive a new RC stage; other nodes are taps on the
+// stage that reaches them
+static int is_clock_driver(const ClockNode* node) {
+    return node->type == CLOCK_SOURCE || node->type == CLOCK_BUFFER;
+}
+
+// Capacitance a node presents at the far end of its wire: a driver
+// isolates everything below its input pin
+static double stage_load(const ClockNode* node) {
+    return is_clock_driver(node) ? node->pin_capacitance : node->downstream_capacitance;
+}
+
+// Time the signal leaves a node toward its children
+static double clock_output_time(const ClockNode* node) {
+    if (!is_clock_driver(node)) return node->arrival_time;
+    return node->arrival_time + node->intrinsic_delay + node->drive_resistance * node->downstream_capacitance;
+}
+
+// Compute insertion delays with the Elmore model of the RC tree. Each
+// wire is a pi segment, so it sees half its own capacitance plus the load
+// beyond it. A backward sweep over the preorder accumulates every node's
+// downstream capacitance from its children; a forward sweep then adds
+// each driver's intrinsic delay and drive resistance times its load, and
+// each wire's resistance times the capacitance it charges. The root keeps
+// the arrival time it was given.
+void compute_insertion_delays(ClockTree* tree) {
+    TRACE_SCOPE("compute_insertion_delays");
+    if (!tree->flattened) flatten_clock_tree(tree);
+    int n = tree->order_count;
+
+    for (int i = 0; i < n; i++) {
+        ClockNode* node = &tree->nodes[tree->order[i]];
+        node->downstream_capacitance = is_clock_driver(node) ? 0.0 : node->pin_capacitance;
+    }
+    // Children follow their parent, so each node is complete before it is added
+    for (int i = n - 1; i > 0; i--) {
+        ClockNode* node = &tree->nodes[tree->order[i]];
+        ClockNode* parent = &tree->nodes[node->parent];
+        parent->downstream_capacitance += node->wire_length * node->capacitance + stage_load(node);
+    }
+
+    double root_arrival = n > 0 ? tree->nodes[tree->order[0]].arrival_time : 0.0;
+    for (int i = 1; i < n; i++) {
+        ClockNode* node = &tree->nodes[tree->order[i]];
+        double wire_capacitance = node->wire_length * node->capacitance;
+        double wire_delay = node->wire_length * node->resistance * (0.5 * wire_capacitance + stage_load(node));
+        node->arrival_time = clock_output_time(&tree->nodes[node->parent]) + wire_delay;
+        node->insertion_delay = node->arrival_time - root_arrival;
+    }
+    if (n > 0) tree->nodes[tree->order[0]].insertion_delay = 0.0;
+    tree->timing_valid = 1;
+}
+
+static int is_clock_sink(const ClockNode* node) {
+    return node->type == CLOCK_LEAF || node->type == CLOCK_ENDPOINT;
+}
+
+// Keep pair among the SKEW_REPORT_COUNT worst local skews, largest first
+static void record_local_skew(ClockTree* tree, SkewPair pair) {
+    int count = tree->worst_local_count;
+    if (count == SKEW_REPORT_COUNT && pair.skew <= tree->worst_local[count - 1].skew) return;
+    int i = count < SKEW_REPORT_COUNT ? count++ : count - 1;
+    while (i > 0 && tree->worst_local[i - 1].skew < pair.skew) {
+        tree->worst_local[i] = tree->worst_local[i - 1];
+        i--;
     }
+    tree->worst_local[i] = pair;
+    tree->worst_local_count = count;
+}
+
+// Recompute segment tree entry k of the sink bounds from its two halves
+static void merge_sink_bounds(ClockTree* tree, int k) {
+    const ClockNode* nodes = tree->nodes;
+    ClockNodeId a = tree->earliest[2 * k], b = tree->earliest[2 * k + 1];
+    tree->earliest[k] = a < 0 || (b >= 0 && nodes[b].arrival_time < nodes[a].arrival_time) ? b : a;
+    a = tree->latest[2 * k];
+    b = tree->latest[2 * k + 1];
+    tree->latest[k] = a < 0 || (b >= 0 && nodes[b].arrival_time > nodes[a].arrival_time) ? b : a;
+}
 
-    // Start traversal from root
-    if (tree->root) {
-        traverse_and_compute(tree->root, 0.0);
+static void build_sink_bounds(ClockTree* tree) {
+    int size = 1;
+    while (size < tree->order_count) size *= 2;
+    free(tree->earliest);
+    free(tree->latest);
+    tree->earliest = malloc(2 * size * sizeof(ClockNodeId));
+    tree->latest = malloc(2 * size * sizeof(ClockNodeId));
+    for (int i = 0; i < size; i++) {
+        ClockNodeId id = i < tree->order_count ? tree->order[i] : -1;
+        tree->earliest[size + i] = tree->latest[size + i] = id >= 0 && is_clock_sink(&tree->nodes[id]) ? id : -1;
     }
+    tree->bounds_size = size;
+    for (int k = size - 1; k > 0; k--) merge_sink_bounds(tree, k);
 }
 
-// Compute clock skew between nodes
+// Compute clock skew in linear time. A backward sweep over the preorder
+// reduces the earliest and latest sink arrival of every subtree from its
+// children's, giving each node's subtree skew and, at the root, the global
+// skew. A forward sweep then takes each node's sibling skew and local skew
+// from one min/max pass over its children.
 void compute_clock_skew(ClockTree* tree) {
-    // Compute skew between sibling nodes
-    void compute_sibling_skew(ClockNode* node) {
-        if (!node || node->child_count <= 1) return;
-
-        // Compare arrival times of sibling nodes
-        for (int i = 0; i < node->child_count; i++) {
-            for (int j = i + 1; j < node->child_count; j++) {
-                node->children[i]->skew_to_siblings = 
-                    fabs(node->children[i]->arrival_time - 
-                         node->children[j]->arrival_time);
-            }
+    TRACE_SCOPE("compute_clock_skew");
+    if (!tree->flattened) flatten_clock_tree(tree);
+    int n = tree->order_count;
+    ClockNode* nodes = tree->nodes;
+    tree->global_skew = (SkewPair){-1, -1, 0.0};
+    tree->worst_local_count = 0;
+    if (n == 0) return;
+
+    // Earliest and latest sink in each subtree, -1 if it has none
+    ClockNodeId* early = malloc(n * sizeof(ClockNodeId));
+    ClockNodeId* late = malloc(n * sizeof(ClockNodeId));
+    for (int i = 0; i < n; i++) {
+        early[i] = late[i] = is_clock_sink(&nodes[tree->order[i]]) ? tree->order[i] : -1;
+    }
+    for (int i = n - 1; i >= 0; i--) {
+        ClockNode* node = &nodes[tree->order[i]];
+        node->subtree_skew = early[i] >= 0 ? nodes[late[i]].arrival_time - nodes[early[i]].arrival_time : 0.0;
+        int parent = tree->parent_position[i];
+        if (parent < 0 || early[i] < 0) continue;
+        if (early[parent] < 0 || nodes[early[i]].arrival_time < nodes[early[parent]].arrival_time) early[parent] = early[i];
+        if (late[parent] < 0 || nodes[late[i]].arrival_time > nodes[late[parent]].arrival_time) late[parent] = late[i];
+    }
+    build_sink_bounds(tree);
+    if (early[0] >= 0) tree->global_skew = (SkewPair){early[0], late[0], nodes[tree->order[0]].subtree_skew};
+    double reference_time = early[0] >= 0 ? nodes[early[0]].arrival_time : 0.0;
+
+    for (int i = 0; i < n; i++) {
+        ClockNode* node = &nodes[tree->order[i]];
+        if (is_clock_sink(node)) node->skew_to_endpoints = node->arrival_time - reference_time;
+        if (node->child_count == 0) continue;
+
+        double first = DBL_MAX, last = -DBL_MAX;
+        ClockNodeId early_sink = -1;
+        ClockNodeId late_sink = -1;
+        for (ClockNodeId c = node->first_child; c >= 0; c = nodes[c].next_sibling) {
+            double arrival = nodes[c].arrival_time;
+            if (arrival < first) first = arrival;
+            if (arrival > last) last = arrival;
+            if (!is_clock_sink(&nodes[c])) continue;
+            if (early_sink < 0 || arrival < nodes[early_sink].arrival_time) early_sink = c;
+            if (late_sink < 0 || arrival > nodes[late_sink].arrival_time) late_sink = c;
         }
-
-        // Recursively compute for children
-        for (int i = 0; i < node->child_count; i++) {
-            compute_sibling_skew(node->children[i]);
+        for (ClockNodeId c = node->first_child; c >= 0; c = nodes[c].next_sibling) {
+            double arrival = nodes[c].arrival_time;
+            nodes[c].skew_to_siblings = fmax(arrival - first, last - arrival);
+        }
+        if (early_sink != late_sink) {
+            double skew = nodes[late_sink].arrival_time - nodes[early_sink].arrival_time;
+            record_local_skew(tree, (SkewPair){early_sink, late_sink, skew});
         }
     }
+    free(early);
+    free(late);
+}
 
-    // Compute skew to endpoints
-    void compute_endpoint_skew(ClockNode* node, double reference_time) {
-        if (!node) return;
+// Recompute a node's downstream capacitance from its children
+static void sum_downstream_capacitance(ClockTree* tree, ClockNode* node) {
+    double load = is_clock_driver(node) ? 0.0 : node->pin_capacitance;
+    for (ClockNodeId c = node->first_child; c >= 0; c = tree->nodes[c].next_sibling) {
+        const ClockNode* child = &tree->nodes[c];
+        load += child->wire_length * child->capacitance + stage_load(child);
+    }
+    node->downstream_capacitance = load;
+}
 
-        // If it's a leaf or endpoint, compute skew from reference
-        if (node->type == CLOCK_LEAF || node->type == CLOCK_ENDPOINT) {
-            node->skew_to_endpoints = fabs(node->arrival_time - reference_time);
-        }
+// Re-time the tree after the parameters of one node changed. A change
+// below a driver reaches no further up than that driver, whose input pin
+// isolates the stage above, so downstream capacitance is re-summed from
+// the node up to the first driver above it, and only that driver's subtree,
+// one contiguous preorder range, is re-timed. The sink bounds are patched
+// over the same range, keeping the global skew current in time
+// proportional to the range plus log n. Per-node skew fields and the
+// worst local pairs are left for the next compute_clock_skew(). A tree
+// not yet timed, or changed in shape, is timed in full instead.
+void update_clock_timing(ClockTree* tree, ClockNodeId id) {
+    TRACE_SCOPE("update_clock_timing");
+    if (!tree->flattened || !tree->timing_valid || tree->bounds_size == 0) {
+        compute_insertion_delays(tree);
+        compute_clock_skew(tree);
+        return;
+    }
+    ClockNode* nodes = tree->nodes;
+    if (nodes[id].position < 0) return;   // Not reached from the root
+
+    ClockNodeId stage = id;
+    sum_downstream_capacitance(tree, &nodes[id]);
+    while (nodes[stage].parent >= 0) {
+        stage = nodes[stage].parent;
+        sum_downstream_capacitance(tree, &nodes[stage]);
+        if (is_clock_driver(&nodes[stage])) break;
+    }
 
-        // Recursively compute for children
-        for (int i = 0; i < node->child_count; i++) {
-            compute_endpoint_skew(node->children[i], reference_time);
-        }
+    int first = nodes[stage].position + 1;
+    int end = tree->subtree_end[nodes[stage].position];
+    double root_arrival = nodes[tree->order[0]].arrival_time;
+    for (int i = first; i < end; i++) {
+        ClockNode* node = &nodes[tree->order[i]];
+        double wire_capacitance = node->wire_length * node->capacitance;
+        double wire_delay = node->wire_length * node->resistance * (0.5 * wire_capacitance + stage_load(node));
+        node->arrival_time = clock_output_time(&nodes[node->parent]) + wire_delay;
+        node->insertion_delay = node->arrival_time - root_arrival;
+    }
+
+    // Entries over the re-timed leaves, level by level up to the root
+    int low = tree->bounds_size + first, high = tree->bounds_size + end - 1;
+    while (low > 1) {
+        low /= 2;
+        high /= 2;
+        for (int k = low; k <= high; k++) merge_sink_bounds(tree, k);
     }
+    ClockNodeId early = tree->earliest[1], late = tree->latest[1];
+    tree->global_skew = (SkewPair){early, late, early >= 0 ? nodes[late].arrival_time - nodes[early].arrival_time : 0.0};
+}
+
+// Change the length of the wire driving a node and re-time
+void set_clock_wire_length(ClockTree* tree, ClockNodeId node, double wire_length) {
+    tree->nodes[node].wire_length = wire_length;
+    update_clock_timing(tree, node);
+}
 
-    // Perform skew computations
-    if (tree->root) {
-        compute_sibling_skew(tree->root);
-        compute_endpoint_skew(tree->root, tree->root->arrival_time);
+// Swap a buffer for one of another size and re-time
+void resize_clock_buffer(ClockTree* tree, ClockNodeId node, double drive_resistance, double intrinsic_delay,
+                         double pin_capacitance) {
+    ClockNode* buffer = &tree->nodes[node];
+    buffer->drive_resistance = drive_resistance;
+    buffer->intrinsic_delay = intrinsic_delay;
+    buffer->pin_capacitance = pin_capacitance;
+    update_clock_timing(tree, node);
+}
+
+// Print the global skew and the worst local skew pairs
+void print_clock_skew(const ClockTree* tree) {
+    const SkewPair* global = &tree->global_skew;
+    if (global->early >= 0) {
+        printf("Global Skew: %.3f ns (%s at %.3f ns, %s at %.3f ns)\n", global->skew,
+               clock_node_name(tree, global->early), tree->nodes[global->early].arrival_time,
+               clock_node_name(tree, global->late), tree->nodes[global->late].arrival_time);
+    }
+    if (tree->worst_local_count > 0) {
+        printf("Worst Local Skew (sinks sharing a driver):\n");
+        for (int i = 0; i < tree->worst_local_count; i++) {
+            const SkewPair* pair = &tree->worst_local[i];
+            printf("  %.3f ns  %s -> %s (driven by %s)\n", pair->skew, clock_node_name(tree, pair->early),
+                   clock_node_name(tree, pair->late), clock_node_name(tree, tree->nodes[pair->early].parent));
+        }
     }
 }
 
 // Print clock tree analysis results
 void print_clock_tree_analysis(ClockTree* tree) {
+    TRACE_SCOPE("print_clock_tree_analysis");
     printf("Clock Tree Analysis Results:\n");
     printf("---------------------------\n");
+    if (!tree->flattened) flatten_clock_tree(tree);
 
-    // Recursive printing function
-    void print_node(ClockNode* node, int depth) {
-        if (!node) return;
+    for (int position = 0; position < tree->order_count; position++) {
+        const ClockNode* node = &tree->nodes[tree->order[position]];
+        int depth = tree->depth[position];
 
         // Indent based on depth
         for (int i = 0; i < depth; i++) printf("  ");
 
-        printf("Node: %s\n", node->name);
-        
+        printf("Node: %s\n", clock_node_name(tree, tree->order[position]));
+
         // Indent and print details
         for (int i = 0; i < depth + 1; i++) printf("  ");
         printf("Type: %d\n", node->type);
-        
+
         for (int i = 0; i < depth + 1; i++) printf("  ");
         printf("Arrival Time: %.3f ns\n", node->arrival_time);
-        
+
         for (int i = 0; i < depth + 1; i++) printf("  ");
         printf("Insertion Delay: %.3f ns\n", node->insertion_delay);
-        
+
+        for (int i = 0; i < depth + 1; i++) printf("  ");
+        printf("Downstream Capacitance: %.4f pF\n", node->downstream_capacitance);
+
         for (int i = 0; i < depth + 1; i++) printf("  ");
         printf("Sibling Skew: %.3f ns\n", node->skew_to_siblings);
-        
+
         for (int i = 0; i < depth + 1; i++) printf("  ");
         printf("Endpoint Skew: %.3f ns\n", node->skew_to_endpoints);
 
-        // Recursively print children
-        for (int i = 0; i < node->child_count; i++) {
-            print_node(node->children[i], depth + 1);
-        }
+        for (int i = 0; i < depth + 1; i++) printf("  ");
+        printf("Subtree Skew: %.3f ns\n", node->subtree_skew);
     }
 
-    // Start printing from root
-    if (tree->root) {
-        print_node(tree->root, 0);
+    printf("\n");
+    print_clock_skew(tree);
+}
+
+static double elapsed_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Build a balanced buffer tree of the given fanout over sink_count sinks
+// and time each analysis pass. The tree is reserved up front, so the
+// build itself should make no allocations at all. Wires double in length
+// at each level up, with a random spread so sink arrivals differ. Then
+// time BENCH_EDITS random wire and buffer edits with update_clock_timing()
+// and check the result against a full re-time.
+static double bench_wire_length(int level) {
+    return BENCH_WIRE_LENGTH * (double)(1LL << (level < 20 ? level : 20));
+}
+
+int run_clock_tree_benchmark(int sink_count, int fanout) {
+    // Level sizes from the sinks up to a single top buffer
+    int level_size[64];
+    int level_count = 0;
+    long long node_count = 1;
+    for (int size = sink_count; ; size = (size + fanout - 1) / fanout) {
+        level_size[level_count++] = size;
+        node_count += size;
+        if (size == 1) break;
     }
+    if (node_count > INT_MAX) {
+        fprintf(stderr, "Clock tree benchmark too large\n");
+        return 1;
+    }
+
+    double start = elapsed_seconds();
+    ClockTree* tree = create_clock_tree();
+    reserve_clock_tree(tree, (int)node_count, (size_t)node_count * 16);
+    unsigned long long allocations = trace_state.allocations;
+    srand(1);
+    char name[32];
+    ClockNodeId source = create_clock_node(tree, "CLK_SRC", CLOCK_SOURCE);
+    tree->nodes[source].drive_resistance = 0.05;
+
+    // Levels from the top down; node j of a level hangs off node j / fanout
+    // of the level above, which is the contiguous id range just created
+    ClockNodeId above = source;
+    for (int level = level_count - 1; level >= 0; level--) {
+        ClockNodeId first = tree->node_count;
+        double length = bench_wire_length(level);
+        for (int j = 0; j < level_size[level]; j++) {
+            int sink = level == 0;
+            if (sink) {
+                snprintf(name, sizeof(name), "FF%d", j);
+            } else {
+                snprintf(name, sizeof(name), "BUF%d_%d", level, j);
+            }
+            ClockNodeId id = create_clock_node(tree, name, sink ? CLOCK_ENDPOINT : CLOCK_BUFFER);
+            ClockNode* node = &tree->nodes[id];
+            node->wire_length = length * (0.5 + rand() / (double)RAND_MAX);
+            node->resistance = 0.002;
+            node->capacitance = 0.0002;
+            node->pin_capacitance = sink ? 0.002 : 0.005;
+            if (!sink) {
+                node->drive_resistance = 0.2;
+                node->intrinsic_delay = 0.03;
+            }
+            add_clock_node(tree, above + j / fanout, id);
+        }
+        above = first;
+    }
+    allocations = trace_state.allocations - allocations;
+    double build_time = elapsed_seconds() - start;
+
+    start = elapsed_seconds();
+    flatten_clock_tree(tree);
+    double flatten_time = elapsed_seconds() - start;
+    start = elapsed_seconds();
+    compute_insertion_delays(tree);
+    double delay_time = elapsed_seconds() - start;
+    start = elapsed_seconds();
+    compute_clock_skew(tree);
+    double skew_time = elapsed_seconds() - start;
+
+    start = elapsed_seconds();
+    // Draw new values from the ranges the tree was built with, so edits
+    // do not compound on one another
+    for (int i = 0; i < BENCH_EDITS; i++) {
+        ClockNodeId id = 1 + rand() % (tree->node_count - 1);
+        double scale = 0.5 + rand() / (double)RAND_MAX;
+        if (tree->nodes[id].type == CLOCK_BUFFER && rand() % 2) {
+            resize_clock_buffer(tree, id, 0.2 * scale, 0.03 * scale, 0.005 * scale);
+        } else {
+            int level = level_count - tree->depth[tree->nodes[id].position];
+            set_clock_wire_length(tree, id, bench_wire_length(level) * scale);
+        }
+    }
+    double edit_time = (elapsed_seconds() - start) / BENCH_EDITS;
+
+    // Cross-check against a from-scratch analysis
+    SkewPair incremental_skew = tree->global_skew;
+    double* arrival = malloc(tree->node_count * sizeof(double));
+    for (int i = 0; i < tree->node_count; i++) arrival[i] = tree->nodes[i].arrival_time;
+    compute_insertion_delays(tree);
+    compute_clock_skew(tree);
+    double worst_difference = fabs(incremental_skew.skew - tree->global_skew.skew);
+    for (int i = 0; i < tree->node_count; i++) {
+        worst_difference = fmax(worst_difference, fabs(arrival[i] - tree->nodes[i].arrival_time));
+    }
+    free(arrival);
+
+    printf("Clock Tree Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Sinks: %d  Fanout: %d  Levels: %d\n", tree->node_count, sink_count, fanout, level_count + 1);
+    printf("Build:     %.3f ms (%llu allocation(s) after reserving)\n", build_time * 1e3, allocations);
+    printf("Flatten:   %.3f ms\n", flatten_time * 1e3);
+    printf("Delays:    %.3f ms\n", delay_time * 1e3);
+    printf("Skew:      %.3f ms\n", skew_time * 1e3);
+    printf("Edit:      %.3f us (average of %d, %.0f edits/s)\n", edit_time * 1e6, BENCH_EDITS, 1.0 / edit_time);
+    printf("Largest difference from a full re-time: %.3g ns\n", worst_difference);
+    print_clock_skew(tree);
+
+    free_clock_tree(tree);
+    return worst_difference < 1e-9 ? 0 : 1;
 }
 
 // Example usage
-int main() {
+int main(int argc, char** argv) {
+    // Optional phase trace: --trace FILE [--trace-counters]
+    const char* trace_path = NULL;
+    int trace_counters = 0;
+    int bench_sinks = 0;
+    int bench_fanout = BENCH_DEFAULT_FANOUT;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace-counters") == 0) {
+            trace_counters = 1;
+        } else if (strcmp(argv[i], "--bench-sinks") == 0 && i + 1 < argc) {
+            bench_sinks = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-fanout") == 0 && i + 1 < argc) {
+            bench_fanout = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--trace FILE] [--trace-counters]\n"
+                    "       [--bench-sinks SINKS] [--bench-fanout FANOUT]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (trace_path) {
+        if (trace_start(trace_path, trace_counters) != 0) return 1;
+        atexit(trace_stop);
+    }
+    if (bench_sinks > 0) {
+        if (bench_fanout < 2) {
+            fprintf(stderr, "--bench-fanout must be at least 2\n");
+            return 1;
+        }
+        return run_clock_tree_benchmark(bench_sinks, bench_fanout);
+    }
+
     // Create clock tree
     ClockTree* clock_tree = create_clock_tree();
+    ClockNode* node;
 
     // Create clock tree nodes
-    ClockNode* clock_source = create_clock_node(clock_tree, "CLK_SRC", CLOCK_SOURCE);
-    clock_source->arrival_time = 0.0;
-    
+    ClockNodeId clock_source = create_clock_node(clock_tree, "CLK_SRC", CLOCK_SOURCE);
+    node = &clock_tree->nodes[clock_source];
+    node->arrival_time = 0.0;
+    node->drive_resistance = 0.05;
+
     // Level 1 buffers
-    ClockNode* buffer1 = create_clock_node(clock_tree, "CLK_BUF1", CLOCK_BUFFER);
-    buffer1->wire_length = 10.0;
-    buffer1->capacitance = 0.5;
-    
-    ClockNode* buffer2 = create_clock_node(clock_tree, "CLK_BUF2", CLOCK_BUFFER);
-    buffer2->wire_length = 12.0;
-    buffer2->capacitance = 0.6;
+    ClockNodeId buffer1 = create_clock_node(clock_tree, "CLK_BUF1", CLOCK_BUFFER);
+    node = &clock_tree->nodes[buffer1];
+    node->wire_length = 400.0;
+    node->pin_capacitance = 0.005;
+    node->drive_resistance = 0.2;
+    node->intrinsic_delay = 0.03;
+
+    ClockNodeId buffer2 = create_clock_node(clock_tree, "CLK_BUF2", CLOCK_BUFFER);
+    node = &clock_tree->nodes[buffer2];
+    node->wire_length = 600.0;
+    node->pin_capacitance = 0.005;
+    node->drive_resistance = 0.2;
+    node->intrinsic_delay = 0.03;
 
     // Add nodes to tree
     add_clock_node(clock_tree, clock_source, buffer1);
     add_clock_node(clock_tree, clock_source, buffer2);
 
     // Level 2 endpoints
-    ClockNode* endpoint1 = create_clock_node(clock_tree, "CLK_EP1", CLOCK_ENDPOINT);
-    endpoint1->wire_length = 5.0;
-    endpoint1->capacitance = 0.3;
-    
-    ClockNode* endpoint2 = create_clock_node(clock_tree, "CLK_EP2", CLOCK_ENDPOINT);
-    endpoint2->wire_length = 7.0;
-    endpoint2->capacitance = 0.4;
+    ClockNodeId endpoint1 = create_clock_node(clock_tree, "CLK_EP1", CLOCK_ENDPOINT);
+    node = &clock_tree->nodes[endpoint1];
+    node->wire_length = 150.0;
+    node->pin_capacitance = 0.002;
+
+    ClockNodeId endpoint2 = create_clock_node(clock_tree, "CLK_EP2", CLOCK_ENDPOINT);
+    node = &clock_tree->nodes[endpoint2];
+    node->wire_length = 220.0;
+    node->pin_capacitance = 0.002;
+
+    ClockNodeId endpoint3 = create_clock_node(clock_tree, "CLK_EP3", CLOCK_ENDPOINT);
+    node = &clock_tree->nodes[endpoint3];
+    node->wire_length = 180.0;
+    node->pin_capacitance = 0.002;
+
+    // Every wire on one layer: 2 ohms and 0.2 fF per um
+    for (int i = 0; i < clock_tree->node_count; i++) {
+        clock_tree->nodes[i].resistance = 0.002;
+        clock_tree->nodes[i].capacitance = 0.0002;
+    }
 
     // Add endpoints to buffers
     add_clock_node(clock_tree, buffer1, endpoint1);
+    add_clock_node(clock_tree, buffer1, endpoint3);
     add_clock_node(clock_tree, buffer2, endpoint2);
 
     // Perform clock tree analysis
@@ -264,5 +830,6 @@ int main() {
     // Print analysis results
     print_clock_tree_analysis(clock_tree);
 
+    free_clock_tree(clock_tree);
     return 0;
 }
@@ -2,6 +2,8 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "../trace.h"
+
 #define MAX_NAME_LENGTH 100
 #define MAX_MODULES 1000
 #define MAX_INSTANCES 1000
@@ -111,12 +113,14 @@ void connect_port(const char* instance_name, const char* port_name, const char*
 
 // Flatten the netlist starting from the top module
 void flatten_netlist(const char* top_module_name) {
+    TRACE_SCOPE("flatten_netlist");
     printf("Flattening Netlist from Top Module: %s\n", top_module_name);
     printf("-----------------------------------\n");
 }
 
 // Print the flattened netlist
 void print_flattened_netlist() {
+    TRACE_SCOPE("print_flattened_netlist");
     printf("\nFlattened Netlist:\n");
     printf("------------------\n");
     
@@ -146,7 +150,25 @@ void print_flattened_netlist() {
     }
 }
 
-int main() {
+int main(int argc, char** argv) {
+    // Optional phase trace: --trace FILE [--trace-counters]
+    const char* trace_path = NULL;
+    int trace_counters = 0;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace-counters") == 0) {
+            trace_counters = 1;
+        } else {
+            fprintf(stderr, "Usage: %s [--trace FILE] [--trace-counters]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (trace_path) {
+        if (trace_start(trace_path, trace_counters) != 0) return 1;
+        atexit(trace_stop);
+    }
+
     // Example usage of Netlist Flattener
     
     // Define modules
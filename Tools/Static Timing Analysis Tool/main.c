@@ -1,11 +1,74 @@
+// Build: gcc -O2 -pthread main.c -o sta -lm
+
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <float.h>
 #include <limits.h>
+#include <math.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/resource.h>
+
+#include "../trace.h"
 
-#define MAX_NODES 1000
-#define MAX_NAME_LENGTH 50
+#define ARENA_BLOCK_SIZE (1 << 20)
+#define EDGE_CHUNK_SIZE 4096
+#define INITIAL_NODE_CAPACITY 1024
+#define PARALLEL_MIN_LEVEL_WIDTH 4096
+#define BENCH_INCREMENTAL_EDITS 1000
+#define MAX_TABLE_INDEX 16
+#define DELAY_BATCH_SIZE 1024
+#define DELAY_BATCH_PAD 8
+#define CELL_TABLE_COUNT 4           // cell_rise, cell_fall, rise/fall_transition
+#define DEFAULT_INPUT_SLEW 0.02      // ns, transition at primary inputs
+#define OUTPUT_PORT_LOAD 0.005       // pF, load presented by a primary output
+#define WIRE_LOAD_PER_FANOUT 0.001   // pF, wire capacitance added per fan-out
+#define SNAPSHOT_MAGIC "STAGRAPH"
+#define SNAPSHOT_VERSION 4
+#define SNAPSHOT_ALIGN 64            // Section alignment within a snapshot file
+#define MAX_CORNERS 8                // Corner lanes stored per node (one 64-byte line)
+#define MAX_CORNER_NAME 32
+#define DEFAULT_SETUP_TIME 0.1       // ns, flip-flop setup time without a library
+#define DEFAULT_HOLD_TIME 0.05       // ns, flip-flop hold time without a library
+#define MAX_SDC_WORDS 64
+#define EXCEPTION_TAG_LANES 8        // Differently tagged arrivals kept per node
+#define BENCH_CORNER_RUNS 5
+#define DEFAULT_DELAY_SIGMA 0.05     // Gate delay standard deviation, relative to nominal
+#define MC_BATCH 32                  // Monte Carlo samples timed per propagation
+#define MC_NORMAL_TABLE_SIZE (1 << 18)
+#define MC_DEFAULT_SEED 1
+#define BENCH_MC_SAMPLES 1024
+#define PBA_DEFAULT_PATHS 16         // Paths re-timed per endpoint
+#define PBA_CHUNK 64                 // Sorted paths a worker re-times at a time
+#define BENCH_PBA_ENDPOINTS 1000
+#define OUT_OF_CORE_DEFAULT_BUDGET_MB 256
+#define OUT_OF_CORE_MIN_BUDGET (1 << 20)
+#define OUT_OF_CORE_CHUNK_SHARE 8    // Budget fraction per chunk; buffers and values take about half
+#define RECORD_LAUNCH 0xff           // Partition record type of a flip-flop's launch
+#define BENCH_OOC_REGISTER_STRIDE 50 // Every Nth benchmark gate becomes a flip-flop
+#define LOOP_REPORT_LIMIT 10         // Loops described one by one
+#define LOOP_REPORT_NAMES 8          // Members and cut arcs named per loop
+#define BENCH_LOOP_COUNT 100
+#define BENCH_LOOP_DEPTH 4           // Fan-in steps a benchmark loop reaches back
+#define BENCH_SUITE_MIN_GATES 1000
+#define BENCH_SUITE_WORK 2000000     // Nodes timed per suite size before keeping the best run
+#define BENCH_DEFAULT_DEPTH 50
+#define BENCH_FANIN_SPAN 4           // Levels a synthetic gate's later fan-ins reach back
+#define REPORT_BUFFER_SIZE (1 << 20)
+#define REPORT_MAGIC "STAREPRT"
+#define REPORT_VERSION 1
+#define REPORT_DEFAULT_WORST 10      // Endpoints listed by default, worst first
+#define REPORT_HISTOGRAM_BINS 10
+#define REPORT_BAR_WIDTH 40
+#define REPORT_TEXT_DECIMALS 3
+#define REPORT_DATA_DECIMALS 6       // CSV and JSON
 
 // Enum for gate types
 typedef enum {
@@ -16,187 +79,7647 @@ typedef enum {
     GATE_NOR,
     GATE_XOR,
     INPUT,
-    OUTPUT
+    OUTPUT,
+    GATE_DFF                 // Edge-triggered flip-flop on an ideal clock
 } GateType;
 
-// Node structure representing circuit elements
-typedef struct Node {
-    char name[MAX_NAME_LENGTH];
+// Signal transitions at a node. Rise/fall quantities are paired arrays
+// indexed by transition, e.g. arrival_time[TRANSITION_FALL][node].
+enum {
+    TRANSITION_RISE,
+    TRANSITION_FALL,
+    TRANSITION_COUNT
+};
+
+// How a gate's output transition follows its input transition
+enum {
+    UNATE_POSITIVE,          // Rise in, rise out
+    UNATE_NEGATIVE,          // Rise in, fall out
+    UNATE_NON                // Either input transition can cause either output
+};
+
+static const unsigned char gate_unateness[GATE_DFF + 1] = {
+    [GATE_AND] = UNATE_POSITIVE, [GATE_OR] = UNATE_POSITIVE, [GATE_NOT] = UNATE_NEGATIVE,
+    [GATE_NAND] = UNATE_NEGATIVE, [GATE_NOR] = UNATE_NEGATIVE, [GATE_XOR] = UNATE_NON,
+    [INPUT] = UNATE_POSITIVE, [OUTPUT] = UNATE_POSITIVE, [GATE_DFF] = UNATE_NON
+};
+
+// Nodes are referenced by index; every per-node attribute lives in its own
+// contiguous array inside the circuit (structure of arrays).
+typedef int NodeId;
+
+// Growable list of node indices
+typedef struct {
+    NodeId* items;
+    int count;
+    int capacity;
+} NodeList;
+
+// Bump allocator: memory is carved out of large blocks and given back all
+// at once, so building the graph never needs a malloc per node or edge.
+typedef struct ArenaBlock {
+    struct ArenaBlock* next;
+    size_t size;
+    size_t used;
+    max_align_t data[];
+} ArenaBlock;
+
+typedef struct {
+    ArenaBlock* first;
+    ArenaBlock* current;
+    size_t bytes_reserved;
+} Arena;
+
+// Connections are appended to fixed-size chunks taken from the arena
+typedef struct EdgeChunk {
+    struct EdgeChunk* next;
+    int count;
+    NodeId source[EDGE_CHUNK_SIZE];
+    NodeId destination[EDGE_CHUNK_SIZE];
+    unsigned char disabled[EDGE_CHUNK_SIZE];   // Left out of the timing graph
+} EdgeChunk;
+
+// 2-D NLDM lookup table indexed by input slew (rows) and output load
+// (columns). Tables with a single index have a count of 1 on that axis.
+typedef struct {
+    int slew_count;
+    int load_count;
+    double slew_index[MAX_TABLE_INDEX];
+    double load_index[MAX_TABLE_INDEX];
+    double values[MAX_TABLE_INDEX * MAX_TABLE_INDEX];
+} DelayTable;
+
+// Timing view of one library cell: the worst arc of its output pin
+typedef struct {
+    char* name;
     GateType type;
-    double delay;
-    double arrival_time;
-    double required_time;
-    double slack;
-    struct Node* inputs[4];  // Support up to 4 inputs
     int input_count;
-    struct Node* outputs[4]; // Support up to 4 outputs
-    int output_count;
-} Node;
+    double input_capacitance;  // Largest input pin capacitance
+    DelayTable cell_rise;
+    DelayTable cell_fall;
+    DelayTable rise_transition;
+    DelayTable fall_transition;
+    int shared_index;          // All four tables use the same indices
+    const char* output_pin;    // Name of the output pin
+    double setup_time;         // Worst setup constraint (flip-flops only)
+    double hold_time;          // Worst hold constraint (flip-flops only)
+} LibertyCell;
+
+// Cells loaded from a Liberty file, with the cell chosen for each gate type
+typedef struct {
+    Arena arena;
+    LibertyCell* cells;
+    int cell_count;
+    int cell_for_type[GATE_DFF + 1];   // Index into cells, or -1
+} CellLibrary;
+
+// One analysis corner: a delay derate applied on top of either the
+// circuit's own delays or delays calculated from a corner library
+typedef struct {
+    char name[MAX_CORNER_NAME];
+    double derate;
+    CellLibrary* library;      // Optional; not owned by the circuit
+} Corner;
+
+// Timing exceptions, in order of precedence when several match a path
+typedef enum {
+    EXCEPTION_FALSE_PATH,
+    EXCEPTION_MAX_DELAY,
+    EXCEPTION_MULTICYCLE
+} ExceptionType;
+
+// One set_false_path, set_max_delay or set_multicycle_path. A path matches
+// when it starts in from, passes each through list in order and ends in
+// to; an empty from or to list matches any startpoint or endpoint. Its
+// tag bits are first_bit (from matched) up to first_bit + through_count
+// (every through list matched).
+typedef struct {
+    ExceptionType type;
+    double value;            // ns for set_max_delay, cycles for set_multicycle_path
+    NodeId* from;
+    int from_count;
+    NodeId* to;
+    int to_count;
+    NodeId* through;         // List g is through[through_start[g] .. through_start[g + 1] - 1]
+    int* through_start;
+    int through_count;
+    int first_bit;
+} TimingException;
+
+// Tag bits per node, ascending: node i's are bit[start[i] .. start[i + 1] - 1]
+typedef struct {
+    int* start;
+    int* bit;
+} ExceptionBits;
 
 // Graph structure for the entire circuit
 typedef struct {
-    Node* nodes[MAX_NODES];
     int node_count;
+    int node_capacity;
+
+    // Per-node attributes, grown geometrically as nodes are added
+    // Delays are per output transition; arrival and required times are per
+    // transition at the node's inputs. Slack is the worse of the two.
+    unsigned char* type;
+    double* delay[TRANSITION_COUNT];
+    double* arrival_time[TRANSITION_COUNT];
+    double* required_time[TRANSITION_COUNT];
+    double* early_arrival[TRANSITION_COUNT];  // Earliest arrival, for hold checks
+    double* slack;
+    double* port_delay;      // External input/output delay of a port
+    int* level;
+
+    // Names are kept out of the hot arrays in a packed string table
+    size_t* name_offset;
+    char* name_pool;
+    size_t name_pool_size;
+    size_t name_pool_capacity;
+
+    // Connections in the order they were added (unbounded fan-in/fan-out)
+    Arena edge_arena;
+    EdgeChunk* edges_head;
+    EdgeChunk* edges_tail;
+    int edge_count;
+
+    // Compressed sparse row adjacency built from the edge list.
+    // Fan-in of node i is fanin[fanin_start[i] .. fanin_start[i + 1] - 1].
+    // These arrays and the schedule below live in graph_arena, which is
+    // reset and reused every time the graph is rebuilt.
+    Arena graph_arena;
+    int* fanin_start;
+    NodeId* fanin;
+    int* fanout_start;
+    NodeId* fanout;
+    NodeId* endpoints;       // OUTPUT and flip-flop nodes in index order
+    int endpoint_count;
+    int graph_built;         // Cleared whenever the graph changes
+
+    // Connections left out of the CSR: disabled by set_disable_timing or
+    // cut to break a combinational loop. Their sinks still load the
+    // driving net.
+    NodeId* disabled_source;
+    NodeId* disabled_destination;
+    int disabled_count;
+    int loop_count;          // Combinational loops found and cut so far
+
+    // Levelized schedule: nodes sorted by topological level. Edges out of
+    // a flip-flop do not order it: its output launches on the clock, so
+    // register-to-register paths are timed as separate segments.
+    // Level l occupies level_order[level_start[l] .. level_start[l + 1] - 1].
+    NodeId* level_order;
+    int* level_start;
+    int level_count;
+    int levelized;           // Cleared whenever the graph changes
+
+    // Worker threads used by arrival/required propagation (1 = serial)
+    int thread_count;
+
+    // Optional cell library. When set, compute_delays() replaces the fixed
+    // per-type delays with NLDM lookups on each node's slew and load.
+    CellLibrary* library;
+    double* load;            // Output load per node (pF)
+    double* slew;            // Output transition per node (ns)
+
+    // Incremental timing state. Edits made after a full analysis queue the
+    // affected nodes here and update_timing() re-times only their cones.
+    int timing_valid;        // Set once arrival/required/slack are current
+    unsigned char* queued;   // Per-node scratch flag used by update_timing
+    NodeList arrival_dirty;  // Nodes whose arrival must be re-evaluated
+    NodeList required_dirty; // Nodes whose required time must be re-evaluated
+    double required_reference;  // Required time of every endpoint before its margin
+
+    // Clock constraint. With a period every path ends at period - margin,
+    // where the margin is an OUTPUT's external delay or a flip-flop's setup
+    // time; without one the worst endpoint defines the reference.
+    double clock_period;     // 0 = unconstrained
+    double setup_time;
+    double hold_time;
+
+    // Snapshot file the graph was loaded from. While mapped, the structure
+    // arrays (type, delay, level, names, CSR and schedule) point into this
+    // private copy-on-write mapping; the first structural edit copies them
+    // to the heap and unmaps the file.
+    void* snapshot;
+    size_t snapshot_size;
+
+    // Multi-corner timing. Corner c of node i lives at [i * MAX_CORNERS + c],
+    // so one node's corners share a cache line and every per-node step
+    // runs across all corner lanes at once. Unused lanes are kept at zero.
+    Corner corners[MAX_CORNERS];
+    int corner_count;
+    int corner_capacity;     // Nodes the corner arrays are sized for
+    double* corner_delay[TRANSITION_COUNT];
+    double* corner_arrival[TRANSITION_COUNT];
+    double* corner_required[TRANSITION_COUNT];
+    double* corner_slack;
+    double corner_reference[MAX_CORNERS];  // Per-corner required_reference
+
+    // Statistical timing. Each gate delay is normal around its nominal value
+    // with standard deviation delay_sigma times that value. Monte Carlo
+    // samples are timed MC_BATCH at a time: sample k of node i lives at
+    // [i * MC_BATCH + k], holding the time the node's output transitions.
+    // Lanes are single precision so twice as many fit in a vector.
+    double* delay_sigma;
+    int sample_capacity;     // Nodes the sample arrays are sized for
+    float* sample_output[TRANSITION_COUNT];
+    float* sample_normal;    // Table of standard normal variates
+    uint64_t sample_seed;    // Selects the variates of the current batch
+
+    // Timing exceptions. A path's tag is a bitset of tag_words words with a
+    // bit for every exception stage it has reached, and arrivals with
+    // different tags are kept apart in up to EXCEPTION_TAG_LANES lanes per
+    // node at [i * EXCEPTION_TAG_LANES + k], so one forward pass honors
+    // every exception. arrival_time is then the latest lane that is not a
+    // false path. Lane k's tag is at tag_words * (i * (EXCEPTION_TAG_LANES
+    // + 1) + k); the extra lane holds the tag being merged in.
+    TimingException* exceptions;
+    int exception_count;
+    int exception_bits;      // Tag bits in use
+    int exception_nodes;     // Nodes the lists and lanes below are built for
+    int tag_words;
+    ExceptionBits exception_start;     // Stage-0 bits a node sets as a startpoint
+    ExceptionBits exception_through;   // Stage bits a path advances into at a node
+    ExceptionBits exception_end;       // Final bits a node completes as an endpoint
+    uint64_t* exception_any_start;     // Stage-0 bits of exceptions without -from
+    uint64_t* exception_any_end;       // Final bits of exceptions without -to
+    uint64_t* exception_false;         // Final bits of false paths
+    uint64_t* exception_dead;          // Final bits of false paths without -to
+    int* exception_of_bit;
+    unsigned char* tag_count;
+    uint64_t* tag;
+    double* tag_arrival[TRANSITION_COUNT];
 } Circuit;
 
+// Sections of a snapshot file, in file order
+enum {
+    SNAPSHOT_TYPE,
+    SNAPSHOT_RISE_DELAY,
+    SNAPSHOT_FALL_DELAY,
+    SNAPSHOT_LEVEL,
+    SNAPSHOT_NAME_OFFSET,
+    SNAPSHOT_NAME_POOL,
+    SNAPSHOT_FANIN_START,
+    SNAPSHOT_FANIN,
+    SNAPSHOT_FANOUT_START,
+    SNAPSHOT_FANOUT,
+    SNAPSHOT_ENDPOINTS,
+    SNAPSHOT_LEVEL_ORDER,
+    SNAPSHOT_LEVEL_START,
+    SNAPSHOT_DISABLED_SOURCE,
+    SNAPSHOT_DISABLED_DESTINATION,
+    SNAPSHOT_SECTION_COUNT
+};
+
+// Header at the start of a snapshot file. Sections are raw in-memory
+// arrays of the writing host, so the header records byte order and word
+// size and a mismatching file is rejected rather than converted.
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t byte_order;     // 0x01020304 as stored by the writer
+    uint32_t word_size;      // sizeof(size_t) of the writer
+    int32_t node_count;
+    int32_t edge_count;      // Including disabled arcs
+    int32_t endpoint_count;
+    int32_t level_count;
+    int32_t disabled_count;
+    uint64_t name_pool_size;
+    uint64_t file_size;
+    uint64_t section_offset[SNAPSHOT_SECTION_COUNT];
+} SnapshotHeader;
+
+// The K worst paths found by find_critical_paths(), worst first.
+// Path p runs startpoint to endpoint through nodes[path_start[p] ..
+// path_start[p + 1] - 1].
+typedef struct {
+    int path_count;
+    NodeId* nodes;
+    unsigned char* transitions;  // Transition of the path signal at each node
+    int* path_start;
+    double* slack;
+    double* arrival;         // Arrival at the endpoint along this path
+} CriticalPaths;
+
+// Per-endpoint slack distribution from compute_statistical_timing(), in
+// circuit->endpoints order
+typedef struct {
+    int sample_count;
+    int endpoint_count;
+    double* slack_mean;
+    double* slack_sigma;
+    double* yield;           // Fraction of samples with non-negative slack
+    double design_yield;     // Fraction of samples meeting every endpoint
+} StatisticalTiming;
+
+// Path-based slack of the worst endpoints from compute_path_based_timing(),
+// worst graph-based slack first
+typedef struct {
+    int endpoint_count;
+    NodeId* endpoints;
+    double* graph_slack;     // Slack from compute_slack()
+    double* path_slack;      // Worst slack over the endpoint's re-timed paths
+    int* path_count;         // Paths re-timed per endpoint
+    unsigned char* exact;    // 0 if the path budget ran out first: path_slack is a lower bound
+    long long path_nodes;    // Gate evaluations the paths need one by one
+    long long evaluations;   // Gate evaluations left after sharing prefixes
+} PathBasedTiming;
+
+// Result of compute_out_of_core_timing(). Endpoint figures match an
+// in-memory compute_slack() exactly; per-node slack goes to a file.
+typedef struct {
+    int record_count;        // Nodes plus one launch record per driving flip-flop
+    int chunk_count;
+    size_t memory_budget;
+    size_t buffer_bytes;     // Chunk, spill and value buffers
+    int peak_live;           // Most values held at once for later chunks
+    size_t live_bytes;       // Memory of peak_live values
+    long long bytes_read;
+    long long bytes_written;
+    int endpoint_count;
+    int violations;
+    double worst_slack;
+    double total_negative_slack;
+} OutOfCoreTiming;
+
+// Timing report encodings
+typedef enum {
+    REPORT_TEXT,
+    REPORT_CSV,
+    REPORT_JSON,
+    REPORT_BINARY
+} ReportFormat;
+
+// Shape of a synthetic benchmark netlist
+typedef struct {
+    int gate_count;
+    int depth;               // Gate levels above the inputs
+    double fanout_skew;      // 1 spreads fan-out evenly; larger concentrates it
+    double reconvergence;    // Probability a later fan-in reconverges with the first
+    uint64_t seed;
+} NetlistProfile;
+
+// What write_timing_report() writes
+typedef struct {
+    ReportFormat format;
+    int worst_count;         // Endpoints listed, worst first
+    int include_nodes;       // Per-node table; large on big designs
+} ReportOptions;
+
+// Propagation directions over the levelized schedule
+enum {
+    PROPAGATE_FORWARD,
+    PROPAGATE_BACKWARD
+};
+
 // Function prototypes
+void* arena_alloc(Arena* arena, size_t bytes);
+void arena_reset(Arena* arena);
+void arena_release(Arena* arena);
 Circuit* create_circuit();
-Node* create_node(Circuit* circuit, const char* name, GateType type);
-void add_connection(Node* source, Node* destination);
+void free_circuit(Circuit* circuit);
+NodeId create_node(Circuit* circuit, const char* name, GateType type);
+const char* node_name(const Circuit* circuit, NodeId node);
+void add_connection(Circuit* circuit, NodeId source, NodeId destination);
+int remove_connection(Circuit* circuit, NodeId source, NodeId destination);
+void set_node_delay(Circuit* circuit, NodeId node, double rise, double fall);
+void build_timing_graph(Circuit* circuit);
+int levelize_circuit(Circuit* circuit);
+int write_snapshot(Circuit* circuit, const char* path);
+Circuit* load_snapshot(const char* path);
+CellLibrary* load_liberty(const char* path);
+void free_liberty(CellLibrary* library);
+int read_verilog_netlist(Circuit* circuit, const char* path);
 void compute_delays(Circuit* circuit);
 void compute_arrival_times(Circuit* circuit);
 void compute_required_times(Circuit* circuit);
 void compute_slack(Circuit* circuit);
-void find_critical_paths(Circuit* circuit);
-void print_circuit_timing(Circuit* circuit);
+void update_timing(Circuit* circuit);
+int read_constraints(Circuit* circuit, const char* path);
+void print_timing_checks(const Circuit* circuit);
+int add_corner(Circuit* circuit, const char* name, double derate, CellLibrary* library);
+void compute_corner_timing(Circuit* circuit);
+void print_corner_summary(const Circuit* circuit);
+StatisticalTiming* compute_statistical_timing(Circuit* circuit, int sample_count, unsigned int seed);
+void print_statistical_timing(const Circuit* circuit, const StatisticalTiming* stats);
+void free_statistical_timing(StatisticalTiming* stats);
+Circuit* generate_random_circuit(int gate_count, unsigned int seed);
+Circuit* generate_synthetic_circuit(const NetlistProfile* profile);
+int run_incremental_benchmark(int gate_count, int thread_count);
+int run_corner_benchmark(int gate_count, int thread_count);
+int run_statistical_benchmark(int gate_count, int thread_count);
+int run_path_based_benchmark(int gate_count, int thread_count, const char* liberty_path);
+int run_benchmark_suite(const NetlistProfile* profile, int max_gates, int thread_count,
+                        ReportFormat format, const char* path);
+CriticalPaths* find_critical_paths(Circuit* circuit, int max_paths);
+void free_critical_paths(CriticalPaths* paths);
+PathBasedTiming* compute_path_based_timing(Circuit* circuit, int endpoint_count, int max_paths);
+void print_path_based_timing(const Circuit* circuit, const PathBasedTiming* timing);
+void free_path_based_timing(PathBasedTiming* timing);
+int compute_out_of_core_timing(Circuit* circuit, const char* directory, size_t memory_budget,
+                               OutOfCoreTiming* result);
+void print_out_of_core_timing(const OutOfCoreTiming* timing, const char* directory);
+int run_out_of_core_benchmark(int gate_count, size_t memory_budget);
+int run_loop_benchmark(int gate_count);
+const char* gate_type_name(GateType type);
+int write_timing_report(Circuit* circuit, const CriticalPaths* paths, const ReportOptions* options,
+                        const char* path);
+
+// Grow a heap array, exiting if memory is exhausted
+static void* grow_array(void* array, size_t count, size_t element_size) {
+    void* grown = realloc(array, count * element_size);
+    if (!grown) {
+        fprintf(stderr, "Out of memory growing circuit to %zu entries\n", count);
+        exit(1);
+    }
+    return grown;
+}
+
+// Append a node index to a list
+static void node_list_push(NodeList* list, NodeId node) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? list->capacity * 2 : 64;
+        list->items = grow_array(list->items, list->capacity, sizeof(NodeId));
+    }
+    list->items[list->count++] = node;
+}
+
+// Allocate from the arena (max_align_t aligned), adding a block if needed
+void* arena_alloc(Arena* arena, size_t bytes) {
+    size_t align = sizeof(max_align_t);
+    bytes = (bytes + align - 1) & ~(align - 1);
+
+    // Reuse blocks kept by a previous arena_reset before adding new ones
+    while (arena->current && arena->current->used + bytes > arena->current->size) {
+        if (!arena->current->next) break;
+        arena->current = arena->current->next;
+    }
+
+    ArenaBlock* block = arena->current;
+    if (!block || block->used + bytes > block->size) {
+        size_t size = bytes > ARENA_BLOCK_SIZE ? bytes : ARENA_BLOCK_SIZE;
+        block = malloc(sizeof(ArenaBlock) + size);
+        if (!block) {
+            fprintf(stderr, "Out of memory allocating %zu bytes\n", bytes);
+            exit(1);
+        }
+        block->next = NULL;
+        block->size = size;
+        block->used = 0;
+        if (arena->current) {
+            arena->current->next = block;
+        } else {
+            arena->first = block;
+        }
+        arena->current = block;
+        arena->bytes_reserved += size;
+    }
+
+    void* memory = (char*)block->data + block->used;
+    block->used += bytes;
+    return memory;
+}
+
+// Mark every block empty but keep them for the next round of allocations
+void arena_reset(Arena* arena) {
+    for (ArenaBlock* block = arena->first; block; block = block->next) {
+        block->used = 0;
+    }
+    arena->current = arena->first;
+}
+
+// Return all blocks to the system
+void arena_release(Arena* arena) {
+    ArenaBlock* block = arena->first;
+    while (block) {
+        ArenaBlock* next = block->next;
+        free(block);
+        block = next;
+    }
+    arena->first = NULL;
+    arena->current = NULL;
+    arena->bytes_reserved = 0;
+}
 
 // Create a new circuit
 Circuit* create_circuit() {
-    Circuit* circuit = malloc(sizeof(Circuit));
-    circuit->node_count = 0;
+    Circuit* circuit = calloc(1, sizeof(Circuit));
+    circuit->thread_count = 1;
+    circuit->setup_time = DEFAULT_SETUP_TIME;
+    circuit->hold_time = DEFAULT_HOLD_TIME;
     return circuit;
 }
 
-// Create a new node and add to circuit
-Node* create_node(Circuit* circuit, const char* name, GateType type) {
-    if (circuit->node_count >= MAX_NODES) {
+// Free the per-node exception bit lists and the exception masks
+static void free_exception_masks(Circuit* circuit) {
+    ExceptionBits* lists[] = {&circuit->exception_start, &circuit->exception_through, &circuit->exception_end};
+    for (int l = 0; l < 3; l++) {
+        free(lists[l]->start);
+        free(lists[l]->bit);
+    }
+    free(circuit->exception_any_start);
+    free(circuit->exception_any_end);
+    free(circuit->exception_false);
+    free(circuit->exception_dead);
+    free(circuit->exception_of_bit);
+}
+
+// Free a circuit and everything it owns
+void free_circuit(Circuit* circuit) {
+    if (!circuit) return;
+    if (circuit->snapshot) {
+        munmap(circuit->snapshot, circuit->snapshot_size);
+    } else {
+        free(circuit->type);
+        free(circuit->delay[TRANSITION_RISE]);
+        free(circuit->delay[TRANSITION_FALL]);
+        free(circuit->level);
+        free(circuit->name_offset);
+        free(circuit->name_pool);
+    }
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        free(circuit->arrival_time[t]);
+        free(circuit->required_time[t]);
+        free(circuit->early_arrival[t]);
+        free(circuit->corner_delay[t]);
+        free(circuit->corner_arrival[t]);
+        free(circuit->corner_required[t]);
+        free(circuit->sample_output[t]);
+        free(circuit->tag_arrival[t]);
+    }
+    for (int x = 0; x < circuit->exception_count; x++) {
+        free(circuit->exceptions[x].from);
+        free(circuit->exceptions[x].to);
+        free(circuit->exceptions[x].through);
+        free(circuit->exceptions[x].through_start);
+    }
+    free(circuit->exceptions);
+    free_exception_masks(circuit);
+    free(circuit->tag_count);
+    free(circuit->tag);
+    free(circuit->slack);
+    free(circuit->port_delay);
+    free(circuit->queued);
+    free(circuit->arrival_dirty.items);
+    free(circuit->required_dirty.items);
+    free(circuit->load);
+    free(circuit->slew);
+    free(circuit->corner_slack);
+    free(circuit->delay_sigma);
+    free(circuit->sample_normal);
+    arena_release(&circuit->edge_arena);
+    arena_release(&circuit->graph_arena);
+    free(circuit);
+}
+
+// Double the capacity of every per-node array
+static void grow_node_arrays(Circuit* circuit) {
+    int capacity = circuit->node_capacity ? circuit->node_capacity * 2 : INITIAL_NODE_CAPACITY;
+    if (capacity <= circuit->node_capacity) {
         fprintf(stderr, "Circuit node limit exceeded\n");
-        return NULL;
+        exit(1);
+    }
+
+    circuit->type = grow_array(circuit->type, capacity, sizeof(unsigned char));
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        circuit->delay[t] = grow_array(circuit->delay[t], capacity, sizeof(double));
+        circuit->arrival_time[t] = grow_array(circuit->arrival_time[t], capacity, sizeof(double));
+        circuit->required_time[t] = grow_array(circuit->required_time[t], capacity, sizeof(double));
+        circuit->early_arrival[t] = grow_array(circuit->early_arrival[t], capacity, sizeof(double));
+    }
+    circuit->slack = grow_array(circuit->slack, capacity, sizeof(double));
+    circuit->port_delay = grow_array(circuit->port_delay, capacity, sizeof(double));
+    circuit->delay_sigma = grow_array(circuit->delay_sigma, capacity, sizeof(double));
+    circuit->level = grow_array(circuit->level, capacity, sizeof(int));
+    circuit->name_offset = grow_array(circuit->name_offset, capacity, sizeof(size_t));
+    circuit->queued = grow_array(circuit->queued, capacity, sizeof(unsigned char));
+    circuit->node_capacity = capacity;
+}
+
+// Append an edge to the chunked edge list
+static void append_edge(Circuit* circuit, NodeId source, NodeId destination) {
+    EdgeChunk* chunk = circuit->edges_tail;
+    if (!chunk || chunk->count == EDGE_CHUNK_SIZE) {
+        chunk = arena_alloc(&circuit->edge_arena, sizeof(EdgeChunk));
+        chunk->next = NULL;
+        chunk->count = 0;
+        if (circuit->edges_tail) {
+            circuit->edges_tail->next = chunk;
+        } else {
+            circuit->edges_head = chunk;
+        }
+        circuit->edges_tail = chunk;
+    }
+
+    chunk->source[chunk->count] = source;
+    chunk->destination[chunk->count] = destination;
+    chunk->disabled[chunk->count] = 0;
+    chunk->count++;
+}
+
+// Copy an array out of the snapshot mapping onto the heap
+static void* copy_from_snapshot(const void* array, size_t bytes) {
+    void* copy = grow_array(NULL, bytes + 1, 1);
+    memcpy(copy, array, bytes);
+    return copy;
+}
+
+// Give a snapshot-loaded circuit heap-owned arrays and an edge list so it
+// can be edited like one built node by node, then unmap the file
+static void detach_snapshot(Circuit* circuit) {
+    int n = circuit->node_count;
+    circuit->type = copy_from_snapshot(circuit->type, n * sizeof(unsigned char));
+    circuit->delay[TRANSITION_RISE] = copy_from_snapshot(circuit->delay[TRANSITION_RISE], n * sizeof(double));
+    circuit->delay[TRANSITION_FALL] = copy_from_snapshot(circuit->delay[TRANSITION_FALL], n * sizeof(double));
+    circuit->level = copy_from_snapshot(circuit->level, n * sizeof(int));
+    circuit->name_offset = copy_from_snapshot(circuit->name_offset, n * sizeof(size_t));
+    circuit->name_pool = copy_from_snapshot(circuit->name_pool, circuit->name_pool_size);
+    circuit->name_pool_capacity = circuit->name_pool_size + 1;
+
+    // Rebuild the edge list from the fan-out CSR and the disabled arcs
+    for (NodeId source = 0; source < n; source++) {
+        for (int j = circuit->fanout_start[source]; j < circuit->fanout_start[source + 1]; j++) {
+            append_edge(circuit, source, circuit->fanout[j]);
+        }
+    }
+    for (int k = 0; k < circuit->disabled_count; k++) {
+        append_edge(circuit, circuit->disabled_source[k], circuit->disabled_destination[k]);
+        circuit->edges_tail->disabled[circuit->edges_tail->count - 1] = 1;
+    }
+    circuit->disabled_source = NULL;
+    circuit->disabled_destination = NULL;
+    circuit->disabled_count = 0;
+
+    munmap(circuit->snapshot, circuit->snapshot_size);
+    circuit->snapshot = NULL;
+    circuit->snapshot_size = 0;
+    circuit->graph_built = 0;
+    circuit->levelized = 0;
+}
+
+// Create a new node named by the first length bytes of name, which need
+// not be NUL-terminated
+static NodeId create_node_named(Circuit* circuit, const char* name, size_t length, GateType type) {
+    if (circuit->node_count == INT_MAX) {
+        fprintf(stderr, "Circuit node limit exceeded\n");
+        return -1;
+    }
+    if (circuit->snapshot) detach_snapshot(circuit);
+    if (circuit->node_count == circuit->node_capacity) {
+        grow_node_arrays(circuit);
+    }
+
+    NodeId node = circuit->node_count++;
+
+    // Append the name to the string table
+    if (circuit->name_pool_size + length + 1 > circuit->name_pool_capacity) {
+        size_t capacity = circuit->name_pool_capacity ? circuit->name_pool_capacity : 16 * INITIAL_NODE_CAPACITY;
+        while (circuit->name_pool_size + length + 1 > capacity) capacity *= 2;
+        circuit->name_pool = grow_array(circuit->name_pool, capacity, 1);
+        circuit->name_pool_capacity = capacity;
     }
+    circuit->name_offset[node] = circuit->name_pool_size;
+    memcpy(circuit->name_pool + circuit->name_pool_size, name, length);
+    circuit->name_pool[circuit->name_pool_size + length] = '\0';
+    circuit->name_pool_size += length + 1;
 
-    Node* node = malloc(sizeof(Node));
-    strncpy(node->name, name, MAX_NAME_LENGTH - 1);
-    node->type = type;
-    node->delay = 0.0;
-    node->arrival_time = 0.0;
-    node->required_time = DBL_MAX;
-    node->slack = 0.0;
-    node->input_count = 0;
-    node->output_count = 0;
+    circuit->type[node] = type;
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        circuit->arrival_time[t][node] = 0.0;
+        circuit->required_time[t][node] = DBL_MAX;
+        circuit->early_arrival[t][node] = 0.0;
+    }
+    circuit->slack[node] = 0.0;
+    circuit->port_delay[node] = 0.0;
+    circuit->delay_sigma[node] = type == INPUT ? 0.0 : DEFAULT_DELAY_SIGMA;
+    circuit->level[node] = 0;
+    circuit->queued[node] = 0;
 
-    // Assign gate delays based on type
+    // Assign gate delays based on type (the same for both transitions)
+    double delay = 0.0;
     switch(type) {
-        case GATE_AND:   node->delay = 0.5; break;
-        case GATE_OR:    node->delay = 0.6; break;
-        case GATE_NOT:   node->delay = 0.3; break;
-        case GATE_NAND:  node->delay = 0.4; break;
-        case GATE_NOR:   node->delay = 0.5; break;
-        case GATE_XOR:   node->delay = 0.7; break;
-        case INPUT:      node->delay = 0.0; break;
-        case OUTPUT:     node->delay = 0.2; break;
+        case GATE_AND:   delay = 0.5; break;
+        case GATE_OR:    delay = 0.6; break;
+        case GATE_NOT:   delay = 0.3; break;
+        case GATE_NAND:  delay = 0.4; break;
+        case GATE_NOR:   delay = 0.5; break;
+        case GATE_XOR:   delay = 0.7; break;
+        case INPUT:      delay = 0.0; break;
+        case OUTPUT:     delay = 0.2; break;
+        case GATE_DFF:   delay = 0.3; break;   // Clock to Q
     }
+    circuit->delay[TRANSITION_RISE][node] = delay;
+    circuit->delay[TRANSITION_FALL][node] = delay;
 
-    circuit->nodes[circuit->node_count++] = node;
+    if (circuit->timing_valid) {
+        node_list_push(&circuit->arrival_dirty, node);
+        node_list_push(&circuit->required_dirty, node);
+    }
+    circuit->graph_built = 0;
+    circuit->levelized = 0;
     return node;
 }
 
+// Create a new node and add to circuit
+NodeId create_node(Circuit* circuit, const char* name, GateType type) {
+    return create_node_named(circuit, name, strlen(name), type);
+}
+
+// Look up a node's name in the string table
+const char* node_name(const Circuit* circuit, NodeId node) {
+    return circuit->name_pool + circuit->name_offset[node];
+}
+
 // Add connection between nodes
-void add_connection(Node* source, Node* destination) {
-    if (source->output_count < 4 && destination->input_count < 4) {
-        source->outputs[source->output_count++] = destination;
-        destination->inputs[destination->input_count++] = source;
+void add_connection(Circuit* circuit, NodeId source, NodeId destination) {
+    if (circuit->snapshot) detach_snapshot(circuit);
+    append_edge(circuit, source, destination);
+    circuit->edge_count++;
+    circuit->graph_built = 0;
+    circuit->levelized = 0;
+
+    if (circuit->timing_valid) {
+        node_list_push(&circuit->arrival_dirty, destination);
+        node_list_push(&circuit->required_dirty, source);
     }
 }
 
-// Compute arrival times for all nodes (forward traversal)
-void compute_arrival_times(Circuit* circuit) {
-    for (int i = 0; i < circuit->node_count; i++) {
-        Node* node = circuit->nodes[i];
-        
-        if (node->type == INPUT) {
-            node->arrival_time = 0.0;
-            continue;
+// Remove one connection between two nodes. The last edge in the list
+// takes its slot. Returns 0 on success, -1 if no such connection exists.
+int remove_connection(Circuit* circuit, NodeId source, NodeId destination) {
+    if (circuit->snapshot) detach_snapshot(circuit);
+    EdgeChunk* found_chunk = NULL;
+    int found_index = -1;
+    EdgeChunk* last_chunk = NULL;
+
+    for (EdgeChunk* chunk = circuit->edges_head; chunk; chunk = chunk->next) {
+        if (chunk->count > 0) last_chunk = chunk;
+        for (int e = 0; e < chunk->count && !found_chunk; e++) {
+            if (chunk->source[e] == source && chunk->destination[e] == destination) {
+                found_chunk = chunk;
+                found_index = e;
+            }
+        }
+    }
+
+    if (!found_chunk) {
+        fprintf(stderr, "No connection from %s to %s\n",
+                node_name(circuit, source), node_name(circuit, destination));
+        return -1;
+    }
+
+    int last = --last_chunk->count;
+    found_chunk->source[found_index] = last_chunk->source[last];
+    found_chunk->destination[found_index] = last_chunk->destination[last];
+    found_chunk->disabled[found_index] = last_chunk->disabled[last];
+    circuit->edges_tail = last_chunk;
+    circuit->edge_count--;
+    circuit->graph_built = 0;
+    circuit->levelized = 0;
+
+    if (circuit->timing_valid) {
+        node_list_push(&circuit->arrival_dirty, destination);
+        node_list_push(&circuit->required_dirty, source);
+    }
+    return 0;
+}
+
+// Change a node's rise and fall delays. Its fan-out arrivals and its own
+// required times become stale and are re-timed by the next update_timing().
+void set_node_delay(Circuit* circuit, NodeId node, double rise, double fall) {
+    if (circuit->delay[TRANSITION_RISE][node] == rise && circuit->delay[TRANSITION_FALL][node] == fall) return;
+    circuit->delay[TRANSITION_RISE][node] = rise;
+    circuit->delay[TRANSITION_FALL][node] = fall;
+
+    if (circuit->timing_valid) {
+        node_list_push(&circuit->arrival_dirty, node);
+        node_list_push(&circuit->required_dirty, node);
+    }
+}
+
+// Pack the edge list into fan-in and fan-out CSR arrays (counting sort,
+// so each node's neighbours keep the order they were connected in)
+void build_timing_graph(Circuit* circuit) {
+    TRACE_SCOPE("build_timing_graph");
+    int n = circuit->node_count;
+    int m = circuit->edge_count;
+
+    arena_reset(&circuit->graph_arena);
+    circuit->fanin_start = arena_alloc(&circuit->graph_arena, (n + 1) * sizeof(int));
+    circuit->fanout_start = arena_alloc(&circuit->graph_arena, (n + 1) * sizeof(int));
+    circuit->fanin = arena_alloc(&circuit->graph_arena, (m + 1) * sizeof(NodeId));
+    circuit->fanout = arena_alloc(&circuit->graph_arena, (m + 1) * sizeof(NodeId));
+    circuit->level_order = arena_alloc(&circuit->graph_arena, (n + 1) * sizeof(NodeId));
+    circuit->level_start = arena_alloc(&circuit->graph_arena, (n + 1) * sizeof(int));
+    circuit->level_count = 0;
+    circuit->levelized = 0;
+
+    int endpoint_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (circuit->type[i] == OUTPUT || circuit->type[i] == GATE_DFF) endpoint_count++;
+    }
+    circuit->endpoints = arena_alloc(&circuit->graph_arena, (endpoint_count + 1) * sizeof(NodeId));
+    circuit->endpoint_count = 0;
+    for (int i = 0; i < n; i++) {
+        if (circuit->type[i] == OUTPUT || circuit->type[i] == GATE_DFF) {
+            circuit->endpoints[circuit->endpoint_count++] = i;
         }
+    }
 
-        // Find max arrival time of inputs
-        double max_input_arrival = 0.0;
-        for (int j = 0; j < node->input_count; j++) {
-            max_input_arrival = fmax(max_input_arrival, 
-                node->inputs[j]->arrival_time + node->inputs[j]->delay);
+    int* fanin_start = circuit->fanin_start;
+    int* fanout_start = circuit->fanout_start;
+    memset(fanin_start, 0, (n + 1) * sizeof(int));
+    memset(fanout_start, 0, (n + 1) * sizeof(int));
+
+    // Count degrees one slot ahead so the prefix sum yields start offsets
+    int disabled_count = 0;
+    for (EdgeChunk* chunk = circuit->edges_head; chunk; chunk = chunk->next) {
+        for (int e = 0; e < chunk->count; e++) {
+            if (chunk->disabled[e]) {
+                disabled_count++;
+                continue;
+            }
+            fanout_start[chunk->source[e] + 1]++;
+            fanin_start[chunk->destination[e] + 1]++;
         }
+    }
+    circuit->disabled_source = arena_alloc(&circuit->graph_arena, (disabled_count + 1) * sizeof(NodeId));
+    circuit->disabled_destination = arena_alloc(&circuit->graph_arena, (disabled_count + 1) * sizeof(NodeId));
+    circuit->disabled_count = 0;
+    for (int i = 0; i < n; i++) {
+        fanin_start[i + 1] += fanin_start[i];
+        fanout_start[i + 1] += fanout_start[i];
+    }
 
-        node->arrival_time = max_input_arrival;
+    // Fill using level_start/level_order as temporary write cursors
+    int* fanin_fill = circuit->level_start;
+    int* fanout_fill = circuit->level_order;
+    memcpy(fanin_fill, fanin_start, n * sizeof(int));
+    memcpy(fanout_fill, fanout_start, n * sizeof(int));
+    for (EdgeChunk* chunk = circuit->edges_head; chunk; chunk = chunk->next) {
+        for (int e = 0; e < chunk->count; e++) {
+            NodeId source = chunk->source[e];
+            NodeId destination = chunk->destination[e];
+            if (chunk->disabled[e]) {
+                circuit->disabled_source[circuit->disabled_count] = source;
+                circuit->disabled_destination[circuit->disabled_count++] = destination;
+                continue;
+            }
+            circuit->fanout[fanout_fill[source]++] = destination;
+            circuit->fanin[fanin_fill[destination]++] = source;
+        }
     }
+
+    circuit->graph_built = 1;
 }
 
-// Compute required times (backward traversal)
-void compute_required_times(Circuit* circuit) {
-    // Find the max arrival time (critical path)
-    double max_arrival_time = 0.0;
-    Node* sink_node = NULL;
-    for (int i = 0; i < circuit->node_count; i++) {
-        if (circuit->nodes[i]->type == OUTPUT && 
-            circuit->nodes[i]->arrival_time > max_arrival_time) {
-            max_arrival_time = circuit->nodes[i]->arrival_time;
-            sink_node = circuit->nodes[i];
+// An arc cut to break a combinational loop
+typedef struct {
+    NodeId source;
+    NodeId destination;
+} LoopArc;
+
+static int compare_loop_arcs(const void* a, const void* b) {
+    const LoopArc* x = a;
+    const LoopArc* y = b;
+    if (x->source != y->source) return x->source < y->source ? -1 : 1;
+    return (x->destination > y->destination) - (x->destination < y->destination);
+}
+
+// Report each loop with its members and the arcs cut in it. Members of
+// loop l are members[member_start[l] .. member_start[l + 1] - 1].
+static void report_combinational_loops(const Circuit* circuit, const NodeId* members, const int* member_start,
+                                       int loop_count, const int* loop, const LoopArc* cuts, int cut_count) {
+    int* cut_start = calloc(loop_count + 1, sizeof(int));
+    int* cut_order = malloc((cut_count + 1) * sizeof(int));
+    for (int k = 0; k < cut_count; k++) cut_start[loop[cuts[k].source] + 1]++;
+    for (int l = 0; l < loop_count; l++) cut_start[l + 1] += cut_start[l];
+    for (int k = 0; k < cut_count; k++) cut_order[cut_start[loop[cuts[k].source]]++] = k;
+    for (int l = loop_count; l > 0; l--) cut_start[l] = cut_start[l - 1];
+    cut_start[0] = 0;
+
+    fprintf(stderr, "Warning: %d combinational loop(s); timing continues with %d arc(s) cut\n", loop_count, cut_count);
+    for (int l = 0; l < loop_count && l < LOOP_REPORT_LIMIT; l++) {
+        int size = member_start[l + 1] - member_start[l];
+        fprintf(stderr, "  Loop %d, %d node(s):", l + 1, size);
+        for (int k = 0; k < size && k < LOOP_REPORT_NAMES; k++) {
+            fprintf(stderr, " %s", node_name(circuit, members[member_start[l] + k]));
         }
+        if (size > LOOP_REPORT_NAMES) fprintf(stderr, " ... %d more", size - LOOP_REPORT_NAMES);
+        fprintf(stderr, "\n    cut:");
+        int cuts_here = cut_start[l + 1] - cut_start[l];
+        for (int k = 0; k < cuts_here && k < LOOP_REPORT_NAMES; k++) {
+            const LoopArc* arc = &cuts[cut_order[cut_start[l] + k]];
+            fprintf(stderr, "%s %s -> %s", k > 0 ? "," : "", node_name(circuit, arc->source),
+                    node_name(circuit, arc->destination));
+        }
+        if (cuts_here > LOOP_REPORT_NAMES) fprintf(stderr, " ... %d more", cuts_here - LOOP_REPORT_NAMES);
+        fprintf(stderr, "\n");
     }
+    if (loop_count > LOOP_REPORT_LIMIT) fprintf(stderr, "  ... %d more loop(s)\n", loop_count - LOOP_REPORT_LIMIT);
+    fprintf(stderr, "  set_disable_timing in the SDC file chooses where loops are cut\n");
+    free(cut_start);
+    free(cut_order);
+}
+
+// Find every combinational loop and cut it so the graph can be levelized.
+// An iterative Tarjan search over the CSR finds the strongly connected
+// components in one linear pass; like levelization it does not follow
+// edges out of a flip-flop. A component of two or more nodes, or a node
+// feeding itself, is a loop. Every arc the same search meets that leads
+// back to a node on its current path is cut, which leaves the graph
+// acyclic. Arcs already disabled by set_disable_timing are not in the
+// CSR, so loops they break are never seen. Cut arcs are disabled in the
+// edge list and the graph must be rebuilt. Returns the number of arcs cut.
+static int break_combinational_loops(Circuit* circuit) {
+    TRACE_SCOPE("break_combinational_loops");
+    enum { ON_STACK = 1, ON_PATH = 2 };
+    int n = circuit->node_count;
+    int* index = malloc((n + 1) * sizeof(int));
+    int* low = malloc((n + 1) * sizeof(int));
+    int* loop = malloc((n + 1) * sizeof(int));
+    unsigned char* state = calloc(n + 1, 1);
+    NodeId* stack = malloc((n + 1) * sizeof(NodeId));
+    NodeId* path = malloc((n + 1) * sizeof(NodeId));
+    int* cursor = malloc((n + 1) * sizeof(int));
+    for (int i = 0; i < n; i++) index[i] = -1;
+
+    NodeList members = {0};
+    NodeList member_start = {0};
+    LoopArc* cuts = NULL;
+    int cut_count = 0;
+    int next_index = 0;
+    int stack_count = 0;
+
+    for (NodeId root = 0; root < n; root++) {
+        if (index[root] >= 0) continue;
+        int depth = 0;
+        NodeId enter = root;
+        while (1) {
+            if (enter >= 0) {
+                index[enter] = low[enter] = next_index++;
+                stack[stack_count++] = enter;
+                state[enter] = ON_STACK | ON_PATH;
+                path[depth] = enter;
+                cursor[depth++] = circuit->fanout_start[enter];
+                enter = -1;
+            }
+            NodeId node = path[depth - 1];
+            int end = circuit->type[node] == GATE_DFF ? cursor[depth - 1] : circuit->fanout_start[node + 1];
+            if (cursor[depth - 1] < end) {
+                NodeId next = circuit->fanout[cursor[depth - 1]++];
+                if (index[next] < 0) {
+                    enter = next;
+                } else if (state[next] & ON_STACK) {
+                    if (state[next] & ON_PATH) {
+                        cuts = grow_array(cuts, cut_count + 1, sizeof(LoopArc));
+                        cuts[cut_count++] = (LoopArc){node, next};
+                    }
+                    if (index[next] < low[node]) low[node] = index[next];
+                }
+                continue;
+            }
 
-    if (sink_node) {
-        sink_node->required_time = max_arrival_time;
+            // Every fan-out is done: close the component rooted here
+            state[node] &= ~ON_PATH;
+            depth--;
+            if (depth > 0 && low[node] < low[path[depth - 1]]) low[path[depth - 1]] = low[node];
+            if (low[node] == index[node]) {
+                int first = stack_count;
+                do {
+                    first--;
+                    state[stack[first]] = 0;
+                } while (stack[first] != node);
+                int is_loop = stack_count - first > 1;
+                for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1] && !is_loop; j++) {
+                    is_loop = circuit->fanout[j] == node && circuit->type[node] != GATE_DFF;
+                }
+                if (is_loop) node_list_push(&member_start, members.count);
+                for (int k = first; k < stack_count; k++) {
+                    loop[stack[k]] = is_loop ? member_start.count - 1 : -1;
+                    if (is_loop) node_list_push(&members, stack[k]);
+                }
+                stack_count = first;
+            }
+            if (depth == 0) break;
+        }
+    }
+    int loop_count = member_start.count;
+    node_list_push(&member_start, members.count);
 
-        // Backward traversal
-        for (int i = circuit->node_count - 1; i >= 0; i--) {
-            Node* node = circuit->nodes[i];
-            
-            if (node->type == OUTPUT) continue;
+    if (cut_count > 0) {
+        report_combinational_loops(circuit, members.items, member_start.items, loop_count, loop, cuts, cut_count);
 
-            for (int j = 0; j < node->output_count; j++) {
-                node->required_time = fmin(node->required_time, 
-                    node->outputs[j]->required_time - node->delay);
+        // Disable the cut arcs, and any parallel copies, in the edge list
+        qsort(cuts, cut_count, sizeof(LoopArc), compare_loop_arcs);
+        if (circuit->snapshot) detach_snapshot(circuit);
+        for (EdgeChunk* chunk = circuit->edges_head; chunk; chunk = chunk->next) {
+            for (int e = 0; e < chunk->count; e++) {
+                LoopArc arc = {chunk->source[e], chunk->destination[e]};
+                if (chunk->disabled[e] || loop[arc.source] < 0 || loop[arc.source] != loop[arc.destination]) continue;
+                if (bsearch(&arc, cuts, cut_count, sizeof(LoopArc), compare_loop_arcs)) chunk->disabled[e] = 1;
             }
         }
+        circuit->loop_count += loop_count;
+        circuit->graph_built = 0;
     }
+
+    free(index);
+    free(low);
+    free(loop);
+    free(state);
+    free(stack);
+    free(path);
+    free(cursor);
+    free(members.items);
+    free(member_start.items);
+    free(cuts);
+    return cut_count;
 }
 
-// Compute slack for each node
-void compute_slack(Circuit* circuit) {
-    for (int i = 0; i < circuit->node_count; i++) {
-        Node* node = circuit->nodes[i];
-        node->slack = node->required_time - node->arrival_time;
+// Levelize the circuit with Kahn's algorithm so every node appears after
+// all of its fan-in. A flip-flop's fan-out does not wait for it, since its
+// output launches on the clock. Combinational loops are reported and cut
+// first (see break_combinational_loops()). Returns 0 on success, -1 if no
+// topological order could be found.
+int levelize_circuit(Circuit* circuit) {
+    TRACE_SCOPE("levelize");
+    if (!circuit->graph_built) build_timing_graph(circuit);
+
+    int n = circuit->node_count;
+    int* level = circuit->level;
+    int* pending = malloc((n + 1) * sizeof(int));
+    int* level_size = malloc((n + 1) * sizeof(int));
+    NodeId* queue = malloc((n + 1) * sizeof(NodeId));
+    int head = 0, tail = 0;
+
+    for (int i = 0; i < n; i++) {
+        pending[i] = 0;
+        for (int j = circuit->fanin_start[i]; j < circuit->fanin_start[i + 1]; j++) {
+            if (circuit->type[circuit->fanin[j]] != GATE_DFF) pending[i]++;
+        }
+        level_size[i] = 0;
+        level[i] = 0;
+        if (pending[i] == 0) {
+            queue[tail++] = i;
+        }
+    }
+
+    // Each node's level is one past the deepest of its fan-in
+    int level_count = 0;
+    while (head < tail) {
+        NodeId node = queue[head++];
+        level_size[level[node]]++;
+        if (level[node] + 1 > level_count) {
+            level_count = level[node] + 1;
+        }
+        if (circuit->type[node] == GATE_DFF) continue;
+
+        for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+            NodeId next = circuit->fanout[j];
+            if (level[node] + 1 > level[next]) {
+                level[next] = level[node] + 1;
+            }
+            if (--pending[next] == 0) {
+                queue[tail++] = next;
+            }
+        }
+    }
+
+    if (tail < n) {
+        circuit->levelized = 0;
+        free(pending);
+        free(level_size);
+        free(queue);
+        if (break_combinational_loops(circuit) == 0) {
+            fprintf(stderr, "Combinational loop detected: %d node(s) could not be levelized\n", n - tail);
+            return -1;
+        }
+        build_timing_graph(circuit);
+        return levelize_circuit(circuit);
+    }
+
+    // Bucket nodes by level (counting sort keeps the order stable)
+    circuit->level_start[0] = 0;
+    for (int l = 0; l < level_count; l++) {
+        circuit->level_start[l + 1] = circuit->level_start[l] + level_size[l];
+        level_size[l] = circuit->level_start[l];
     }
+    for (int i = 0; i < n; i++) {
+        circuit->level_order[level_size[level[i]]++] = i;
+    }
+
+    circuit->level_count = level_count;
+    circuit->levelized = 1;
+    free(pending);
+    free(level_size);
+    free(queue);
+    return 0;
 }
 
-// Print circuit timing information
-void print_circuit_timing(Circuit* circuit) {
-    printf("Circuit Timing Analysis:\n");
-    printf("---------------------\n");
-    
-    for (int i = 0; i < circuit->node_count; i++) {
-        Node* node = circuit->nodes[i];
-        printf("Node: %s\n", node->name);
-        printf("  Type: %d\n", node->type);
-        printf("  Delay: %.2f ns\n", node->delay);
-        printf("  Arrival Time: %.2f ns\n", node->arrival_time);
-        printf("  Required Time: %.2f ns\n", node->required_time);
-        printf("  Slack: %.2f ns\n\n", node->slack);
+// Liberty parse tree: groups such as cell(NAND2) { ... } holding simple
+// (name : value ;) and complex (name(args) ;) attributes
+typedef struct LibertyAttribute {
+    char* name;
+    char* value;             // Complex attribute arguments joined with ','
+    struct LibertyAttribute* next;
+} LibertyAttribute;
+
+typedef struct LibertyGroup {
+    char* type;
+    char* name;              // First argument, "" for groups like timing()
+    LibertyAttribute* attributes;
+    struct LibertyGroup* children;
+    struct LibertyGroup* next;
+} LibertyGroup;
+
+typedef struct {
+    const char* text;
+    size_t length;
+    size_t position;
+    int line;
+    Arena* arena;
+    int error;
+} LibertyParser;
+
+// Token kinds: 'w' word, 's' quoted string, a punctuation character, or 0 at end
+typedef struct {
+    int kind;
+    const char* start;
+    size_t length;
+} LibertyToken;
+
+static LibertyToken liberty_next_token(LibertyParser* parser) {
+    const char* text = parser->text;
+    LibertyToken token = {0, NULL, 0};
+
+    // Skip whitespace, line continuations and comments
+    while (parser->position < parser->length) {
+        char c = text[parser->position];
+        if (c == '\n') {
+            parser->line++;
+            parser->position++;
+        } else if (c == ' ' || c == '\t' || c == '\r' || c == '\\') {
+            parser->position++;
+        } else if (c == '/' && parser->position + 1 < parser->length && text[parser->position + 1] == '*') {
+            parser->position += 2;
+            while (parser->position + 1 < parser->length &&
+                   !(text[parser->position] == '*' && text[parser->position + 1] == '/')) {
+                if (text[parser->position] == '\n') parser->line++;
+                parser->position++;
+            }
+            parser->position += 2;
+        } else if (c == '/' && parser->position + 1 < parser->length && text[parser->position + 1] == '/') {
+            while (parser->position < parser->length && text[parser->position] != '\n') parser->position++;
+        } else {
+            break;
+        }
+    }
+    if (parser->position >= parser->length) return token;
+
+    char c = text[parser->position];
+    if (strchr("(){}:;,", c)) {
+        token.kind = c;
+        token.start = text + parser->position++;
+        token.length = 1;
+    } else if (c == '"') {
+        size_t begin = ++parser->position;
+        while (parser->position < parser->length && text[parser->position] != '"') {
+            if (text[parser->position] == '\n') parser->line++;
+            parser->position++;
+        }
+        token.kind = 's';
+        token.start = text + begin;
+        token.length = parser->position - begin;
+        parser->position++;
+    } else {
+        size_t begin = parser->position;
+        while (parser->position < parser->length) {
+            c = text[parser->position];
+            if (c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == '"' || strchr("(){}:;,", c)) break;
+            parser->position++;
+        }
+        token.kind = 'w';
+        token.start = text + begin;
+        token.length = parser->position - begin;
     }
+    return token;
 }
 
-// Example usage
-int main() {
-    Circuit* circuit = create_circuit();
+static LibertyToken liberty_peek_token(LibertyParser* parser) {
+    size_t position = parser->position;
+    int line = parser->line;
+    LibertyToken token = liberty_next_token(parser);
+    parser->position = position;
+    parser->line = line;
+    return token;
+}
+
+static char* liberty_copy(LibertyParser* parser, const char* text, size_t length) {
+    char* copy = arena_alloc(parser->arena, length + 1);
+    memcpy(copy, text, length);
+    copy[length] = '\0';
+    return copy;
+}
+
+static void liberty_error(LibertyParser* parser, const char* message) {
+    if (!parser->error) {
+        fprintf(stderr, "Liberty parse error on line %d: %s\n", parser->line, message);
+    }
+    parser->error = 1;
+}
 
-    // Create nodes
-    Node* input1 = create_node(circuit, "IN1", INPUT);
-    Node* input2 = create_node(circuit, "IN2", INPUT);
-    Node* and_gate = create_node(circuit, "AND1", GATE_AND);
-    Node* not_gate = create_node(circuit, "NOT1", GATE_NOT);
-    Node* output = create_node(circuit, "OUT", OUTPUT);
+// Parse statements up to the closing brace of the current group
+static void liberty_parse_body(LibertyParser* parser, LibertyGroup* group, int top_level) {
+    LibertyAttribute** last_attribute = &group->attributes;
+    LibertyGroup** last_child = &group->children;
 
-    // Connect nodes
-    add_connection(input1, and_gate);
-    add_connection(input2, and_gate);
-    add_connection(and_gate, not_gate);
-    add_connection(not_gate, output);
+    while (!parser->error) {
+        LibertyToken token = liberty_next_token(parser);
+        if (token.kind == 0) {
+            if (!top_level) liberty_error(parser, "unexpected end of file");
+            return;
+        }
+        if (token.kind == '}') {
+            if (top_level) liberty_error(parser, "unbalanced '}'");
+            return;
+        }
+        if (token.kind == ';') continue;
+        if (token.kind != 'w') {
+            liberty_error(parser, "expected attribute or group name");
+            return;
+        }
 
-    // Perform STA
-    compute_arrival_times(circuit);
-    compute_required_times(circuit);
-    compute_slack(circuit);
+        char* name = liberty_copy(parser, token.start, token.length);
+        LibertyToken next = liberty_next_token(parser);
 
-    // Print results
-    print_circuit_timing(circuit);
+        if (next.kind == ':') {
+            // Simple attribute: name : value ;
+            LibertyToken value = liberty_next_token(parser);
+            if (value.kind != 'w' && value.kind != 's') {
+                liberty_error(parser, "expected attribute value");
+                return;
+            }
+            LibertyAttribute* attribute = arena_alloc(parser->arena, sizeof(LibertyAttribute));
+            attribute->name = name;
+            attribute->value = liberty_copy(parser, value.start, value.length);
+            attribute->next = NULL;
+            *last_attribute = attribute;
+            last_attribute = &attribute->next;
+            if (liberty_peek_token(parser).kind == ';') liberty_next_token(parser);
+        } else if (next.kind == '(') {
+            // Arguments, then either a group body or a complex attribute
+            size_t begin = parser->position;
+            int depth = 1;
+            while (depth > 0 && !parser->error) {
+                LibertyToken argument = liberty_next_token(parser);
+                if (argument.kind == 0) liberty_error(parser, "unterminated argument list");
+                if (argument.kind == '(') depth++;
+                if (argument.kind == ')') depth--;
+            }
+            if (parser->error) return;
+            char* arguments = liberty_copy(parser, parser->text + begin, parser->position - 1 - begin);
+
+            if (liberty_peek_token(parser).kind == '{') {
+                liberty_next_token(parser);
+                LibertyGroup* child = arena_alloc(parser->arena, sizeof(LibertyGroup));
+                memset(child, 0, sizeof(LibertyGroup));
+                child->type = name;
+
+                // Group name is the first argument without quotes or spaces
+                char* first = arguments;
+                while (*first == ' ' || *first == '"' || *first == '\t') first++;
+                size_t length = strcspn(first, ",\"");
+                while (length > 0 && (first[length - 1] == ' ' || first[length - 1] == '\t')) length--;
+                child->name = liberty_copy(parser, first, length);
+
+                liberty_parse_body(parser, child, 0);
+                *last_child = child;
+                last_child = &child->next;
+            } else {
+                LibertyAttribute* attribute = arena_alloc(parser->arena, sizeof(LibertyAttribute));
+                attribute->name = name;
+                attribute->value = arguments;
+                attribute->next = NULL;
+                *last_attribute = attribute;
+                last_attribute = &attribute->next;
+                if (liberty_peek_token(parser).kind == ';') liberty_next_token(parser);
+            }
+        } else {
+            liberty_error(parser, "expected ':' or '(' after name");
+            return;
+        }
+    }
+}
+
+static const char* liberty_attribute(const LibertyGroup* group, const char* name) {
+    for (const LibertyAttribute* attribute = group->attributes; attribute; attribute = attribute->next) {
+        if (strcmp(attribute->name, name) == 0) return attribute->value;
+    }
+    return NULL;
+}
+
+// Read every number in a list such as "0.01, 0.02, 0.04"
+static int parse_number_list(const char* text, double* values, int max_values) {
+    int count = 0;
+    while (text && *text && count < max_values) {
+        if (strchr("+-.0123456789", *text)) {
+            char* end;
+            values[count++] = strtod(text, &end);
+            if (end == text) end++;
+            text = end;
+        } else {
+            text++;
+        }
+    }
+    return count;
+}
+
+// Fill a DelayTable from a table group, taking missing indices from its
+// lu_table_template and transposing templates that index load first
+static int read_delay_table(const LibertyGroup* library_group, const LibertyGroup* table_group,
+                            DelayTable* table) {
+    const LibertyGroup* template_group = NULL;
+    for (const LibertyGroup* group = library_group->children; group; group = group->next) {
+        if (strcmp(group->type, "lu_table_template") == 0 && strcmp(group->name, table_group->name) == 0) {
+            template_group = group;
+        }
+    }
+
+    const char* index_1 = liberty_attribute(table_group, "index_1");
+    const char* index_2 = liberty_attribute(table_group, "index_2");
+    const char* variable_1 = NULL;
+    if (template_group) {
+        if (!index_1) index_1 = liberty_attribute(template_group, "index_1");
+        if (!index_2) index_2 = liberty_attribute(template_group, "index_2");
+        variable_1 = liberty_attribute(template_group, "variable_1");
+    }
+
+    double first[MAX_TABLE_INDEX], second[MAX_TABLE_INDEX];
+    double values[MAX_TABLE_INDEX * MAX_TABLE_INDEX];
+    int first_count = index_1 ? parse_number_list(index_1, first, MAX_TABLE_INDEX) : 0;
+    int second_count = index_2 ? parse_number_list(index_2, second, MAX_TABLE_INDEX) : 0;
+    if (first_count == 0) { first[0] = 0.0; first_count = 1; }
+    if (second_count == 0) { second[0] = 0.0; second_count = 1; }
+
+    int value_count = parse_number_list(liberty_attribute(table_group, "values"),
+                                        values, MAX_TABLE_INDEX * MAX_TABLE_INDEX);
+    if (value_count != first_count * second_count) {
+        fprintf(stderr, "Liberty table %s has %d values, expected %d\n",
+                table_group->type, value_count, first_count * second_count);
+        return -1;
+    }
+
+    int load_first = variable_1 && strstr(variable_1, "capacitance") != NULL;
+    if (!load_first) {
+        table->slew_count = first_count;
+        table->load_count = second_count;
+        memcpy(table->slew_index, first, first_count * sizeof(double));
+        memcpy(table->load_index, second, second_count * sizeof(double));
+        memcpy(table->values, values, value_count * sizeof(double));
+    } else {
+        table->slew_count = second_count;
+        table->load_count = first_count;
+        memcpy(table->slew_index, second, second_count * sizeof(double));
+        memcpy(table->load_index, first, first_count * sizeof(double));
+        for (int i = 0; i < first_count; i++) {
+            for (int j = 0; j < second_count; j++) {
+                table->values[j * first_count + i] = values[i * second_count + j];
+            }
+        }
+    }
+    return 0;
+}
+
+static double table_max(const DelayTable* table) {
+    int count = table->slew_count * table->load_count;
+    double largest = count ? table->values[0] : 0.0;
+    for (int i = 1; i < count; i++) largest = fmax(largest, table->values[i]);
+    return largest;
+}
 
+static double table_mean(const DelayTable* table) {
+    int count = table->slew_count * table->load_count;
+    double sum = 0.0;
+    for (int i = 0; i < count; i++) sum += table->values[i];
+    return count ? sum / count : 0.0;
+}
+
+// Classify an output pin function such as "!(A & B)" or "(A*B)'" as a
+// gate type. Returns -1 for functions the STA model has no type for.
+static int classify_function(const char* function, int input_count) {
+    if (!function) return -1;
+    const char* start = function;
+    while (*start == ' ' || *start == '"') start++;
+    size_t length = strlen(start);
+    while (length > 0 && (start[length - 1] == ' ' || start[length - 1] == '"')) length--;
+
+    int inverted = (length > 0 && (start[0] == '!' || start[length - 1] == '\''));
+    int has_xor = 0, has_or = 0, has_and = 0;
+    for (size_t i = 0; i < length; i++) {
+        if (start[i] == '^') has_xor = 1;
+        if (start[i] == '|' || start[i] == '+') has_or = 1;
+        if (start[i] == '&' || start[i] == '*') has_and = 1;
+    }
+
+    if (has_xor) return GATE_XOR;
+    if (has_or) return inverted ? GATE_NOR : GATE_OR;
+    if (has_and || input_count > 1) return inverted ? GATE_NAND : GATE_AND;
+    if (inverted) return GATE_NOT;
+    return -1;
+}
+
+// Read a whole regular file into a NUL-terminated buffer, reporting any
+// failure against what the file holds (e.g. "Liberty file"). Pipes and
+// directories are rejected since their size is unknown. Returns NULL on
+// error.
+static char* read_whole_file(const char* path, const char* what, size_t* length) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open %s %s\n", what, path);
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "Cannot stat %s %s\n", what, path);
+        close(fd);
+        return NULL;
+    }
+    if (!S_ISREG(info.st_mode)) {
+        fprintf(stderr, "Cannot read %s %s: not a regular file\n", what, path);
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)info.st_size;
+    char* text = malloc(size + 1);
+    if (!text) {
+        fprintf(stderr, "Cannot read %s %s: out of memory for %zu bytes\n", what, path, size);
+        close(fd);
+        return NULL;
+    }
+    size_t done = 0;
+    while (done < size) {
+        ssize_t got = read(fd, text + done, size - done);
+        if (got <= 0) {
+            fprintf(stderr, "Cannot read %s %s\n", what, path);
+            close(fd);
+            free(text);
+            return NULL;
+        }
+        done += (size_t)got;
+    }
+    close(fd);
+    text[size] = '\0';
+    *length = size;
+    return text;
+}
+
+// Load the cells of a Liberty file. Each cell keeps its worst timing arc;
+// each gate type maps to the matching cell with the fewest inputs.
+CellLibrary* load_liberty(const char* path) {
+    TRACE_SCOPE("load_liberty");
+    size_t size;
+    char* text = read_whole_file(path, "Liberty file", &size);
+    if (!text) return NULL;
+
+    CellLibrary* library = calloc(1, sizeof(CellLibrary));
+    LibertyParser parser = {text, size, 0, 1, &library->arena, 0};
+    LibertyGroup root;
+    memset(&root, 0, sizeof(root));
+    liberty_parse_body(&parser, &root, 1);
+    free(text);
+
+    const LibertyGroup* library_group = root.children;
+    while (library_group && strcmp(library_group->type, "library") != 0) library_group = library_group->next;
+    if (parser.error || !library_group) {
+        if (!parser.error) fprintf(stderr, "No library group in %s\n", path);
+        free_liberty(library);
+        return NULL;
+    }
+
+    int cell_capacity = 0;
+    for (const LibertyGroup* group = library_group->children; group; group = group->next) {
+        if (strcmp(group->type, "cell") == 0) cell_capacity++;
+    }
+    library->cells = arena_alloc(&library->arena, (cell_capacity + 1) * sizeof(LibertyCell));
+    for (int t = 0; t <= GATE_DFF; t++) library->cell_for_type[t] = -1;
+
+    for (const LibertyGroup* cell_group = library_group->children; cell_group; cell_group = cell_group->next) {
+        if (strcmp(cell_group->type, "cell") != 0) continue;
+
+        LibertyCell* cell = &library->cells[library->cell_count];
+        memset(cell, 0, sizeof(LibertyCell));
+        cell->name = cell_group->name;
+        const char* function = NULL;
+        double worst_arc = -DBL_MAX;
+
+        for (const LibertyGroup* pin = cell_group->children; pin; pin = pin->next) {
+            if (strcmp(pin->type, "pin") != 0) continue;
+            const char* direction = liberty_attribute(pin, "direction");
+            if (direction && strcmp(direction, "input") == 0) {
+                const char* capacitance = liberty_attribute(pin, "capacitance");
+                cell->input_count++;
+                if (capacitance) cell->input_capacitance = fmax(cell->input_capacitance, atof(capacitance));
+
+                // Setup and hold constraints of a flip-flop's data pin
+                for (const LibertyGroup* timing = pin->children; timing; timing = timing->next) {
+                    const char* timing_type = liberty_attribute(timing, "timing_type");
+                    if (strcmp(timing->type, "timing") != 0 || !timing_type) continue;
+                    double* check = strstr(timing_type, "setup") ? &cell->setup_time :
+                                    strstr(timing_type, "hold") ? &cell->hold_time : NULL;
+                    for (const LibertyGroup* table = timing->children; table && check; table = table->next) {
+                        DelayTable constraint;
+                        if ((strcmp(table->type, "rise_constraint") != 0 && strcmp(table->type, "fall_constraint") != 0) ||
+                            read_delay_table(library_group, table, &constraint) != 0) continue;
+                        *check = fmax(*check, table_max(&constraint));
+                    }
+                }
+            } else if (direction && strcmp(direction, "output") == 0) {
+                function = liberty_attribute(pin, "function");
+                cell->output_pin = pin->name;
+
+                // Keep the arc with the largest average delay
+                for (const LibertyGroup* timing = pin->children; timing; timing = timing->next) {
+                    if (strcmp(timing->type, "timing") != 0) continue;
+                    LibertyCell arc;
+                    int found = 0;
+                    memset(&arc, 0, sizeof(arc));
+                    for (const LibertyGroup* table = timing->children; table; table = table->next) {
+                        DelayTable* target = NULL;
+                        if (strcmp(table->type, "cell_rise") == 0) target = &arc.cell_rise;
+                        else if (strcmp(table->type, "cell_fall") == 0) target = &arc.cell_fall;
+                        else if (strcmp(table->type, "rise_transition") == 0) target = &arc.rise_transition;
+                        else if (strcmp(table->type, "fall_transition") == 0) target = &arc.fall_transition;
+                        if (target && read_delay_table(library_group, table, target) == 0) found++;
+                    }
+                    if (found < 4) continue;
+
+                    double mean = table_mean(&arc.cell_rise) + table_mean(&arc.cell_fall);
+                    if (mean > worst_arc) {
+                        worst_arc = mean;
+                        cell->cell_rise = arc.cell_rise;
+                        cell->cell_fall = arc.cell_fall;
+                        cell->rise_transition = arc.rise_transition;
+                        cell->fall_transition = arc.fall_transition;
+                    }
+                }
+            }
+        }
+
+        int type = classify_function(function, cell->input_count);
+        for (const LibertyGroup* group = cell_group->children; group; group = group->next) {
+            if (strcmp(group->type, "ff") == 0) type = GATE_DFF;
+        }
+        if (type < 0 || worst_arc == -DBL_MAX) continue;
+        cell->type = type;
+
+        const DelayTable* tables[CELL_TABLE_COUNT] = {
+            &cell->cell_rise, &cell->cell_fall, &cell->rise_transition, &cell->fall_transition
+        };
+        cell->shared_index = 1;
+        for (int t = 1; t < CELL_TABLE_COUNT; t++) {
+            if (tables[t]->slew_count != tables[0]->slew_count ||
+                tables[t]->load_count != tables[0]->load_count ||
+                memcmp(tables[t]->slew_index, tables[0]->slew_index, tables[0]->slew_count * sizeof(double)) ||
+                memcmp(tables[t]->load_index, tables[0]->load_index, tables[0]->load_count * sizeof(double))) {
+                cell->shared_index = 0;
+            }
+        }
+
+        int current = library->cell_for_type[type];
+        if (current < 0 || cell->input_count < library->cells[current].input_count) {
+            library->cell_for_type[type] = library->cell_count;
+        }
+        library->cell_count++;
+    }
+
+    return library;
+}
+
+// Free a library returned by load_liberty()
+void free_liberty(CellLibrary* library) {
+    if (!library) return;
+    arena_release(&library->arena);
+    free(library);
+}
+
+// Lanes of one blend. Written as a vector type because GCC does not
+// vectorize the blend loop at -O2; without AVX it lowers to SSE2 pairs.
+#define BLEND_WIDTH 4
+typedef double BlendVector __attribute__((vector_size(BLEND_WIDTH * sizeof(double))));
+
+// Scratch space for one batch of table lookups. Interpolation weights and
+// the four corner values of each table are gathered per node, then blended
+// over whole arrays BLEND_WIDTH nodes per vector operation. Rows are
+// padded so the sixteen corner streams do not alias in the L1 cache.
+typedef struct {
+    double slew_weight[DELAY_BATCH_SIZE];
+    double load_weight[DELAY_BATCH_SIZE];
+    double corner[CELL_TABLE_COUNT][4][DELAY_BATCH_SIZE + DELAY_BATCH_PAD];
+    double result[CELL_TABLE_COUNT][DELAY_BATCH_SIZE];
+} DelayBatch;
+
+// Interval of a sorted index that brackets x, extrapolating past either end
+static inline int table_interval(const double* index, int count, double x, double* weight) {
+    if (count == 1) {
+        *weight = 0.0;
+        return 0;
+    }
+    int i = 0;
+    while (i < count - 2 && x > index[i + 1]) i++;
+    *weight = (x - index[i]) / (index[i + 1] - index[i]);
+    return i;
+}
+
+// Gather corners for all of a cell's tables. Tables normally share one
+// template, so the interval search is done once; a table with its own
+// indices is resolved exactly by scaling its corners into those weights.
+static inline void gather_cell(DelayBatch* batch, int k, const LibertyCell* cell, double slew, double load) {
+    const DelayTable* tables[CELL_TABLE_COUNT] = {
+        &cell->cell_rise, &cell->cell_fall, &cell->rise_transition, &cell->fall_transition
+    };
+    const DelayTable* first = tables[0];
+    double slew_weight, load_weight;
+    int row = table_interval(first->slew_index, first->slew_count, slew, &slew_weight);
+    int column = table_interval(first->load_index, first->load_count, load, &load_weight);
+    batch->slew_weight[k] = slew_weight;
+    batch->load_weight[k] = load_weight;
+
+    for (int t = 0; t < CELL_TABLE_COUNT; t++) {
+        const DelayTable* table = tables[t];
+        if (t > 0 && !cell->shared_index) {
+            // Evaluate directly and present it as a flat corner set
+            double s, l;
+            int r = table_interval(table->slew_index, table->slew_count, slew, &s);
+            int c = table_interval(table->load_index, table->load_count, load, &l);
+            int nr = table->slew_count > 1 ? r + 1 : r;
+            int nc = table->load_count > 1 ? c + 1 : c;
+            const double* v = table->values;
+            double low = v[r * table->load_count + c] + (v[r * table->load_count + nc] - v[r * table->load_count + c]) * l;
+            double high = v[nr * table->load_count + c] + (v[nr * table->load_count + nc] - v[nr * table->load_count + c]) * l;
+            double value = low + (high - low) * s;
+            for (int q = 0; q < 4; q++) batch->corner[t][q][k] = value;
+            continue;
+        }
+        int next_row = table->slew_count > 1 ? row + 1 : row;
+        int next_column = table->load_count > 1 ? column + 1 : column;
+        const double* values = table->values;
+        batch->corner[t][0][k] = values[row * table->load_count + column];
+        batch->corner[t][1][k] = values[row * table->load_count + next_column];
+        batch->corner[t][2][k] = values[next_row * table->load_count + column];
+        batch->corner[t][3][k] = values[next_row * table->load_count + next_column];
+    }
+}
+
+// Bilinear blend of gathered corners for one table kind
+static void blend_corners(int count, const double* restrict slew_weight, const double* restrict load_weight,
+                          const double* restrict corner00, const double* restrict corner01,
+                          const double* restrict corner10, const double* restrict corner11,
+                          double* restrict result) {
+    int k = 0;
+    for (; k + BLEND_WIDTH <= count; k += BLEND_WIDTH) {
+        BlendVector c00, c01, c10, c11, load, slew;
+        memcpy(&c00, corner00 + k, sizeof(c00));
+        memcpy(&c01, corner01 + k, sizeof(c01));
+        memcpy(&c10, corner10 + k, sizeof(c10));
+        memcpy(&c11, corner11 + k, sizeof(c11));
+        memcpy(&load, load_weight + k, sizeof(load));
+        memcpy(&slew, slew_weight + k, sizeof(slew));
+        BlendVector low = c00 + (c01 - c00) * load;
+        BlendVector high = c10 + (c11 - c10) * load;
+        BlendVector value = low + (high - low) * slew;
+        memcpy(result + k, &value, sizeof(value));
+    }
+    for (; k < count; k++) {
+        double low = corner00[k] + (corner01[k] - corner00[k]) * load_weight[k];
+        double high = corner10[k] + (corner11[k] - corner10[k]) * load_weight[k];
+        result[k] = low + (high - low) * slew_weight[k];
+    }
+}
+
+// Evaluate every table of every cell in a batch
+static void lookup_batch(DelayBatch* batch, int count, const LibertyCell* const* cells,
+                         const double* slew, const double* load) {
+    for (int k = 0; k < count; k++) {
+        gather_cell(batch, k, cells[k], slew[k], load[k]);
+    }
+    for (int t = 0; t < CELL_TABLE_COUNT; t++) {
+        blend_corners(count, batch->slew_weight, batch->load_weight,
+                      batch->corner[t][0], batch->corner[t][1], batch->corner[t][2], batch->corner[t][3],
+                      batch->result[t]);
+    }
+}
+
+// Library cell mapped to a gate type, or -1 for ports and unmapped types
+static int library_cell_for(const CellLibrary* library, int type) {
+    return type == INPUT || type == OUTPUT ? -1 : library->cell_for_type[type];
+}
+
+// Write NLDM rise and fall delays from the given library into delay[],
+// and each node's output load and slew into load[] and slew[]. Loads come
+// from fan-out pin capacitance plus a wire load per fan-out; slews are
+// propagated level by level (worst fan-in slew), and each level is
+// evaluated in batches. Nodes the library does not cover keep their value.
+static void annotate_delays(Circuit* circuit, const CellLibrary* library, double* const delay[TRANSITION_COUNT],
+                            double* load, double* slew) {
+    int n = circuit->node_count;
+    const unsigned char* type = circuit->type;
+
+    // Load each gate type presents on the net driving it
+    double pin_load[GATE_DFF + 1];
+    for (int t = 0; t <= GATE_DFF; t++) {
+        int cell = library_cell_for(library, t);
+        pin_load[t] = WIRE_LOAD_PER_FANOUT;
+        if (cell >= 0) pin_load[t] += library->cells[cell].input_capacitance;
+        if (t == OUTPUT) pin_load[t] += OUTPUT_PORT_LOAD;
+    }
+
+    for (int i = 0; i < n; i++) {
+        double total = 0.0;
+        for (int j = circuit->fanout_start[i]; j < circuit->fanout_start[i + 1]; j++) {
+            total += pin_load[type[circuit->fanout[j]]];
+        }
+        load[i] = total;
+    }
+    for (int k = 0; k < circuit->disabled_count; k++) {
+        load[circuit->disabled_source[k]] += pin_load[type[circuit->disabled_destination[k]]];
+    }
+
+    DelayBatch* batch = malloc(sizeof(DelayBatch));
+    NodeId* batch_nodes = malloc(DELAY_BATCH_SIZE * sizeof(NodeId));
+    const LibertyCell** batch_cells = malloc(DELAY_BATCH_SIZE * sizeof(LibertyCell*));
+    double* batch_slew = malloc(DELAY_BATCH_SIZE * sizeof(double));
+    double* batch_load = malloc(DELAY_BATCH_SIZE * sizeof(double));
+
+    // Flip-flops switch on the (ideal) clock rather than their D input, and
+    // their fan-out may sit on an earlier level, so pass 0 evaluates every
+    // flip-flop from the clock slew before pass 1 walks the levels
+    for (int pass = 0; pass < 2; pass++) {
+        int range_count = pass == 0 ? 1 : circuit->level_count;
+        for (int range = 0; range < range_count; range++) {
+            int begin = pass == 0 ? 0 : circuit->level_start[range];
+            int end = pass == 0 ? n : circuit->level_start[range + 1];
+
+            while (begin < end) {
+                int count = 0;
+                for (; begin < end && count < DELAY_BATCH_SIZE; begin++) {
+                    NodeId node = circuit->level_order[begin];
+                    int sequential = type[node] == GATE_DFF;
+                    if (sequential != (pass == 0)) continue;
+
+                    double input_slew = type[node] == INPUT || sequential ? DEFAULT_INPUT_SLEW : 0.0;
+                    for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1] && !sequential; j++) {
+                        input_slew = fmax(input_slew, slew[circuit->fanin[j]]);
+                    }
+
+                    int cell = library_cell_for(library, type[node]);
+                    if (cell < 0) {
+                        // Ports and unmapped gates pass their input slew through
+                        slew[node] = input_slew;
+                        continue;
+                    }
+                    batch_nodes[count] = node;
+                    batch_cells[count] = &library->cells[cell];
+                    batch_slew[count] = input_slew;
+                    batch_load[count] = load[node];
+                    count++;
+                }
+
+                lookup_batch(batch, count, batch_cells, batch_slew, batch_load);
+                for (int k = 0; k < count; k++) {
+                    delay[TRANSITION_RISE][batch_nodes[k]] = batch->result[0][k];
+                    delay[TRANSITION_FALL][batch_nodes[k]] = batch->result[1][k];
+                    slew[batch_nodes[k]] = fmax(batch->result[2][k], batch->result[3][k]);
+                }
+            }
+        }
+    }
+
+    free(batch);
+    free(batch_nodes);
+    free(batch_cells);
+    free(batch_slew);
+    free(batch_load);
+}
+
+// Compute gate delays from the cell library. Without a library the fixed
+// per-type delays are left untouched.
+void compute_delays(Circuit* circuit) {
+    TRACE_SCOPE("compute_delays");
+    if (!circuit->library) return;
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return;
+    circuit->load = grow_array(circuit->load, circuit->node_count + 1, sizeof(double));
+    circuit->slew = grow_array(circuit->slew, circuit->node_count + 1, sizeof(double));
+    annotate_delays(circuit, circuit->library, circuit->delay, circuit->load, circuit->slew);
+
+    // Flip-flop checks come from the library's flip-flop cell when it has one
+    int flop = circuit->library->cell_for_type[GATE_DFF];
+    if (flop >= 0) {
+        circuit->setup_time = circuit->library->cells[flop].setup_time;
+        circuit->hold_time = circuit->library->cells[flop].hold_time;
+    }
+
+    // Every delay may have moved, so the next update must be a full one
+    circuit->timing_valid = 0;
+}
+
+// Arrival at a node's inputs of the transition that makes its output
+// switch in direction t. Non-unate gates take the worse input transition
+// (the later one for late analysis, the earlier one for early).
+static inline double source_arrival(const Circuit* circuit, double* const arrival[TRANSITION_COUNT],
+                                    NodeId node, int t, int late) {
+    switch (gate_unateness[circuit->type[node]]) {
+        case UNATE_POSITIVE: return arrival[t][node];
+        case UNATE_NEGATIVE: return arrival[!t][node];
+        default:
+            return late ? fmax(arrival[TRANSITION_RISE][node], arrival[TRANSITION_FALL][node])
+                        : fmin(arrival[TRANSITION_RISE][node], arrival[TRANSITION_FALL][node]);
+    }
+}
+
+// Time a node's output transition t starts from: a flip-flop launches
+// both transitions on the clock edge at time zero, anything else when the
+// causing input transition arrives
+static inline double launch_time(const Circuit* circuit, double* const arrival[TRANSITION_COUNT],
+                                 NodeId node, int t, int late) {
+    return circuit->type[node] == GATE_DFF ? 0.0 : source_arrival(circuit, arrival, node, t, late);
+}
+
+// Tag of lane k at node; lane EXCEPTION_TAG_LANES holds the tag being merged
+static inline uint64_t* lane_tag(const Circuit* circuit, NodeId node, int k) {
+    return circuit->tag + ((size_t)node * (EXCEPTION_TAG_LANES + 1) + k) * circuit->tag_words;
+}
+
+static inline int tag_has(const uint64_t* tag, int bit) {
+    return tag[bit >> 6] >> (bit & 63) & 1;
+}
+
+// Whether tag shares a bit with mask
+static inline int tag_meets(const Circuit* circuit, const uint64_t* tag, const uint64_t* mask) {
+    for (int w = 0; w < circuit->tag_words; w++) {
+        if (tag[w] & mask[w]) return 1;
+    }
+    return 0;
+}
+
+// Advance a path tag into node: a stage bit moves up one when node is in
+// that exception's next through list. Going down the node's bits lets a
+// bit move only from where it was before this node.
+static inline void advance_tag(const Circuit* circuit, uint64_t* tag, NodeId node) {
+    const ExceptionBits* through = &circuit->exception_through;
+    for (int i = through->start[node + 1] - 1; i >= through->start[node]; i--) {
+        int bit = through->bit[i];
+        if (!tag_has(tag, bit - 1)) continue;
+        tag[(bit - 1) >> 6] &= ~(1ULL << ((bit - 1) & 63));
+        tag[bit >> 6] |= 1ULL << (bit & 63);
+    }
+}
+
+// Tag of a path starting at node
+static inline void start_tag(const Circuit* circuit, uint64_t* tag, NodeId node) {
+    const ExceptionBits* start = &circuit->exception_start;
+    memcpy(tag, circuit->exception_any_start, circuit->tag_words * sizeof(uint64_t));
+    for (int i = start->start[node]; i < start->start[node + 1]; i++) {
+        tag[start->bit[i] >> 6] |= 1ULL << (start->bit[i] & 63);
+    }
+    advance_tag(circuit, tag, node);
+}
+
+// Whether a path carrying tag is false when it ends at endpoint
+static inline int tag_is_false(const Circuit* circuit, const uint64_t* tag, NodeId endpoint) {
+    if (tag_meets(circuit, tag, circuit->exception_dead)) return 1;
+    const ExceptionBits* end = &circuit->exception_end;
+    for (int i = end->start[endpoint]; i < end->start[endpoint + 1]; i++) {
+        if (tag_has(tag, end->bit[i]) && tag_has(circuit->exception_false, end->bit[i])) return 1;
+    }
+    return 0;
+}
+
+// Merge the tag in a node's extra lane, arriving at time, into its lanes.
+// A tag already present keeps the later arrival. When every lane is taken
+// the arrival joins the last lane under the bits both tags share, so the
+// merged lane can only lose exceptions, never gain one.
+static inline void add_tag_lane(const Circuit* circuit, NodeId node, int* count,
+                                const double time[TRANSITION_COUNT]) {
+    size_t base = (size_t)node * EXCEPTION_TAG_LANES;
+    size_t bytes = circuit->tag_words * sizeof(uint64_t);
+    const uint64_t* tag = lane_tag(circuit, node, EXCEPTION_TAG_LANES);
+    int k = 0;
+    while (k < *count && memcmp(lane_tag(circuit, node, k), tag, bytes) != 0) k++;
+    if (k == *count && k < EXCEPTION_TAG_LANES) {
+        memcpy(lane_tag(circuit, node, k), tag, bytes);
+        for (int t = 0; t < TRANSITION_COUNT; t++) circuit->tag_arrival[t][base + k] = time[t];
+        (*count)++;
+        return;
+    }
+    if (k == EXCEPTION_TAG_LANES) {
+        k--;
+        uint64_t* merged = lane_tag(circuit, node, k);
+        for (int w = 0; w < circuit->tag_words; w++) merged[w] &= tag[w];
+    }
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        circuit->tag_arrival[t][base + k] = fmax(circuit->tag_arrival[t][base + k], time[t]);
+    }
+}
+
+// Tagged arrivals at a node's inputs, one lane per distinct tag. A
+// startpoint has a single lane holding its start tag and the arrival in
+// late; any other node advances every fan-in lane into itself, dropping
+// lanes that complete a false path without -to. late becomes the latest
+// lane, leaving out lanes that are false paths ending at this node.
+static void tagged_arrival(const Circuit* circuit, NodeId node, double late[TRANSITION_COUNT]) {
+    size_t base = (size_t)node * EXCEPTION_TAG_LANES;
+    uint64_t* tag = lane_tag(circuit, node, EXCEPTION_TAG_LANES);
+    const uint64_t* dead = circuit->exception_dead;
+    int count = 0;
+
+    if (circuit->fanin_start[node] == circuit->fanin_start[node + 1]) {
+        start_tag(circuit, tag, node);
+        if (!tag_meets(circuit, tag, dead)) add_tag_lane(circuit, node, &count, late);
+    }
+    for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1]; j++) {
+        NodeId input = circuit->fanin[j];
+        double time[TRANSITION_COUNT];
+        if (circuit->type[input] == GATE_DFF) {
+            // A flip-flop launches a new path on the clock
+            start_tag(circuit, tag, input);
+            advance_tag(circuit, tag, node);
+            for (int t = 0; t < TRANSITION_COUNT; t++) time[t] = circuit->delay[t][input];
+            if (!tag_meets(circuit, tag, dead)) add_tag_lane(circuit, node, &count, time);
+            continue;
+        }
+
+        size_t input_base = (size_t)input * EXCEPTION_TAG_LANES;
+        for (int k = 0; k < circuit->tag_count[input]; k++) {
+            double rise = circuit->tag_arrival[TRANSITION_RISE][input_base + k];
+            double fall = circuit->tag_arrival[TRANSITION_FALL][input_base + k];
+            switch (gate_unateness[circuit->type[input]]) {
+                case UNATE_POSITIVE: time[TRANSITION_RISE] = rise; time[TRANSITION_FALL] = fall; break;
+                case UNATE_NEGATIVE: time[TRANSITION_RISE] = fall; time[TRANSITION_FALL] = rise; break;
+                default: time[TRANSITION_RISE] = time[TRANSITION_FALL] = fmax(rise, fall); break;
+            }
+            for (int t = 0; t < TRANSITION_COUNT; t++) time[t] += circuit->delay[t][input];
+            memcpy(tag, lane_tag(circuit, input, k), circuit->tag_words * sizeof(uint64_t));
+            advance_tag(circuit, tag, node);
+            if (!tag_meets(circuit, tag, dead)) add_tag_lane(circuit, node, &count, time);
+        }
+    }
+    circuit->tag_count[node] = count;
+
+    int endpoint = circuit->type[node] == OUTPUT || circuit->type[node] == GATE_DFF;
+    late[TRANSITION_RISE] = late[TRANSITION_FALL] = 0.0;
+    for (int k = 0; k < count; k++) {
+        if (endpoint && tag_is_false(circuit, lane_tag(circuit, node, k), node)) continue;
+        for (int t = 0; t < TRANSITION_COUNT; t++) late[t] = fmax(late[t], circuit->tag_arrival[t][base + k]);
+    }
+}
+
+// Rise and fall arrival times at a node's inputs: the latest fan-in output
+// of each transition. The earliest are returned through early for hold
+// checks. A flip-flop's own arrival is the data arrival at its D pin.
+// With exceptions the latest comes from the tagged lanes instead.
+static inline void node_arrival(const Circuit* circuit, NodeId node,
+                                double late[TRANSITION_COUNT], double early[TRANSITION_COUNT]) {
+    if (circuit->type[node] == INPUT) {
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            late[t] = circuit->port_delay[node];
+            early[t] = circuit->port_delay[node];
+        }
+        if (circuit->exception_count > 0) tagged_arrival(circuit, node, late);
+        return;
+    }
+
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        const double* delay = circuit->delay[t];
+        double max_input_arrival = 0.0;
+        double min_input_arrival = DBL_MAX;
+        for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1]; j++) {
+            NodeId input = circuit->fanin[j];
+            max_input_arrival = fmax(max_input_arrival,
+                                     launch_time(circuit, circuit->arrival_time, input, t, 1) + delay[input]);
+            min_input_arrival = fmin(min_input_arrival,
+                                     launch_time(circuit, circuit->early_arrival, input, t, 0) + delay[input]);
+        }
+        late[t] = max_input_arrival;
+        early[t] = min_input_arrival == DBL_MAX ? 0.0 : min_input_arrival;
+    }
+    if (circuit->exception_count > 0) tagged_arrival(circuit, node, late);
+}
+
+// Latest arrival of either transition
+static inline double worst_arrival(const Circuit* circuit, NodeId node) {
+    return fmax(circuit->arrival_time[TRANSITION_RISE][node], circuit->arrival_time[TRANSITION_FALL][node]);
+}
+
+// Time an endpoint's data must settle ahead of the required reference:
+// an OUTPUT's external delay or a flip-flop's setup time
+static inline double endpoint_margin(const Circuit* circuit, NodeId node) {
+    if (circuit->type[node] == GATE_DFF) return circuit->setup_time;
+    if (circuit->type[node] == OUTPUT) return circuit->port_delay[node];
+    return 0.0;
+}
+
+// Hold slack at a flip-flop's D pin: the earliest data launched by the
+// same clock edge must not arrive within the hold window
+static inline double hold_slack(const Circuit* circuit, NodeId node) {
+    return fmin(circuit->early_arrival[TRANSITION_RISE][node],
+                circuit->early_arrival[TRANSITION_FALL][node]) - circuit->hold_time;
+}
+
+// Required time of every endpoint before its margin: the clock period,
+// or without a clock the worst endpoint so the critical path has zero slack
+static double endpoint_reference(const Circuit* circuit) {
+    if (circuit->clock_period > 0.0) return circuit->clock_period;
+
+    double max_arrival_time = 0.0;
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        NodeId endpoint = circuit->endpoints[i];
+        max_arrival_time = fmax(max_arrival_time, worst_arrival(circuit, endpoint) + endpoint_margin(circuit, endpoint));
+    }
+    return max_arrival_time;
+}
+// Fold the exception owning a completed final bit into a requirement
+static inline void apply_exception(const TimingException* exception, int* false_path,
+                                   double* max_delay, double* cycles) {
+    switch (exception->type) {
+        case EXCEPTION_FALSE_PATH: *false_path = 1; break;
+        case EXCEPTION_MAX_DELAY: *max_delay = fmin(*max_delay, exception->value); break;
+        case EXCEPTION_MULTICYCLE: *cycles = *cycles > 1.0 ? fmin(*cycles, exception->value) : exception->value; break;
+    }
+}
+
+// Required time at an endpoint of paths carrying tag: a false path is
+// unconstrained (DBL_MAX), set_max_delay replaces the clock requirement
+// and set_multicycle_path N allows N periods. Without a clock a cycle is
+// the required reference.
+static double exception_required(const Circuit* circuit, NodeId endpoint, const uint64_t* tag) {
+    double margin = endpoint_margin(circuit, endpoint);
+    double max_delay = DBL_MAX;
+    double cycles = 1.0;
+    int false_path = 0;
+    for (int w = 0; w < circuit->tag_words; w++) {
+        for (uint64_t complete = tag[w] & circuit->exception_any_end[w]; complete; complete &= complete - 1) {
+            int bit = w * 64 + __builtin_ctzll(complete);
+            apply_exception(&circuit->exceptions[circuit->exception_of_bit[bit]], &false_path, &max_delay, &cycles);
+        }
+    }
+    const ExceptionBits* end = &circuit->exception_end;
+    for (int i = end->start[endpoint]; i < end->start[endpoint + 1]; i++) {
+        if (!tag_has(tag, end->bit[i])) continue;
+        apply_exception(&circuit->exceptions[circuit->exception_of_bit[end->bit[i]]], &false_path, &max_delay, &cycles);
+    }
+    if (false_path) return DBL_MAX;
+    if (max_delay < DBL_MAX) return max_delay - margin;
+    return circuit->required_reference * cycles - margin;
+}
+
+// Tightest required time over an endpoint's lanes, DBL_MAX if every path
+// to it is false
+static double exception_required_bound(const Circuit* circuit, NodeId endpoint) {
+    double bound = DBL_MAX;
+    for (int k = 0; k < circuit->tag_count[endpoint]; k++) {
+        bound = fmin(bound, exception_required(circuit, endpoint, lane_tag(circuit, endpoint, k)));
+    }
+    return bound;
+}
+
+// Endpoint slack with every lane checked against its own requirement
+static double exception_slack(const Circuit* circuit, NodeId endpoint) {
+    size_t base = (size_t)endpoint * EXCEPTION_TAG_LANES;
+    double slack = DBL_MAX;
+    for (int k = 0; k < circuit->tag_count[endpoint]; k++) {
+        double required = exception_required(circuit, endpoint, lane_tag(circuit, endpoint, k));
+        if (required == DBL_MAX) continue;
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            slack = fmin(slack, required - circuit->tag_arrival[t][base + k]);
+        }
+    }
+    return slack;
+}
+
+// Rise and fall required times at a node's inputs: the tightest fan-out
+// requirement of each output transition, mapped back through the gate's
+// unateness to the input transition that causes it. With exceptions an
+// endpoint requires the tightest of its lanes' required times.
+static inline void node_required(const Circuit* circuit, NodeId node, double required[TRANSITION_COUNT]) {
+    if (circuit->type[node] == OUTPUT || circuit->type[node] == GATE_DFF) {
+        double value = circuit->exception_count > 0 ? exception_required_bound(circuit, node)
+                                                    : circuit->required_reference - endpoint_margin(circuit, node);
+        required[TRANSITION_RISE] = value;
+        required[TRANSITION_FALL] = value;
+        return;
+    }
+
+    double output[TRANSITION_COUNT];
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        const double* fanout_required = circuit->required_time[t];
+        double node_required_time = DBL_MAX;
+        for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+            node_required_time = fmin(node_required_time, fanout_required[circuit->fanout[j]]);
+        }
+        output[t] = node_required_time == DBL_MAX ? DBL_MAX : node_required_time - circuit->delay[t][node];
+    }
+
+    switch (gate_unateness[circuit->type[node]]) {
+        case UNATE_POSITIVE:
+            required[TRANSITION_RISE] = output[TRANSITION_RISE];
+            required[TRANSITION_FALL] = output[TRANSITION_FALL];
+            break;
+        case UNATE_NEGATIVE:
+            required[TRANSITION_RISE] = output[TRANSITION_FALL];
+            required[TRANSITION_FALL] = output[TRANSITION_RISE];
+            break;
+        default:
+            required[TRANSITION_RISE] = fmin(output[TRANSITION_RISE], output[TRANSITION_FALL]);
+            required[TRANSITION_FALL] = required[TRANSITION_RISE];
+            break;
+    }
+}
+
+// Slack of a node: the worse of its rise and fall slack. With exceptions
+// an endpoint's slack is exact per lane; other nodes see the tightest
+// endpoint requirement against the latest live arrival, which can only
+// be pessimistic.
+static inline double node_slack(const Circuit* circuit, NodeId node) {
+    if (circuit->exception_count > 0 && (circuit->type[node] == OUTPUT || circuit->type[node] == GATE_DFF)) {
+        return exception_slack(circuit, node);
+    }
+    return fmin(circuit->required_time[TRANSITION_RISE][node] - circuit->arrival_time[TRANSITION_RISE][node],
+                circuit->required_time[TRANSITION_FALL][node] - circuit->arrival_time[TRANSITION_FALL][node]);
+}
+
+// Evaluate level_order[begin .. end - 1] in one direction
+static void propagate_range(Circuit* circuit, int direction, int begin, int end) {
+    const NodeId* order = circuit->level_order;
+    double value[TRANSITION_COUNT], early[TRANSITION_COUNT];
+    if (direction == PROPAGATE_FORWARD) {
+        for (int i = begin; i < end; i++) {
+            node_arrival(circuit, order[i], value, early);
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                circuit->arrival_time[t][order[i]] = value[t];
+                circuit->early_arrival[t][order[i]] = early[t];
+            }
+        }
+    } else {
+        for (int i = end - 1; i >= begin; i--) {
+            node_required(circuit, order[i], value);
+            circuit->required_time[TRANSITION_RISE][order[i]] = value[TRANSITION_RISE];
+            circuit->required_time[TRANSITION_FALL][order[i]] = value[TRANSITION_FALL];
+        }
+    }
+}
+
+// Evaluates level_order[begin .. end - 1] in one direction
+typedef void (*PropagateRange)(Circuit* circuit, int direction, int begin, int end);
+
+// Shared state for one level-parallel propagation
+typedef struct {
+    Circuit* circuit;
+    int direction;
+    PropagateRange range;
+    int thread_count;        // Threads taking part, settled before ready is set
+    pthread_barrier_t barrier;
+    pthread_mutex_t lock;
+    pthread_cond_t ready_signal;
+    int ready;
+} PropagationJob;
+
+typedef struct {
+    PropagationJob* job;
+    int thread_index;
+} PropagationWorker;
+
+// Every thread walks the same level sequence. A level at least
+// PARALLEL_MIN_LEVEL_WIDTH wide is split into equal contiguous slices; a
+// run of narrower levels is handled by thread 0 alone so deep, narrow
+// designs do not pay a barrier per level. Each node only reads values
+// from earlier levels, so the result is identical to the serial sweep.
+static void* propagation_worker(void* argument) {
+    PropagationWorker* worker = argument;
+    PropagationJob* job = worker->job;
+    pthread_mutex_lock(&job->lock);
+    while (!job->ready) pthread_cond_wait(&job->ready_signal, &job->lock);
+    pthread_mutex_unlock(&job->lock);
+    if (worker->thread_index >= job->thread_count) return NULL;
+
+    Circuit* circuit = job->circuit;
+    const int* level_start = circuit->level_start;
+    int level_count = circuit->level_count;
+    int forward = job->direction == PROPAGATE_FORWARD;
+
+    int step = 0;
+    while (step < level_count) {
+        int level = forward ? step : level_count - 1 - step;
+        int width = level_start[level + 1] - level_start[level];
+
+        if (width < PARALLEL_MIN_LEVEL_WIDTH) {
+            // Extend over the whole run of narrow levels
+            int last = step;
+            while (last + 1 < level_count) {
+                int next = forward ? last + 1 : level_count - 2 - last;
+                if (level_start[next + 1] - level_start[next] >= PARALLEL_MIN_LEVEL_WIDTH) break;
+                last++;
+            }
+            if (worker->thread_index == 0) {
+                int first_level = forward ? step : level_count - 1 - last;
+                int last_level = forward ? last : level_count - 1 - step;
+                job->range(circuit, job->direction,
+                           level_start[first_level], level_start[last_level + 1]);
+            }
+            step = last + 1;
+        } else {
+            long long begin = level_start[level];
+            int slice_begin = begin + width * (long long)worker->thread_index / job->thread_count;
+            int slice_end = begin + width * (long long)(worker->thread_index + 1) / job->thread_count;
+            job->range(circuit, job->direction, slice_begin, slice_end);
+            step++;
+        }
+
+        pthread_barrier_wait(&job->barrier);
+    }
+    return NULL;
+}
+
+// Run one propagation over the levelized schedule, in parallel when the
+// circuit was configured with more than one thread. Workers wait until
+// every thread has been started, so a thread that fails to start only
+// shrinks the barrier; if the barrier cannot be set up the started
+// threads leave and the sweep runs serially.
+static void propagate_levels(Circuit* circuit, int direction, PropagateRange range) {
+    int thread_count = circuit->thread_count;
+    if (thread_count <= 1 || circuit->node_count < PARALLEL_MIN_LEVEL_WIDTH) {
+        range(circuit, direction, 0, circuit->node_count);
+        return;
+    }
+
+    PropagationJob job;
+    job.circuit = circuit;
+    job.direction = direction;
+    job.range = range;
+    job.thread_count = 1;
+    job.ready = 0;
+    pthread_mutex_init(&job.lock, NULL);
+    pthread_cond_init(&job.ready_signal, NULL);
+
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    PropagationWorker* workers = malloc(thread_count * sizeof(PropagationWorker));
+    for (int t = 0; t < thread_count; t++) {
+        workers[t].job = &job;
+        workers[t].thread_index = t;
+    }
+    int started = 1;
+    while (started < thread_count &&
+           pthread_create(&threads[started], NULL, propagation_worker, &workers[started]) == 0) {
+        started++;
+    }
+    int parallel = started > 1 && pthread_barrier_init(&job.barrier, NULL, started) == 0;
+
+    pthread_mutex_lock(&job.lock);
+    job.thread_count = parallel ? started : 1;
+    job.ready = 1;
+    pthread_cond_broadcast(&job.ready_signal);
+    pthread_mutex_unlock(&job.lock);
+
+    if (parallel) propagation_worker(&workers[0]);
+    else range(circuit, direction, 0, circuit->node_count);
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    if (parallel) pthread_barrier_destroy(&job.barrier);
+    pthread_cond_destroy(&job.ready_signal);
+    pthread_mutex_destroy(&job.lock);
+    free(threads);
+    free(workers);
+}
+
+// Processes items [begin, end) of a batch job on one worker
+typedef void (*BatchRange)(void* context, int worker, int begin, int end);
+
+// Shared state for a batch of independent items
+typedef struct {
+    BatchRange range;
+    void* context;
+    int item_count;
+    int chunk;               // Consecutive items claimed at a time
+    int next;                // First unclaimed item
+} BatchJob;
+
+typedef struct {
+    BatchJob* job;
+    int worker;
+} BatchWorker;
+
+// Workers claim chunks until none are left, so a few expensive items do
+// not leave the other threads idle
+static void* batch_worker(void* argument) {
+    BatchWorker* worker = argument;
+    BatchJob* job = worker->job;
+    for (;;) {
+        int begin = __atomic_fetch_add(&job->next, job->chunk, __ATOMIC_RELAXED);
+        if (begin >= job->item_count) break;
+        int end = begin + job->chunk < job->item_count ? begin + job->chunk : job->item_count;
+        job->range(job->context, worker->worker, begin, end);
+    }
+    return NULL;
+}
+
+// Run range over items [0, item_count) on up to thread_count threads.
+// Worker indices are below thread_count, for per-worker scratch space.
+static void run_batch(int thread_count, int item_count, int chunk, BatchRange range, void* context) {
+    if (thread_count <= 1 || item_count <= chunk) {
+        if (item_count > 0) range(context, 0, 0, item_count);
+        return;
+    }
+
+    BatchJob job = {range, context, item_count, chunk, 0};
+    pthread_t* threads = malloc(thread_count * sizeof(pthread_t));
+    BatchWorker* workers = malloc(thread_count * sizeof(BatchWorker));
+    for (int t = 0; t < thread_count; t++) {
+        workers[t].job = &job;
+        workers[t].worker = t;
+    }
+    // Workers claim items as they go, so threads that fail to start only
+    // leave more work for the others
+    int started = 1;
+    while (started < thread_count &&
+           pthread_create(&threads[started], NULL, batch_worker, &workers[started]) == 0) {
+        started++;
+    }
+    batch_worker(&workers[0]);
+    for (int t = 1; t < started; t++) {
+        pthread_join(threads[t], NULL);
+    }
+    free(threads);
+    free(workers);
+}
+
+// Count (pass 0) or place (pass 1) one bit in a node's exception bit list
+static inline void exception_bits_add(ExceptionBits* list, int pass, NodeId node, int bit) {
+    if (pass == 0) list->start[node + 1]++;
+    else list->bit[list->start[node]++] = bit;
+}
+
+// Build the per-node exception bit lists and masks and size the tag
+// lanes, again whenever nodes or exceptions were added since the last build
+static void prepare_exceptions(Circuit* circuit) {
+    int n = circuit->node_count;
+    if (circuit->exception_nodes == n) return;
+
+    int words = (circuit->exception_bits + 63) / 64;
+    free_exception_masks(circuit);
+    free(circuit->tag_count);
+    free(circuit->tag);
+    circuit->tag_words = words;
+    ExceptionBits* lists[] = {&circuit->exception_start, &circuit->exception_through, &circuit->exception_end};
+    for (int l = 0; l < 3; l++) lists[l]->start = calloc(n + 1, sizeof(int));
+    circuit->exception_any_start = calloc(words, sizeof(uint64_t));
+    circuit->exception_any_end = calloc(words, sizeof(uint64_t));
+    circuit->exception_false = calloc(words, sizeof(uint64_t));
+    circuit->exception_dead = calloc(words, sizeof(uint64_t));
+    circuit->exception_of_bit = grow_array(NULL, circuit->exception_bits, sizeof(int));
+    circuit->tag_count = calloc(n + 1, 1);
+    circuit->tag = grow_array(NULL, ((size_t)n * (EXCEPTION_TAG_LANES + 1) + 1) * words, sizeof(uint64_t));
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        free(circuit->tag_arrival[t]);
+        circuit->tag_arrival[t] = grow_array(NULL, (size_t)n * EXCEPTION_TAG_LANES + 1, sizeof(double));
+    }
+    if (!circuit->exception_start.start || !circuit->exception_through.start || !circuit->exception_end.start ||
+        !circuit->exception_any_start || !circuit->exception_any_end || !circuit->exception_false ||
+        !circuit->exception_dead || !circuit->tag_count) {
+        fprintf(stderr, "Out of memory building timing exceptions\n");
+        exit(1);
+    }
+
+    for (int x = 0; x < circuit->exception_count; x++) {
+        const TimingException* exception = &circuit->exceptions[x];
+        int first = exception->first_bit;
+        int final = first + exception->through_count;
+        for (int bit = first; bit <= final; bit++) circuit->exception_of_bit[bit] = x;
+        if (exception->from_count == 0) circuit->exception_any_start[first >> 6] |= 1ULL << (first & 63);
+        if (exception->to_count == 0) circuit->exception_any_end[final >> 6] |= 1ULL << (final & 63);
+        if (exception->type == EXCEPTION_FALSE_PATH) circuit->exception_false[final >> 6] |= 1ULL << (final & 63);
+    }
+    for (int w = 0; w < words; w++) {
+        circuit->exception_dead[w] = circuit->exception_false[w] & circuit->exception_any_end[w];
+    }
+
+    // Bits go in exception order, so every node's list comes out ascending
+    for (int pass = 0; pass < 2; pass++) {
+        for (int x = 0; x < circuit->exception_count; x++) {
+            const TimingException* exception = &circuit->exceptions[x];
+            int first = exception->first_bit;
+            for (int i = 0; i < exception->from_count; i++) {
+                exception_bits_add(&circuit->exception_start, pass, exception->from[i], first);
+            }
+            for (int g = 0; g < exception->through_count; g++) {
+                for (int i = exception->through_start[g]; i < exception->through_start[g + 1]; i++) {
+                    exception_bits_add(&circuit->exception_through, pass, exception->through[i], first + g + 1);
+                }
+            }
+            for (int i = 0; i < exception->to_count; i++) {
+                exception_bits_add(&circuit->exception_end, pass, exception->to[i], first + exception->through_count);
+            }
+        }
+        for (int l = 0; l < 3; l++) {
+            int* start = lists[l]->start;
+            if (pass == 0) {
+                for (int i = 0; i < n; i++) start[i + 1] += start[i];
+                lists[l]->bit = grow_array(NULL, start[n] + 1, sizeof(int));
+            } else {
+                // Placing moved each start to the next node's; shift them back
+                memmove(start + 1, start, n * sizeof(int));
+                start[0] = 0;
+            }
+        }
+    }
+    circuit->exception_nodes = n;
+}
+
+// Compute arrival times for all nodes (forward traversal)
+void compute_arrival_times(Circuit* circuit) {
+    TRACE_SCOPE("compute_arrival_times");
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return;
+    if (circuit->exception_count > 0) prepare_exceptions(circuit);
+
+    // Single sweep in topological order: every fan-in is final before use
+    propagate_levels(circuit, PROPAGATE_FORWARD, propagate_range);
+    circuit->arrival_dirty.count = 0;
+}
+
+// Compute required times (backward traversal)
+void compute_required_times(Circuit* circuit) {
+    TRACE_SCOPE("compute_required_times");
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return;
+
+    // Every endpoint is required by the clock period, or without a clock
+    // by the worst endpoint arrival (critical path)
+    circuit->required_reference = endpoint_reference(circuit);
+    circuit->required_dirty.count = 0;
+
+    // Backward traversal in reverse topological order
+    propagate_levels(circuit, PROPAGATE_BACKWARD, propagate_range);
+}
+
+// Compute slack for each node
+void compute_slack(Circuit* circuit) {
+    TRACE_SCOPE("compute_slack");
+    for (int i = 0; i < circuit->node_count; i++) {
+        circuit->slack[i] = node_slack(circuit, i);
+    }
+    circuit->timing_valid = 1;
+}
+
+// Binary heap of node indices ordered by level (min-heap for forward
+// propagation, max-heap for backward)
+static int level_before(const int* level, NodeId a, NodeId b, int max_heap) {
+    return max_heap ? level[a] > level[b] : level[a] < level[b];
+}
+
+static void level_heap_push(NodeList* heap, const int* level, NodeId node, int max_heap) {
+    node_list_push(heap, node);
+    int i = heap->count - 1;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!level_before(level, heap->items[i], heap->items[parent], max_heap)) break;
+        NodeId swap = heap->items[i];
+        heap->items[i] = heap->items[parent];
+        heap->items[parent] = swap;
+        i = parent;
+    }
+}
+
+static NodeId level_heap_pop(NodeList* heap, const int* level, int max_heap) {
+    NodeId top = heap->items[0];
+    heap->items[0] = heap->items[--heap->count];
+    int i = 0;
+    for (;;) {
+        int best = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < heap->count && level_before(level, heap->items[left], heap->items[best], max_heap)) best = left;
+        if (right < heap->count && level_before(level, heap->items[right], heap->items[best], max_heap)) best = right;
+        if (best == i) break;
+        NodeId swap = heap->items[i];
+        heap->items[i] = heap->items[best];
+        heap->items[best] = swap;
+        i = best;
+    }
+    return top;
+}
+
+// Re-time only what changed since the last analysis. Dirty arrivals are
+// propagated forward in level order and stop wherever a node's value is
+// unchanged; required times are propagated backward the same way. The
+// cost is proportional to the cones that actually change. Falls back to a
+// full backward pass when the required-time reference moves (without a
+// clock, the worst endpoint), since that shifts every required time.
+void update_timing(Circuit* circuit) {
+    TRACE_SCOPE("update_timing");
+    // Tagged lanes are not tracked edit by edit, so exceptions force a full update
+    if (!circuit->timing_valid || circuit->exception_count > 0) {
+        compute_arrival_times(circuit);
+        compute_required_times(circuit);
+        compute_slack(circuit);
+        return;
+    }
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return;
+
+    const int* level = circuit->level;
+    unsigned char* queued = circuit->queued;
+    double* const* arrival = circuit->arrival_time;
+    double* const* early_arrival = circuit->early_arrival;
+    double* const* required = circuit->required_time;
+    NodeList heap = {0};
+    NodeList touched = {0};
+
+    // Forward: re-evaluate dirty arrivals, expanding to fan-out on change.
+    // Dirty nodes themselves always expand (queued == 2) because a delay
+    // edit changes their output without changing their own arrival. A
+    // dirty flip-flop launches a new startpoint: its fan-out is seeded here
+    // at its own levels, since it can sit below the flip-flop and would be
+    // reached only after the heap had already passed its cone.
+    for (int i = 0; i < circuit->arrival_dirty.count; i++) {
+        NodeId node = circuit->arrival_dirty.items[i];
+        if (!queued[node]) {
+            level_heap_push(&heap, level, node, 0);
+            node_list_push(&touched, node);
+        }
+        queued[node] = 2;
+        if (circuit->type[node] != GATE_DFF) continue;
+        for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+            NodeId next = circuit->fanout[j];
+            if (!queued[next]) {
+                queued[next] = 1;
+                level_heap_push(&heap, level, next, 0);
+            }
+        }
+    }
+    circuit->arrival_dirty.count = 0;
+
+    while (heap.count > 0) {
+        NodeId node = level_heap_pop(&heap, level, 0);
+        int forced = queued[node] == 2;
+        queued[node] = 0;
+
+        double value[TRANSITION_COUNT], early[TRANSITION_COUNT];
+        node_arrival(circuit, node, value, early);
+        int changed = 0;
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            changed |= value[t] != arrival[t][node] || early[t] != early_arrival[t][node];
+            arrival[t][node] = value[t];
+            early_arrival[t][node] = early[t];
+        }
+        if (changed) {
+            node_list_push(&touched, node);
+        } else if (!forced) {
+            continue;
+        }
+
+        // A flip-flop's fan-out sees only its clock-to-Q delay, not its
+        // data arrival, and was already seeded above if that delay moved
+        if (circuit->type[node] == GATE_DFF) continue;
+
+        for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+            NodeId next = circuit->fanout[j];
+            if (!queued[next]) {
+                queued[next] = 1;
+                level_heap_push(&heap, level, next, 0);
+            }
+        }
+    }
+
+    // Find the required-time reference the same way compute_required_times does
+    if (endpoint_reference(circuit) != circuit->required_reference) {
+        compute_required_times(circuit);
+        compute_slack(circuit);
+        free(heap.items);
+        free(touched.items);
+        return;
+    }
+
+    // Backward: re-evaluate dirty required times, expanding to fan-in on change
+    for (int i = 0; i < circuit->required_dirty.count; i++) {
+        NodeId node = circuit->required_dirty.items[i];
+        if (!queued[node]) {
+            queued[node] = 1;
+            level_heap_push(&heap, level, node, 1);
+            node_list_push(&touched, node);
+        }
+    }
+    circuit->required_dirty.count = 0;
+
+    while (heap.count > 0) {
+        NodeId node = level_heap_pop(&heap, level, 1);
+        queued[node] = 0;
+
+        double value[TRANSITION_COUNT];
+        node_required(circuit, node, value);
+        if (value[TRANSITION_RISE] == required[TRANSITION_RISE][node] &&
+            value[TRANSITION_FALL] == required[TRANSITION_FALL][node]) continue;
+        required[TRANSITION_RISE][node] = value[TRANSITION_RISE];
+        required[TRANSITION_FALL][node] = value[TRANSITION_FALL];
+        node_list_push(&touched, node);
+
+        for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1]; j++) {
+            NodeId previous = circuit->fanin[j];
+            if (!queued[previous]) {
+                queued[previous] = 1;
+                level_heap_push(&heap, level, previous, 1);
+            }
+        }
+    }
+
+    for (int i = 0; i < touched.count; i++) {
+        NodeId node = touched.items[i];
+        circuit->slack[node] = node_slack(circuit, node);
+    }
+
+    free(heap.items);
+    free(touched.items);
+}
+
+// Register an analysis corner. Its delays are the circuit's delays (or
+// the corner library's NLDM delays, when given) scaled by derate.
+// Returns the corner index, or -1 if no lane is free.
+int add_corner(Circuit* circuit, const char* name, double derate, CellLibrary* library) {
+    if (circuit->corner_count == MAX_CORNERS) {
+        fprintf(stderr, "At most %d corners can be analyzed together\n", MAX_CORNERS);
+        return -1;
+    }
+    if (!(derate > 0.0)) {
+        fprintf(stderr, "Corner %s: derate must be positive\n", name);
+        return -1;
+    }
+    Corner* corner = &circuit->corners[circuit->corner_count];
+    snprintf(corner->name, sizeof(corner->name), "%s", name);
+    corner->derate = derate;
+    corner->library = library;
+    return circuit->corner_count++;
+}
+
+// Allocate one corner array: a 64-byte line per node
+static double* alloc_corner_array(int node_count) {
+    double* array = aligned_alloc(64, ((size_t)node_count + 1) * MAX_CORNERS * sizeof(double));
+    if (!array) {
+        fprintf(stderr, "Out of memory allocating corner timing for %d nodes\n", node_count);
+        exit(1);
+    }
+    return array;
+}
+
+// Corner counterpart of propagate_range: the same node visits and fan-in
+// walks as a single corner, with the arithmetic done across all lanes.
+// The fixed-width inner loops compile to vector max/min/add.
+static void propagate_corner_range(Circuit* circuit, int direction, int begin, int end) {
+    static const double clock_edge[MAX_CORNERS];
+    const NodeId* order = circuit->level_order;
+    const unsigned char* type = circuit->type;
+    const double* restrict rise_delay = circuit->corner_delay[TRANSITION_RISE];
+    const double* restrict fall_delay = circuit->corner_delay[TRANSITION_FALL];
+
+    if (direction == PROPAGATE_FORWARD) {
+        double* restrict rise_arrival = circuit->corner_arrival[TRANSITION_RISE];
+        double* restrict fall_arrival = circuit->corner_arrival[TRANSITION_FALL];
+        for (int i = begin; i < end; i++) {
+            NodeId node = order[i];
+            double rise[MAX_CORNERS] = {0.0};
+            double fall[MAX_CORNERS] = {0.0};
+            if (type[node] == INPUT) {
+                for (int c = 0; c < MAX_CORNERS; c++) rise[c] = fall[c] = circuit->port_delay[node];
+            }
+            for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1] && type[node] != INPUT; j++) {
+                NodeId input = circuit->fanin[j];
+                size_t offset = (size_t)input * MAX_CORNERS;
+
+                // Input arrivals that launch the fan-in's rising and falling output
+                const double* rise_source = rise_arrival + offset;
+                const double* fall_source = fall_arrival + offset;
+                double either[MAX_CORNERS];
+                if (type[input] == GATE_DFF) {
+                    rise_source = fall_source = clock_edge;
+                } else if (gate_unateness[type[input]] == UNATE_NEGATIVE) {
+                    rise_source = fall_arrival + offset;
+                    fall_source = rise_arrival + offset;
+                } else if (gate_unateness[type[input]] == UNATE_NON) {
+                    for (int c = 0; c < MAX_CORNERS; c++) {
+                        either[c] = rise_source[c] > fall_source[c] ? rise_source[c] : fall_source[c];
+                    }
+                    rise_source = fall_source = either;
+                }
+
+                for (int c = 0; c < MAX_CORNERS; c++) {
+                    double value = rise_source[c] + rise_delay[offset + c];
+                    rise[c] = value > rise[c] ? value : rise[c];
+                    value = fall_source[c] + fall_delay[offset + c];
+                    fall[c] = value > fall[c] ? value : fall[c];
+                }
+            }
+            memcpy(rise_arrival + (size_t)node * MAX_CORNERS, rise, sizeof(rise));
+            memcpy(fall_arrival + (size_t)node * MAX_CORNERS, fall, sizeof(fall));
+        }
+    } else {
+        double* restrict rise_required = circuit->corner_required[TRANSITION_RISE];
+        double* restrict fall_required = circuit->corner_required[TRANSITION_FALL];
+        for (int i = end - 1; i >= begin; i--) {
+            NodeId node = order[i];
+            size_t offset = (size_t)node * MAX_CORNERS;
+            double rise[MAX_CORNERS], fall[MAX_CORNERS];
+            if (type[node] == OUTPUT || type[node] == GATE_DFF) {
+                double margin = endpoint_margin(circuit, node);
+                for (int c = 0; c < MAX_CORNERS; c++) rise[c] = fall[c] = circuit->corner_reference[c] - margin;
+            } else {
+                // Tightest requirement on each output transition
+                for (int c = 0; c < MAX_CORNERS; c++) rise[c] = fall[c] = DBL_MAX;
+                for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+                    size_t next = (size_t)circuit->fanout[j] * MAX_CORNERS;
+                    for (int c = 0; c < MAX_CORNERS; c++) {
+                        rise[c] = rise_required[next + c] < rise[c] ? rise_required[next + c] : rise[c];
+                        fall[c] = fall_required[next + c] < fall[c] ? fall_required[next + c] : fall[c];
+                    }
+                }
+                if (circuit->fanout_start[node] < circuit->fanout_start[node + 1]) {
+                    for (int c = 0; c < MAX_CORNERS; c++) {
+                        rise[c] -= rise_delay[offset + c];
+                        fall[c] -= fall_delay[offset + c];
+                    }
+                }
+
+                // Map output transitions back to the input transitions causing them
+                if (gate_unateness[type[node]] == UNATE_NEGATIVE) {
+                    for (int c = 0; c < MAX_CORNERS; c++) {
+                        double swap = rise[c];
+                        rise[c] = fall[c];
+                        fall[c] = swap;
+                    }
+                } else if (gate_unateness[type[node]] == UNATE_NON) {
+                    for (int c = 0; c < MAX_CORNERS; c++) {
+                        rise[c] = fall[c] = rise[c] < fall[c] ? rise[c] : fall[c];
+                    }
+                }
+            }
+            memcpy(rise_required + offset, rise, sizeof(rise));
+            memcpy(fall_required + offset, fall, sizeof(fall));
+        }
+    }
+}
+
+// Time every registered corner in one forward and one backward sweep.
+// Each corner is constrained like compute_required_times() does for the
+// single-corner view: by the clock period, or without a clock by that
+// corner's worst endpoint. Corner delays are rebuilt from the current circuit
+// delays on every call, so edits made since the last call are included.
+void compute_corner_timing(Circuit* circuit) {
+    TRACE_SCOPE("compute_corner_timing");
+    if (circuit->corner_count == 0) return;
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return;
+
+    int n = circuit->node_count;
+    if (n > circuit->corner_capacity || !circuit->corner_slack) {
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            free(circuit->corner_delay[t]);
+            free(circuit->corner_arrival[t]);
+            free(circuit->corner_required[t]);
+            circuit->corner_delay[t] = alloc_corner_array(n);
+            circuit->corner_arrival[t] = alloc_corner_array(n);
+            circuit->corner_required[t] = alloc_corner_array(n);
+        }
+        free(circuit->corner_slack);
+        circuit->corner_slack = alloc_corner_array(n);
+        circuit->corner_capacity = n;
+    }
+
+    // Corner libraries get their own loads and slews: the nominal ones
+    // stay with the nominal delays for path-based analysis
+    double* library_delay[TRANSITION_COUNT] = {NULL, NULL};
+    double* library_load = NULL;
+    double* library_slew = NULL;
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        memset(circuit->corner_delay[t], 0, (size_t)n * MAX_CORNERS * sizeof(double));
+    }
+    for (int c = 0; c < circuit->corner_count; c++) {
+        const Corner* corner = &circuit->corners[c];
+        double* const* delay = circuit->delay;
+        if (corner->library) {
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                if (!library_delay[t]) library_delay[t] = grow_array(NULL, n + 1, sizeof(double));
+                memcpy(library_delay[t], circuit->delay[t], n * sizeof(double));
+            }
+            if (!library_load) {
+                library_load = grow_array(NULL, n + 1, sizeof(double));
+                library_slew = grow_array(NULL, n + 1, sizeof(double));
+            }
+            annotate_delays(circuit, corner->library, library_delay, library_load, library_slew);
+            delay = library_delay;
+        }
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            for (int i = 0; i < n; i++) {
+                circuit->corner_delay[t][(size_t)i * MAX_CORNERS + c] = delay[t][i] * corner->derate;
+            }
+        }
+    }
+    free(library_delay[TRANSITION_RISE]);
+    free(library_delay[TRANSITION_FALL]);
+    free(library_load);
+    free(library_slew);
+
+    propagate_levels(circuit, PROPAGATE_FORWARD, propagate_corner_range);
+
+    double reference[MAX_CORNERS] = {0.0};
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        NodeId endpoint = circuit->endpoints[i];
+        const double* rise = circuit->corner_arrival[TRANSITION_RISE] + (size_t)endpoint * MAX_CORNERS;
+        const double* fall = circuit->corner_arrival[TRANSITION_FALL] + (size_t)endpoint * MAX_CORNERS;
+        double margin = endpoint_margin(circuit, endpoint);
+        for (int c = 0; c < MAX_CORNERS; c++) {
+            double value = (rise[c] > fall[c] ? rise[c] : fall[c]) + margin;
+            reference[c] = value > reference[c] ? value : reference[c];
+        }
+    }
+    if (circuit->clock_period > 0.0) {
+        for (int c = 0; c < MAX_CORNERS; c++) reference[c] = circuit->clock_period;
+    }
+    memcpy(circuit->corner_reference, reference, sizeof(reference));
+
+    propagate_levels(circuit, PROPAGATE_BACKWARD, propagate_corner_range);
+
+    const double* restrict rise_arrival = circuit->corner_arrival[TRANSITION_RISE];
+    const double* restrict fall_arrival = circuit->corner_arrival[TRANSITION_FALL];
+    const double* restrict rise_required = circuit->corner_required[TRANSITION_RISE];
+    const double* restrict fall_required = circuit->corner_required[TRANSITION_FALL];
+    double* restrict slack = circuit->corner_slack;
+    for (size_t k = 0; k < (size_t)n * MAX_CORNERS; k++) {
+        double rise = rise_required[k] - rise_arrival[k];
+        double fall = fall_required[k] - fall_arrival[k];
+        slack[k] = rise < fall ? rise : fall;
+    }
+}
+
+// Print the worst endpoint of each corner with its arrival and slack
+void print_corner_summary(const Circuit* circuit) {
+    printf("Corner Summary:\n");
+    printf("---------------------\n");
+    printf("%-*s %8s %12s %12s  %s\n", MAX_CORNER_NAME, "Corner", "Derate", "Arrival", "Slack", "Endpoint");
+
+    for (int c = 0; c < circuit->corner_count; c++) {
+        const Corner* corner = &circuit->corners[c];
+        NodeId worst = -1;
+        for (int i = 0; i < circuit->endpoint_count; i++) {
+            NodeId endpoint = circuit->endpoints[i];
+            if (worst < 0 || circuit->corner_slack[(size_t)endpoint * MAX_CORNERS + c] <
+                             circuit->corner_slack[(size_t)worst * MAX_CORNERS + c]) {
+                worst = endpoint;
+            }
+        }
+        if (worst < 0) {
+            printf("%-*s %8.3f %12s %12s  -\n", MAX_CORNER_NAME, corner->name, corner->derate, "-", "-");
+            continue;
+        }
+        size_t k = (size_t)worst * MAX_CORNERS + c;
+        printf("%-*s %8.3f %9.2f ns %9.2f ns  %s\n", MAX_CORNER_NAME, corner->name, corner->derate,
+               fmax(circuit->corner_arrival[TRANSITION_RISE][k], circuit->corner_arrival[TRANSITION_FALL][k]),
+               circuit->corner_slack[k], node_name(circuit, worst));
+    }
+    printf("\n");
+}
+
+// Allocate one sample array: MC_BATCH lanes per node
+static float* alloc_sample_array(int node_count) {
+    float* array = aligned_alloc(64, ((size_t)node_count + 1) * MC_BATCH * sizeof(float));
+    if (!array) {
+        fprintf(stderr, "Out of memory allocating Monte Carlo samples for %d nodes\n", node_count);
+        exit(1);
+    }
+    return array;
+}
+
+// SplitMix64 finalizer: a cheap, well-mixed hash of a 64-bit key
+static inline uint64_t mix_bits(uint64_t x) {
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+// Fill the table of standard normal variates (Box-Muller)
+static void build_normal_table(Circuit* circuit) {
+    float* table = alloc_sample_array(MC_NORMAL_TABLE_SIZE / MC_BATCH + 1);
+    uint64_t state = 0;
+    for (int i = 0; i < MC_NORMAL_TABLE_SIZE + MC_BATCH; i += 2) {
+        state += 0x9E3779B97F4A7C15ULL;
+        double u1 = ((mix_bits(state) >> 11) + 1.0) / 9007199254740993.0;   // (0, 1]
+        state += 0x9E3779B97F4A7C15ULL;
+        double u2 = (mix_bits(state) >> 11) / 9007199254740992.0;           // [0, 1)
+        double radius = sqrt(-2.0 * log(u1));
+        table[i] = radius * cos(2.0 * M_PI * u2);
+        table[i + 1] = radius * sin(2.0 * M_PI * u2);
+    }
+    circuit->sample_normal = table;
+}
+
+// The MC_BATCH variates a node draws in the current batch: a contiguous
+// run of the table at an offset hashed from the batch seed and the node,
+// so any thread can evaluate any node and get the same samples
+static inline const float* sample_normals(const Circuit* circuit, NodeId node) {
+    uint64_t hash = mix_bits(circuit->sample_seed + (uint64_t)node * 0x9E3779B97F4A7C15ULL);
+    return circuit->sample_normal + (hash & (MC_NORMAL_TABLE_SIZE - 1));
+}
+
+// Monte Carlo counterpart of the forward propagate_range: every node's
+// output time is evaluated for MC_BATCH samples at once, each lane with
+// its own sampled delay. Reading a fan-in is then a plain lane-wise max,
+// and the fixed-width loops compile to vector max/add over the samples.
+static void propagate_sample_range(Circuit* circuit, int direction, int begin, int end) {
+    (void)direction;         // Samples are only propagated forward
+    const NodeId* order = circuit->level_order;
+    const unsigned char* type = circuit->type;
+    float* restrict rise_output = circuit->sample_output[TRANSITION_RISE];
+    float* restrict fall_output = circuit->sample_output[TRANSITION_FALL];
+
+    for (int i = begin; i < end; i++) {
+        NodeId node = order[i];
+        float rise[MC_BATCH] = {0.0f};
+        float fall[MC_BATCH] = {0.0f};
+        if (type[node] == INPUT) {
+            for (int k = 0; k < MC_BATCH; k++) rise[k] = fall[k] = circuit->port_delay[node];
+        } else if (type[node] != GATE_DFF) {
+            // Latest rising and falling input; a flip-flop launches at zero
+            for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1]; j++) {
+                size_t offset = (size_t)circuit->fanin[j] * MC_BATCH;
+                for (int k = 0; k < MC_BATCH; k++) {
+                    rise[k] = rise_output[offset + k] > rise[k] ? rise_output[offset + k] : rise[k];
+                    fall[k] = fall_output[offset + k] > fall[k] ? fall_output[offset + k] : fall[k];
+                }
+            }
+        }
+
+        // Input transitions that cause each output transition
+        if (gate_unateness[type[node]] == UNATE_NEGATIVE) {
+            for (int k = 0; k < MC_BATCH; k++) {
+                float swap = rise[k];
+                rise[k] = fall[k];
+                fall[k] = swap;
+            }
+        } else if (gate_unateness[type[node]] == UNATE_NON) {
+            for (int k = 0; k < MC_BATCH; k++) rise[k] = fall[k] = rise[k] > fall[k] ? rise[k] : fall[k];
+        }
+
+        // Both transitions of a gate share one variate per sample
+        const float* normal = sample_normals(circuit, node);
+        float sigma = circuit->delay_sigma[node];
+        float rise_delay = circuit->delay[TRANSITION_RISE][node];
+        float fall_delay = circuit->delay[TRANSITION_FALL][node];
+        size_t offset = (size_t)node * MC_BATCH;
+        for (int k = 0; k < MC_BATCH; k++) {
+            float scale = 1.0f + sigma * normal[k];
+            scale = scale > 0.0f ? scale : 0.0f;
+            rise_output[offset + k] = rise[k] + rise_delay * scale;
+            fall_output[offset + k] = fall[k] + fall_delay * scale;
+        }
+    }
+}
+
+// Time sample_count Monte Carlo samples of the gate delays and collect
+// the slack distribution of every endpoint. Endpoints keep their nominal
+// requirement: the clock period, or without a clock the nominal worst
+// endpoint, so the nominal timing is brought up to date first.
+// Returns NULL if the circuit cannot be levelized.
+StatisticalTiming* compute_statistical_timing(Circuit* circuit, int sample_count, unsigned int seed) {
+    TRACE_SCOPE("compute_statistical_timing");
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return NULL;
+    update_timing(circuit);
+
+    int n = circuit->node_count;
+    if (n > circuit->sample_capacity || !circuit->sample_output[TRANSITION_RISE]) {
+        for (int t = 0; t < TRANSITION_COUNT; t++) {
+            free(circuit->sample_output[t]);
+            circuit->sample_output[t] = alloc_sample_array(n);
+        }
+        circuit->sample_capacity = n;
+    }
+    if (!circuit->sample_normal) build_normal_table(circuit);
+
+    int endpoint_count = circuit->endpoint_count;
+    StatisticalTiming* stats = calloc(1, sizeof(StatisticalTiming));
+    stats->sample_count = sample_count;
+    stats->endpoint_count = endpoint_count;
+    stats->slack_mean = calloc(endpoint_count + 1, sizeof(double));
+    stats->slack_sigma = calloc(endpoint_count + 1, sizeof(double));
+    stats->yield = calloc(endpoint_count + 1, sizeof(double));
+    if (!stats->slack_mean || !stats->slack_sigma || !stats->yield) {
+        fprintf(stderr, "Out of memory collecting statistics for %d endpoints\n", endpoint_count);
+        exit(1);
+    }
+
+    // Sums of slack and squared slack are gathered in the mean and sigma
+    // arrays, and passing samples in the yield array
+    double reference = endpoint_reference(circuit);
+    long long design_pass = 0;
+    for (int first = 0; first < sample_count; first += MC_BATCH) {
+        int lanes = sample_count - first < MC_BATCH ? sample_count - first : MC_BATCH;
+        circuit->sample_seed = mix_bits(((uint64_t)seed << 32) + first / MC_BATCH);
+        propagate_levels(circuit, PROPAGATE_FORWARD, propagate_sample_range);
+
+        float worst[MC_BATCH];
+        for (int k = 0; k < MC_BATCH; k++) worst[k] = FLT_MAX;
+        for (int e = 0; e < endpoint_count; e++) {
+            NodeId endpoint = circuit->endpoints[e];
+            float arrival[MC_BATCH] = {0.0f};
+            for (int j = circuit->fanin_start[endpoint]; j < circuit->fanin_start[endpoint + 1]; j++) {
+                size_t offset = (size_t)circuit->fanin[j] * MC_BATCH;
+                for (int k = 0; k < MC_BATCH; k++) {
+                    float rise = circuit->sample_output[TRANSITION_RISE][offset + k];
+                    float fall = circuit->sample_output[TRANSITION_FALL][offset + k];
+                    float latest = rise > fall ? rise : fall;
+                    arrival[k] = latest > arrival[k] ? latest : arrival[k];
+                }
+            }
+
+            float required = reference - endpoint_margin(circuit, endpoint);
+            for (int k = 0; k < lanes; k++) {
+                float slack = required - arrival[k];
+                stats->slack_mean[e] += slack;
+                stats->slack_sigma[e] += (double)slack * slack;
+                stats->yield[e] += slack >= 0.0f;
+                worst[k] = slack < worst[k] ? slack : worst[k];
+            }
+        }
+        for (int k = 0; k < lanes; k++) design_pass += worst[k] >= 0.0f;
+    }
+
+    for (int e = 0; e < endpoint_count && sample_count > 0; e++) {
+        double mean = stats->slack_mean[e] / sample_count;
+        double variance = stats->slack_sigma[e] / sample_count - mean * mean;
+        stats->slack_mean[e] = mean;
+        stats->slack_sigma[e] = variance > 0.0 ? sqrt(variance) : 0.0;
+        stats->yield[e] /= sample_count;
+    }
+    stats->design_yield = sample_count > 0 ? (double)design_pass / sample_count : 0.0;
+    return stats;
+}
+
+// Print each endpoint's nominal slack next to its sampled distribution
+void print_statistical_timing(const Circuit* circuit, const StatisticalTiming* stats) {
+    printf("Statistical Timing:\n");
+    printf("---------------------\n");
+    printf("Samples: %d  Design yield: %.2f%%\n", stats->sample_count, stats->design_yield * 100.0);
+    printf("%-24s %12s %12s %12s %8s\n", "Endpoint", "Nominal", "Mean", "Sigma", "Yield");
+
+    for (int e = 0; e < stats->endpoint_count; e++) {
+        NodeId endpoint = circuit->endpoints[e];
+        printf("%-24s %9.3f ns %9.3f ns %9.3f ns %7.2f%%\n", node_name(circuit, endpoint),
+               circuit->slack[endpoint], stats->slack_mean[e], stats->slack_sigma[e],
+               stats->yield[e] * 100.0);
+    }
+    printf("\n");
+}
+
+// Free the results of compute_statistical_timing()
+void free_statistical_timing(StatisticalTiming* stats) {
+    if (!stats) return;
+    free(stats->slack_mean);
+    free(stats->slack_sigma);
+    free(stats->yield);
+    free(stats);
+}
+
+// Endpoint slack paired with its node, for sorting
+typedef struct {
+    double slack;
+    NodeId node;
+} EndpointSlack;
+
+static int compare_endpoint_slack(const void* a, const void* b) {
+    const EndpointSlack* x = a;
+    const EndpointSlack* y = b;
+    if (x->slack != y->slack) return x->slack < y->slack ? -1 : 1;
+    return x->node - y->node;
+}
+
+// Partial path used by the K-worst search: node plus everything between
+// it and the endpoint. Entries share their tails through parent links.
+typedef struct {
+    NodeId node;
+    NodeId endpoint;
+    int parent;              // Entry one step closer to the endpoint, or -1
+    unsigned char transition;  // Arriving at node (leaving it, for a launching flip-flop)
+    unsigned char checked;   // Complete path already re-keyed by its exceptions
+    double suffix_delay;     // Delay from node's output to the endpoint input
+    double slack;            // Slack of the worst completion of this entry
+} PathEntry;
+
+typedef struct {
+    PathEntry* entries;
+    int entry_count;
+    int entry_capacity;
+    int* heap;               // Min-heap of entry indices ordered by slack
+    int heap_count;
+    int heap_capacity;
+} PathSearch;
+
+static int path_entry_before(const PathSearch* search, int a, int b) {
+    double slack_a = search->entries[a].slack;
+    double slack_b = search->entries[b].slack;
+    return slack_a < slack_b || (slack_a == slack_b && a < b);
+}
+
+static void path_heap_sift_down(PathSearch* search, int i) {
+    int* heap = search->heap;
+    for (;;) {
+        int best = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < search->heap_count && path_entry_before(search, heap[left], heap[best])) best = left;
+        if (right < search->heap_count && path_entry_before(search, heap[right], heap[best])) best = right;
+        if (best == i) break;
+        int swap = heap[i];
+        heap[i] = heap[best];
+        heap[best] = swap;
+        i = best;
+    }
+}
+
+static void path_heap_push(PathSearch* search, int entry) {
+    if (search->heap_count == search->heap_capacity) {
+        search->heap_capacity = search->heap_capacity ? search->heap_capacity * 2 : 256;
+        search->heap = grow_array(search->heap, search->heap_capacity, sizeof(int));
+    }
+    int* heap = search->heap;
+    int i = search->heap_count++;
+    heap[i] = entry;
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!path_entry_before(search, heap[i], heap[parent])) break;
+        int swap = heap[i];
+        heap[i] = heap[parent];
+        heap[parent] = swap;
+        i = parent;
+    }
+}
+
+static int path_heap_pop(PathSearch* search) {
+    int top = search->heap[0];
+    search->heap[0] = search->heap[--search->heap_count];
+    path_heap_sift_down(search, 0);
+    return top;
+}
+
+// Per thread, so path-based timing can search several endpoints at once
+static _Thread_local const PathSearch* path_sort_search;
+
+static int compare_path_entries(const void* a, const void* b) {
+    int entry_a = *(const int*)a;
+    int entry_b = *(const int*)b;
+    if (path_entry_before(path_sort_search, entry_a, entry_b)) return -1;
+    return path_entry_before(path_sort_search, entry_b, entry_a) ? 1 : 0;
+}
+
+// Every queued entry completes to at least one distinct path whose slack
+// equals its key, so only the `keep` best entries can still matter. With
+// exceptions a key is only a lower bound and nothing may be trimmed.
+static void path_heap_trim(PathSearch* search, int keep) {
+    path_sort_search = search;
+    qsort(search->heap, search->heap_count, sizeof(int), compare_path_entries);
+    if (search->heap_count > keep) search->heap_count = keep;
+    // A sorted array already satisfies the heap property
+}
+
+static int path_entry_add(PathSearch* search, NodeId node, NodeId endpoint, int parent,
+                          int transition, double suffix_delay, double slack) {
+    if (search->entry_count == search->entry_capacity) {
+        search->entry_capacity = search->entry_capacity ? search->entry_capacity * 2 : 1024;
+        search->entries = grow_array(search->entries, search->entry_capacity, sizeof(PathEntry));
+    }
+    PathEntry* entry = &search->entries[search->entry_count];
+    entry->node = node;
+    entry->endpoint = endpoint;
+    entry->parent = parent;
+    entry->transition = transition;
+    entry->checked = 0;
+    entry->suffix_delay = suffix_delay;
+    entry->slack = slack;
+    return search->entry_count++;
+}
+
+// Arrival at the endpoint along a complete entry's path
+static double path_entry_arrival(const Circuit* circuit, const PathSearch* search, int entry) {
+    const PathEntry* start = &search->entries[entry];
+    int launching = start->parent >= 0 && circuit->type[start->node] == GATE_DFF;
+    return (launching ? 0.0 : circuit->arrival_time[start->transition][start->node]) + start->suffix_delay;
+}
+
+// Required time of a complete entry's path under the exceptions it
+// matches, DBL_MAX if it is a false path
+static double path_entry_required(const Circuit* circuit, const PathSearch* search, int entry) {
+    NodeId endpoint = search->entries[entry].endpoint;
+    if (circuit->exception_count == 0) return circuit->required_time[TRANSITION_RISE][endpoint];
+    uint64_t* tag = grow_array(NULL, circuit->tag_words, sizeof(uint64_t));
+    start_tag(circuit, tag, search->entries[entry].node);
+    for (int e = search->entries[entry].parent; e >= 0; e = search->entries[e].parent) {
+        advance_tag(circuit, tag, search->entries[e].node);
+    }
+    double required = exception_required(circuit, endpoint, tag);
+    free(tag);
+    return required;
+}
+
+// Queue both transitions arriving at an endpoint. Endpoints require both
+// transitions at the same time, so the rise required time stands for
+// either during the search.
+static void path_search_seed(const Circuit* circuit, PathSearch* search, NodeId endpoint) {
+    if (circuit->required_time[TRANSITION_RISE][endpoint] == DBL_MAX) return;   // Only false paths end here
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        path_heap_push(search, path_entry_add(search, endpoint, endpoint, -1, t, 0.0,
+                                              circuit->required_time[t][endpoint] - circuit->arrival_time[t][endpoint]));
+    }
+}
+
+// Pop entries until one completes a path and return it, worst first, or
+// -1 once every path has been found. At most `remaining` further paths
+// will be asked for, which bounds the queue. With exceptions an endpoint
+// requires its tightest lane, so keys are lower bounds: a complete path is
+// re-queued once under its own requirement, and false paths are dropped.
+static int path_search_next(const Circuit* circuit, PathSearch* search, int remaining) {
+    double* const* arrival = circuit->arrival_time;
+    while (search->heap_count > 0) {
+        int current = path_heap_pop(search);
+        PathEntry entry = search->entries[current];
+
+        // A node without fan-in, or a flip-flop launching the path, is a
+        // startpoint: the path is complete
+        if (circuit->fanin_start[entry.node] == circuit->fanin_start[entry.node + 1] ||
+            (entry.parent >= 0 && circuit->type[entry.node] == GATE_DFF)) {
+            if (circuit->exception_count == 0 || entry.checked) return current;
+            double required = path_entry_required(circuit, search, current);
+            if (required == DBL_MAX) continue;
+            search->entries[current].checked = 1;
+            search->entries[current].slack = required - path_entry_arrival(circuit, search, current);
+            path_heap_push(search, current);
+            continue;
+        }
+
+        // The fan-in's output carries entry.transition; step back through
+        // its unateness to the input transition(s) that cause it
+        double endpoint_required = circuit->required_time[TRANSITION_RISE][entry.endpoint];
+        for (int j = circuit->fanin_start[entry.node]; j < circuit->fanin_start[entry.node + 1]; j++) {
+            NodeId input = circuit->fanin[j];
+            int t = entry.transition;
+            double suffix_delay = entry.suffix_delay + circuit->delay[t][input];
+            if (circuit->type[input] == GATE_DFF) {
+                path_heap_push(search, path_entry_add(search, input, entry.endpoint, current, t,
+                                                      suffix_delay, endpoint_required - suffix_delay));
+                continue;
+            }
+            for (int source = 0; source < TRANSITION_COUNT; source++) {
+                int unateness = gate_unateness[circuit->type[input]];
+                if ((unateness == UNATE_POSITIVE && source != t) || (unateness == UNATE_NEGATIVE && source == t)) {
+                    continue;
+                }
+                double slack = endpoint_required - (arrival[source][input] + suffix_delay);
+                path_heap_push(search, path_entry_add(search, input, entry.endpoint, current, source,
+                                                      suffix_delay, slack));
+            }
+        }
+
+        if (search->heap_count > 2 * remaining + 64 && circuit->exception_count == 0) {
+            path_heap_trim(search, remaining);
+        }
+    }
+    return -1;
+}
+
+// Write a completed entry's path startpoint first and return its length.
+// With nodes NULL only the length is returned.
+static int unroll_path(const PathSearch* search, int entry, NodeId* nodes, unsigned char* transitions) {
+    int length = 0;
+    for (int e = entry; e >= 0; e = search->entries[e].parent) {
+        if (nodes) {
+            nodes[length] = search->entries[e].node;
+            transitions[length] = search->entries[e].transition;
+        }
+        length++;
+    }
+    return length;
+}
+
+// Find the max_paths worst paths by best-first search backward from the
+// endpoints. A partial path ending at node v has exact best-case slack
+// required(endpoint) - (arrival(v) + suffix delay), because arrival(v) is
+// already the worst completion through v's fan-in. Popping in slack order
+// therefore yields complete paths worst first, and the queue never needs
+// more than max_paths - found entries. Work is about K x depth x fan-in.
+CriticalPaths* find_critical_paths(Circuit* circuit, int max_paths) {
+    TRACE_SCOPE("find_critical_paths");
+    if (!circuit->timing_valid) update_timing(circuit);
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return NULL;
+
+    PathSearch search = {0};
+
+    CriticalPaths* paths = calloc(1, sizeof(CriticalPaths));
+    int* completed = malloc((max_paths + 1) * sizeof(int));
+
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        path_search_seed(circuit, &search, circuit->endpoints[i]);
+    }
+    if (search.heap_count > max_paths && circuit->exception_count == 0) path_heap_trim(&search, max_paths);
+
+    while (paths->path_count < max_paths) {
+        int entry = path_search_next(circuit, &search, max_paths - paths->path_count);
+        if (entry < 0) break;
+        completed[paths->path_count++] = entry;
+    }
+
+    // Unroll each completed entry chain (startpoint first) into flat arrays
+    int total_nodes = 0;
+    for (int p = 0; p < paths->path_count; p++) {
+        total_nodes += unroll_path(&search, completed[p], NULL, NULL);
+    }
+    paths->nodes = malloc((total_nodes + 1) * sizeof(NodeId));
+    paths->transitions = malloc(total_nodes + 1);
+    paths->path_start = malloc((paths->path_count + 1) * sizeof(int));
+    paths->slack = malloc((paths->path_count + 1) * sizeof(double));
+    paths->arrival = malloc((paths->path_count + 1) * sizeof(double));
+
+    int position = 0;
+    for (int p = 0; p < paths->path_count; p++) {
+        const PathEntry* start = &search.entries[completed[p]];
+        paths->path_start[p] = position;
+        paths->slack[p] = start->slack;
+        paths->arrival[p] = path_entry_arrival(circuit, &search, completed[p]);
+        position += unroll_path(&search, completed[p], paths->nodes + position, paths->transitions + position);
+    }
+    paths->path_start[paths->path_count] = position;
+
+    free(completed);
+    free(search.entries);
+    free(search.heap);
+    return paths;
+}
+
+// Free a path set returned by find_critical_paths()
+void free_critical_paths(CriticalPaths* paths) {
+    if (!paths) return;
+    free(paths->nodes);
+    free(paths->transitions);
+    free(paths->path_start);
+    free(paths->slack);
+    free(paths->arrival);
+    free(paths);
+}
+
+// Candidate paths of one endpoint from the graph-based search, worst first.
+// Path p runs startpoint to endpoint through nodes[path_start[p] ..
+// path_start[p + 1] - 1].
+typedef struct {
+    int path_count;
+    int complete;            // Every path to the endpoint was found
+    NodeId* nodes;
+    unsigned char* transitions;
+    int* path_start;
+    double* graph_slack;
+} EndpointPaths;
+
+// Shared state of the path-based refinement. Phase 1 collects each
+// endpoint's worst paths; phase 2 re-times the pooled paths in prefix order.
+typedef struct {
+    Circuit* circuit;
+    const EndpointSlack* selected;
+    int max_paths;
+    EndpointPaths* candidates;   // Per selected endpoint
+    PathSearch* searches;        // Per worker
+
+    // Pooled paths, with the selected endpoint each one belongs to
+    NodeId* nodes;
+    unsigned char* transitions;
+    int* path_start;
+    int* owner;
+    int* order;              // Paths sorted so shared prefixes are adjacent
+    double* path_slack;
+
+    // Per worker: time and slew after each node of the last path, and a
+    // lookup batch for single-cell evaluations
+    double** prefix_time;
+    double** prefix_slew;
+    DelayBatch** batches;
+    long long* evaluations;
+} PathRefinement;
+
+// Phase 1: the max_paths worst paths of each endpoint, by the same
+// best-first search as find_critical_paths() seeded with that endpoint alone
+static void collect_endpoint_paths(void* context, int worker, int begin, int end) {
+    PathRefinement* refinement = context;
+    PathSearch* search = &refinement->searches[worker];
+    int* completed = malloc(refinement->max_paths * sizeof(int));
+
+    for (int e = begin; e < end; e++) {
+        search->entry_count = 0;
+        search->heap_count = 0;
+        path_search_seed(refinement->circuit, search, refinement->selected[e].node);
+        int found = 0;
+        while (found < refinement->max_paths) {
+            int entry = path_search_next(refinement->circuit, search, refinement->max_paths - found);
+            if (entry < 0) break;
+            completed[found++] = entry;
+        }
+
+        EndpointPaths* paths = &refinement->candidates[e];
+        paths->path_count = found;
+        paths->complete = search->heap_count == 0;
+        paths->path_start = malloc((found + 1) * sizeof(int));
+        paths->graph_slack = malloc((found + 1) * sizeof(double));
+        int total = 0;
+        for (int p = 0; p < found; p++) total += unroll_path(search, completed[p], NULL, NULL);
+        paths->nodes = malloc((total + 1) * sizeof(NodeId));
+        paths->transitions = malloc(total + 1);
+
+        int position = 0;
+        for (int p = 0; p < found; p++) {
+            paths->path_start[p] = position;
+            paths->graph_slack[p] = search->entries[completed[p]].slack;
+            position += unroll_path(search, completed[p], paths->nodes + position, paths->transitions + position);
+        }
+        paths->path_start[found] = position;
+    }
+    free(completed);
+}
+
+// Required time of a path (startpoint first) under the exceptions it matches
+static double path_required(const Circuit* circuit, const NodeId* nodes, int length) {
+    NodeId endpoint = nodes[length - 1];
+    if (circuit->exception_count == 0) return circuit->required_time[TRANSITION_RISE][endpoint];
+    uint64_t* tag = grow_array(NULL, circuit->tag_words, sizeof(uint64_t));
+    start_tag(circuit, tag, nodes[0]);
+    for (int k = 1; k < length; k++) advance_tag(circuit, tag, nodes[k]);
+    double required = exception_required(circuit, endpoint, tag);
+    free(tag);
+    return required;
+}
+
+static const PathRefinement* path_order_refinement;
+
+// Lexicographic order on (node, transition) from the startpoint
+static int compare_path_prefix(const void* a, const void* b) {
+    const PathRefinement* refinement = path_order_refinement;
+    int path_a = *(const int*)a;
+    int path_b = *(const int*)b;
+    int start_a = refinement->path_start[path_a];
+    int start_b = refinement->path_start[path_b];
+    int length_a = refinement->path_start[path_a + 1] - start_a;
+    int length_b = refinement->path_start[path_b + 1] - start_b;
+    for (int k = 0; k < length_a && k < length_b; k++) {
+        NodeId node_a = refinement->nodes[start_a + k];
+        NodeId node_b = refinement->nodes[start_b + k];
+        if (node_a != node_b) return node_a < node_b ? -1 : 1;
+        int transition_a = refinement->transitions[start_a + k];
+        int transition_b = refinement->transitions[start_b + k];
+        if (transition_a != transition_b) return transition_a - transition_b;
+    }
+    if (length_a != length_b) return length_a - length_b;
+    return path_a - path_b;
+}
+
+// Phase 2: walk each path forward with the slew it actually carries. The
+// graph-based delays use the worst slew over all of a gate's fan-in and
+// over both transitions; here a gate sees only its path predecessor's
+// slew for the transition on the path, so no other path's slew can make
+// it slower. A node's time and slew depend only on the path up to it,
+// so they are kept from the previous path for as long as both agree.
+static void retime_paths(void* context, int worker, int begin, int end) {
+    PathRefinement* refinement = context;
+    const Circuit* circuit = refinement->circuit;
+    const CellLibrary* library = circuit->library;
+    double* prefix_time = refinement->prefix_time[worker];
+    double* prefix_slew = refinement->prefix_slew[worker];
+    DelayBatch* batch = refinement->batches[worker];
+    long long evaluations = 0;
+
+    for (int i = begin; i < end; i++) {
+        int path = refinement->order[i];
+        const NodeId* nodes = refinement->nodes + refinement->path_start[path];
+        const unsigned char* transitions = refinement->transitions + refinement->path_start[path];
+        int length = refinement->path_start[path + 1] - refinement->path_start[path];
+
+        // State k (after node k) also depends on the transition leaving
+        // node k, which is the one recorded at node k + 1
+        int reused = 0;
+        if (i > begin) {
+            int previous = refinement->order[i - 1];
+            const NodeId* previous_nodes = refinement->nodes + refinement->path_start[previous];
+            const unsigned char* previous_transitions = refinement->transitions + refinement->path_start[previous];
+            int previous_length = refinement->path_start[previous + 1] - refinement->path_start[previous];
+            int common = 0;
+            while (common < length && common < previous_length && nodes[common] == previous_nodes[common] &&
+                   transitions[common] == previous_transitions[common]) {
+                common++;
+            }
+            reused = common > 0 ? common - 1 : 0;
+            if (reused > length - 1) reused = length - 1;
+        }
+
+        double time, slew;
+        if (reused > 0) {
+            time = prefix_time[reused - 1];
+            slew = prefix_slew[reused - 1];
+        } else {
+            NodeId start = nodes[0];
+            int launching = length > 1 && circuit->type[start] == GATE_DFF;
+            time = launching ? 0.0 : circuit->arrival_time[transitions[0]][start];
+            slew = circuit->type[start] == INPUT || circuit->type[start] == GATE_DFF ? DEFAULT_INPUT_SLEW : 0.0;
+        }
+
+        for (int k = reused; k < length - 1; k++) {
+            NodeId node = nodes[k];
+            int t = transitions[k + 1];
+            int cell = library ? library_cell_for(library, circuit->type[node]) : -1;
+            if (cell >= 0) {
+                const LibertyCell* cells[1] = {&library->cells[cell]};
+                lookup_batch(batch, 1, cells, &slew, &circuit->load[node]);
+                time += batch->result[t][0];
+                slew = batch->result[2 + t][0];
+            } else {
+                // Ports and unmapped gates keep their delay and pass their slew through
+                time += circuit->delay[t][node];
+            }
+            prefix_time[k] = time;
+            prefix_slew[k] = slew;
+            evaluations++;
+        }
+
+        refinement->path_slack[path] = path_required(circuit, nodes, length) - time;
+    }
+    refinement->evaluations[worker] += evaluations;
+}
+
+// Path-based refinement of the endpoint_count worst endpoints. Graph-based
+// slack merges the worst arrival and slew at every node, so it can be
+// pessimistic for any single path. Each selected endpoint's max_paths
+// worst graph-based paths are re-timed exactly; a path's re-timed slack
+// is never below its graph-based slack, so once the worst re-timed slack
+// is no worse than the last path collected, no remaining path can beat
+// it and the endpoint is exact. Otherwise the last path's graph-based
+// slack bounds it from below. Both phases run as parallel batches.
+PathBasedTiming* compute_path_based_timing(Circuit* circuit, int endpoint_count, int max_paths) {
+    TRACE_SCOPE("compute_path_based_timing");
+    if (!circuit->timing_valid) update_timing(circuit);
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return NULL;
+    if (max_paths < 1) max_paths = 1;
+
+    EndpointSlack* sorted = malloc((circuit->endpoint_count + 1) * sizeof(EndpointSlack));
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        sorted[i].node = circuit->endpoints[i];
+        sorted[i].slack = circuit->slack[circuit->endpoints[i]];
+    }
+    qsort(sorted, circuit->endpoint_count, sizeof(EndpointSlack), compare_endpoint_slack);
+    if (endpoint_count > circuit->endpoint_count) endpoint_count = circuit->endpoint_count;
+    while (endpoint_count > 0 && sorted[endpoint_count - 1].slack == DBL_MAX) endpoint_count--;
+    if (endpoint_count < 0) endpoint_count = 0;
+
+    int thread_count = circuit->thread_count > 1 ? circuit->thread_count : 1;
+    PathRefinement refinement = {0};
+    refinement.circuit = circuit;
+    refinement.selected = sorted;
+    refinement.max_paths = max_paths;
+    refinement.candidates = calloc(endpoint_count + 1, sizeof(EndpointPaths));
+    refinement.searches = calloc(thread_count, sizeof(PathSearch));
+    run_batch(thread_count, endpoint_count, 1, collect_endpoint_paths, &refinement);
+
+    // Pool every endpoint's paths
+    int path_total = 0;
+    int node_total = 0;
+    int longest = 1;
+    for (int e = 0; e < endpoint_count; e++) {
+        const EndpointPaths* paths = &refinement.candidates[e];
+        path_total += paths->path_count;
+        node_total += paths->path_start[paths->path_count];
+        for (int p = 0; p < paths->path_count; p++) {
+            int length = paths->path_start[p + 1] - paths->path_start[p];
+            if (length > longest) longest = length;
+        }
+    }
+    refinement.nodes = malloc((node_total + 1) * sizeof(NodeId));
+    refinement.transitions = malloc(node_total + 1);
+    refinement.path_start = malloc((path_total + 1) * sizeof(int));
+    refinement.owner = malloc((path_total + 1) * sizeof(int));
+    refinement.order = malloc((path_total + 1) * sizeof(int));
+    refinement.path_slack = malloc((path_total + 1) * sizeof(double));
+    int path = 0;
+    int position = 0;
+    for (int e = 0; e < endpoint_count; e++) {
+        EndpointPaths* paths = &refinement.candidates[e];
+        int length = paths->path_start[paths->path_count];
+        memcpy(refinement.nodes + position, paths->nodes, length * sizeof(NodeId));
+        memcpy(refinement.transitions + position, paths->transitions, length);
+        for (int p = 0; p < paths->path_count; p++) {
+            refinement.path_start[path] = position + paths->path_start[p];
+            refinement.owner[path] = e;
+            refinement.order[path] = path;
+            path++;
+        }
+        position += length;
+        free(paths->nodes);
+        free(paths->transitions);
+    }
+    refinement.path_start[path_total] = position;
+
+    path_order_refinement = &refinement;
+    qsort(refinement.order, path_total, sizeof(int), compare_path_prefix);
+
+    refinement.prefix_time = malloc(thread_count * sizeof(double*));
+    refinement.prefix_slew = malloc(thread_count * sizeof(double*));
+    refinement.batches = malloc(thread_count * sizeof(DelayBatch*));
+    refinement.evaluations = calloc(thread_count, sizeof(long long));
+    for (int w = 0; w < thread_count; w++) {
+        refinement.prefix_time[w] = malloc(longest * sizeof(double));
+        refinement.prefix_slew[w] = malloc(longest * sizeof(double));
+        refinement.batches[w] = malloc(sizeof(DelayBatch));
+    }
+    run_batch(thread_count, path_total, PBA_CHUNK, retime_paths, &refinement);
+
+    PathBasedTiming* timing = calloc(1, sizeof(PathBasedTiming));
+    timing->endpoint_count = endpoint_count;
+    timing->endpoints = malloc((endpoint_count + 1) * sizeof(NodeId));
+    timing->graph_slack = malloc((endpoint_count + 1) * sizeof(double));
+    timing->path_slack = malloc((endpoint_count + 1) * sizeof(double));
+    timing->path_count = malloc((endpoint_count + 1) * sizeof(int));
+    timing->exact = malloc(endpoint_count + 1);
+    for (int e = 0; e < endpoint_count; e++) {
+        timing->endpoints[e] = sorted[e].node;
+        timing->graph_slack[e] = sorted[e].slack;
+        timing->path_slack[e] = DBL_MAX;
+        timing->path_count[e] = refinement.candidates[e].path_count;
+    }
+    for (int p = 0; p < path_total; p++) {
+        int e = refinement.owner[p];
+        timing->path_slack[e] = fmin(timing->path_slack[e], refinement.path_slack[p]);
+    }
+    for (int e = 0; e < endpoint_count; e++) {
+        const EndpointPaths* paths = &refinement.candidates[e];
+        double bound = paths->path_count > 0 ? paths->graph_slack[paths->path_count - 1] : DBL_MAX;
+        timing->exact[e] = paths->complete || timing->path_slack[e] <= bound;
+        if (!timing->exact[e]) timing->path_slack[e] = bound;
+        // A path's slack is never below the graph-based slack; with exceptions
+        // the two are summed in different orders, so clamp the rounding
+        if (timing->path_slack[e] == DBL_MAX || timing->path_slack[e] < timing->graph_slack[e]) {
+            timing->path_slack[e] = timing->graph_slack[e];
+        }
+    }
+    timing->path_nodes = node_total - path_total;
+    for (int w = 0; w < thread_count; w++) timing->evaluations += refinement.evaluations[w];
+
+    for (int e = 0; e < endpoint_count; e++) {
+        free(refinement.candidates[e].path_start);
+        free(refinement.candidates[e].graph_slack);
+    }
+    for (int w = 0; w < thread_count; w++) {
+        free(refinement.searches[w].entries);
+        free(refinement.searches[w].heap);
+        free(refinement.prefix_time[w]);
+        free(refinement.prefix_slew[w]);
+        free(refinement.batches[w]);
+    }
+    free(refinement.candidates);
+    free(refinement.searches);
+    free(refinement.nodes);
+    free(refinement.transitions);
+    free(refinement.path_start);
+    free(refinement.owner);
+    free(refinement.order);
+    free(refinement.path_slack);
+    free(refinement.prefix_time);
+    free(refinement.prefix_slew);
+    free(refinement.batches);
+    free(refinement.evaluations);
+    free(sorted);
+    return timing;
+}
+
+// Print graph-based against path-based slack of the refined endpoints
+void print_path_based_timing(const Circuit* circuit, const PathBasedTiming* timing) {
+    int paths = 0;
+    int graph_failing = 0;
+    int path_failing = 0;
+    int bounded = 0;
+    for (int e = 0; e < timing->endpoint_count; e++) {
+        paths += timing->path_count[e];
+        if (timing->graph_slack[e] < 0.0) graph_failing++;
+        if (timing->path_slack[e] < 0.0) path_failing++;
+        if (!timing->exact[e]) bounded++;
+    }
+
+    printf("Path-Based Timing:\n");
+    printf("---------------------\n");
+    printf("Endpoints: %d  Paths: %d  Failing: %d graph-based, %d path-based\n",
+           timing->endpoint_count, paths, graph_failing, path_failing);
+    printf("Gate evaluations: %lld of %lld (shared prefixes)\n", timing->evaluations, timing->path_nodes);
+    printf("%-24s %12s %12s %12s %8s\n", "Endpoint", "Graph", "Path", "Recovered", "Paths");
+
+    for (int e = 0; e < timing->endpoint_count; e++) {
+        printf("%-24s %9.3f ns %9.3f ns %9.3f ns %8d%s\n", node_name(circuit, timing->endpoints[e]),
+               timing->graph_slack[e], timing->path_slack[e], timing->path_slack[e] - timing->graph_slack[e],
+               timing->path_count[e], timing->exact[e] ? "" : " *");
+    }
+    if (bounded > 0) {
+        printf("* path budget reached before the bound closed; path slack is a lower bound\n");
+    }
+    printf("\n");
+}
+
+// Free a result returned by compute_path_based_timing()
+void free_path_based_timing(PathBasedTiming* timing) {
+    if (!timing) return;
+    free(timing->endpoints);
+    free(timing->graph_slack);
+    free(timing->path_slack);
+    free(timing->path_count);
+    free(timing->exact);
+    free(timing);
+}
+
+// Out-of-core timing. The levelized graph is renumbered in level order
+// into records, cut into chunks of whole levels (a level too large for
+// one chunk is split) and written to a partition file. A forward and a
+// backward pass then stream the chunks while the next one is read ahead.
+// A flip-flop becomes two records, its launch placed just before the
+// level of its first fan-out and its D-pin endpoint at its own level, so
+// every edge leads to a later record. Values crossing chunks wait in a
+// sorted live table until the pass is past their last reader. Arrivals
+// are spilled per chunk between the passes, and the slack of every node
+// is written to a file indexed by node.
+
+// Sections of a partition chunk, in file order
+enum {
+    CHUNK_ID,
+    CHUNK_TYPE,
+    CHUNK_RISE_DELAY,
+    CHUNK_FALL_DELAY,
+    CHUNK_EXTERNAL,
+    CHUNK_FANIN_START,
+    CHUNK_FANIN,
+    CHUNK_FANOUT_START,
+    CHUNK_FANOUT,
+    CHUNK_SECTION_COUNT
+};
+
+typedef struct {
+    int begin;               // First record
+    int count;
+    int fanin_count;
+    int fanout_count;
+    off_t offset;            // Position in the partition file
+    size_t size;
+} TimingChunk;
+
+// A chunk's sections inside a read buffer. Edges hold record numbers.
+typedef struct {
+    const NodeId* id;        // Node of each record (the flip-flop for a launch)
+    const unsigned char* type;
+    const double* delay[TRANSITION_COUNT];
+    const double* external;  // Port delay of a port, setup time of a flip-flop
+    const int* fanin_start;  // Fan-in of record i is fanin[fanin_start[i] .. fanin_start[i + 1] - 1]
+    const int* fanin;
+    const int* fanout_start;
+    const int* fanout;
+} ChunkView;
+
+typedef struct {
+    int fd;                  // Partition file, unlinked once created
+    int arrival_fd;          // Arrival spill, unlinked once created
+    TimingChunk* chunks;
+    int chunk_count;
+    int record_count;
+    int max_count;           // Largest chunk in records
+    size_t max_size;         // Largest chunk in bytes
+    long long bytes_read;
+    long long bytes_written;
+} PartitionedGraph;
+
+// Values computed in one chunk and read in a later one, sorted by key:
+// the record going forward, its negation going backward. An entry is
+// dropped once the pass has moved past the key of its last reader.
+typedef struct {
+    int* key;
+    int* expires;
+    double* value;           // Rise and fall per entry
+    int count;
+    int capacity;
+    int peak;
+} LiveValues;
+
+// Chunk read ahead on a helper thread while the current one is timed:
+// its graph and, going backward, its spilled arrivals
+typedef struct {
+    int fd[2];
+    void* buffer[2];
+    size_t size[2];
+    off_t offset[2];
+    int count;
+    int failed;
+    int threaded;
+    pthread_t thread;
+} ChunkRead;
+
+// Byte offset of every chunk section for the given counts, 8-byte
+// aligned. Returns the chunk size.
+static size_t chunk_layout(int count, int fanin_count, int fanout_count, size_t offset[CHUNK_SECTION_COUNT]) {
+    size_t sizes[CHUNK_SECTION_COUNT] = {
+        (size_t)count * sizeof(NodeId), (size_t)count, (size_t)count * sizeof(double),
+        (size_t)count * sizeof(double), (size_t)count * sizeof(double), ((size_t)count + 1) * sizeof(int),
+        (size_t)fanin_count * sizeof(int), ((size_t)count + 1) * sizeof(int), (size_t)fanout_count * sizeof(int)
+    };
+    size_t size = 0;
+    for (int s = 0; s < CHUNK_SECTION_COUNT; s++) {
+        offset[s] = size;
+        size = (size + sizes[s] + 7) & ~(size_t)7;
+    }
+    return size;
+}
+
+static ChunkView chunk_view(const char* buffer, const TimingChunk* chunk) {
+    size_t offset[CHUNK_SECTION_COUNT];
+    chunk_layout(chunk->count, chunk->fanin_count, chunk->fanout_count, offset);
+    ChunkView view;
+    view.id = (const NodeId*)(buffer + offset[CHUNK_ID]);
+    view.type = (const unsigned char*)(buffer + offset[CHUNK_TYPE]);
+    view.delay[TRANSITION_RISE] = (const double*)(buffer + offset[CHUNK_RISE_DELAY]);
+    view.delay[TRANSITION_FALL] = (const double*)(buffer + offset[CHUNK_FALL_DELAY]);
+    view.external = (const double*)(buffer + offset[CHUNK_EXTERNAL]);
+    view.fanin_start = (const int*)(buffer + offset[CHUNK_FANIN_START]);
+    view.fanin = (const int*)(buffer + offset[CHUNK_FANIN]);
+    view.fanout_start = (const int*)(buffer + offset[CHUNK_FANOUT_START]);
+    view.fanout = (const int*)(buffer + offset[CHUNK_FANOUT]);
+    return view;
+}
+
+// Create directory/name for reading and writing. Scratch files are
+// unlinked at once, so they vanish when closed however the run ends.
+// Returns the descriptor or -1.
+static int open_scratch(const char* directory, const char* name, int keep) {
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/%s", directory, name);
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot create %s\n", path);
+        return -1;
+    }
+    if (!keep) unlink(path);
+    return fd;
+}
+
+static int read_fully(int fd, void* buffer, size_t size, off_t offset) {
+    for (size_t done = 0; done < size;) {
+        ssize_t count = pread(fd, (char*)buffer + done, size - done, offset + done);
+        if (count <= 0) return -1;
+        done += count;
+    }
+    return 0;
+}
+
+static int write_fully(int fd, const void* buffer, size_t size, off_t offset) {
+    for (size_t done = 0; done < size;) {
+        ssize_t count = pwrite(fd, (const char*)buffer + done, size - done, offset + done);
+        if (count <= 0) return -1;
+        done += count;
+    }
+    return 0;
+}
+
+static void* chunk_read_worker(void* argument) {
+    ChunkRead* read = argument;
+    for (int r = 0; r < read->count; r++) {
+        if (read_fully(read->fd[r], read->buffer[r], read->size[r], read->offset[r]) != 0) read->failed = 1;
+    }
+    return NULL;
+}
+
+// Start reading; without a thread the read happens here
+static void chunk_read_start(ChunkRead* read) {
+    read->failed = 0;
+    read->threaded = pthread_create(&read->thread, NULL, chunk_read_worker, read) == 0;
+    if (!read->threaded) chunk_read_worker(read);
+}
+
+static int chunk_read_finish(ChunkRead* read) {
+    if (read->threaded) pthread_join(read->thread, NULL);
+    read->threaded = 0;
+    return read->failed ? -1 : 0;
+}
+
+// Queue chunk c of graph (and its arrivals when arrivals is set) into
+// the given buffers
+static void chunk_read_prepare(ChunkRead* read, const PartitionedGraph* graph, int c,
+                               void* buffer, double* arrivals) {
+    const TimingChunk* chunk = &graph->chunks[c];
+    read->count = 1;
+    read->fd[0] = graph->fd;
+    read->buffer[0] = buffer;
+    read->size[0] = chunk->size;
+    read->offset[0] = chunk->offset;
+    if (arrivals) {
+        read->count = 2;
+        read->fd[1] = graph->arrival_fd;
+        read->buffer[1] = arrivals;
+        read->size[1] = (size_t)chunk->count * TRANSITION_COUNT * sizeof(double);
+        read->offset[1] = (off_t)chunk->begin * TRANSITION_COUNT * sizeof(double);
+    }
+}
+
+static int live_find(const LiveValues* live, int key) {
+    int low = 0, high = live->count - 1;
+    while (low <= high) {
+        int middle = (low + high) / 2;
+        if (live->key[middle] == key) return middle;
+        if (live->key[middle] < key) low = middle + 1; else high = middle - 1;
+    }
+    return -1;
+}
+
+// Append an entry; keys must arrive in increasing order
+static void live_push(LiveValues* live, int key, int expires, double rise, double fall) {
+    if (live->count == live->capacity) {
+        live->capacity = live->capacity ? live->capacity * 2 : 1024;
+        live->key = grow_array(live->key, live->capacity, sizeof(int));
+        live->expires = grow_array(live->expires, live->capacity, sizeof(int));
+        live->value = grow_array(live->value, (size_t)live->capacity * TRANSITION_COUNT, sizeof(double));
+    }
+    live->key[live->count] = key;
+    live->expires[live->count] = expires;
+    live->value[(size_t)live->count * TRANSITION_COUNT + TRANSITION_RISE] = rise;
+    live->value[(size_t)live->count * TRANSITION_COUNT + TRANSITION_FALL] = fall;
+    live->count++;
+    if (live->count > live->peak) live->peak = live->count;
+}
+
+// Drop every entry whose last reader comes before next_key
+static void live_evict(LiveValues* live, int next_key) {
+    int kept = 0;
+    for (int i = 0; i < live->count; i++) {
+        if (live->expires[i] < next_key) continue;
+        live->key[kept] = live->key[i];
+        live->expires[kept] = live->expires[i];
+        live->value[(size_t)kept * TRANSITION_COUNT + TRANSITION_RISE] = live->value[(size_t)i * TRANSITION_COUNT + TRANSITION_RISE];
+        live->value[(size_t)kept * TRANSITION_COUNT + TRANSITION_FALL] = live->value[(size_t)i * TRANSITION_COUNT + TRANSITION_FALL];
+        kept++;
+    }
+    live->count = kept;
+}
+
+// Record numbers of the partition, kept in a scratch mapping so they
+// are paged like the graph itself rather than held on the heap
+typedef struct {
+    int* position;           // Record of each node
+    int* launch;             // Launch record of each flip-flop, -1 if it drives nothing
+    int* node;               // Node behind each record; -1 - flip-flop for a launch
+} RecordMap;
+
+static int record_fanin_count(const Circuit* circuit, const RecordMap* map, int record) {
+    NodeId node = map->node[record];
+    return node < 0 ? 0 : circuit->fanin_start[node + 1] - circuit->fanin_start[node];
+}
+
+static int record_fanout_count(const Circuit* circuit, const RecordMap* map, int record) {
+    NodeId node = map->node[record];
+    if (node < 0) node = -1 - node;
+    else if (circuit->type[node] == GATE_DFF) return 0;
+    return circuit->fanout_start[node + 1] - circuit->fanout_start[node];
+}
+
+static size_t record_size(const Circuit* circuit, const RecordMap* map, int record) {
+    return sizeof(NodeId) + 1 + 3 * sizeof(double) + 2 * sizeof(int) +
+           (record_fanin_count(circuit, map, record) + record_fanout_count(circuit, map, record)) * sizeof(int);
+}
+
+// Write records begin .. end - 1 as the next chunk. Returns 0 or -1.
+static int write_chunk(const Circuit* circuit, const RecordMap* map, PartitionedGraph* graph,
+                       char** buffer, size_t* capacity, int begin, int end) {
+    TimingChunk chunk = {begin, end - begin, 0, 0, 0, 0};
+    for (int r = begin; r < end; r++) {
+        chunk.fanin_count += record_fanin_count(circuit, map, r);
+        chunk.fanout_count += record_fanout_count(circuit, map, r);
+    }
+    size_t offset[CHUNK_SECTION_COUNT];
+    chunk.size = chunk_layout(chunk.count, chunk.fanin_count, chunk.fanout_count, offset);
+    if (chunk.size > *capacity) {
+        *buffer = grow_array(*buffer, chunk.size, 1);
+        *capacity = chunk.size;
+    }
+    memset(*buffer, 0, chunk.size);
+    char* base = *buffer;
+    NodeId* id = (NodeId*)(base + offset[CHUNK_ID]);
+    unsigned char* type = (unsigned char*)(base + offset[CHUNK_TYPE]);
+    double* delay[TRANSITION_COUNT] = {(double*)(base + offset[CHUNK_RISE_DELAY]), (double*)(base + offset[CHUNK_FALL_DELAY])};
+    double* external = (double*)(base + offset[CHUNK_EXTERNAL]);
+    int* fanin_start = (int*)(base + offset[CHUNK_FANIN_START]);
+    int* fanin = (int*)(base + offset[CHUNK_FANIN]);
+    int* fanout_start = (int*)(base + offset[CHUNK_FANOUT_START]);
+    int* fanout = (int*)(base + offset[CHUNK_FANOUT]);
+
+    fanin_start[0] = 0;
+    fanout_start[0] = 0;
+    for (int i = 0; i < chunk.count; i++) {
+        NodeId node = map->node[begin + i];
+        int launch = node < 0;
+        if (launch) node = -1 - node;
+        id[i] = node;
+        type[i] = launch ? RECORD_LAUNCH : circuit->type[node];
+        for (int t = 0; t < TRANSITION_COUNT; t++) delay[t][i] = circuit->delay[t][node];
+        external[i] = circuit->type[node] == GATE_DFF ? circuit->setup_time : circuit->port_delay[node];
+
+        int in = fanin_start[i];
+        if (!launch) {
+            for (int j = circuit->fanin_start[node]; j < circuit->fanin_start[node + 1]; j++) {
+                NodeId input = circuit->fanin[j];
+                fanin[in++] = circuit->type[input] == GATE_DFF ? map->launch[input] : map->position[input];
+            }
+        }
+        fanin_start[i + 1] = in;
+
+        int out = fanout_start[i];
+        if (launch || circuit->type[node] != GATE_DFF) {
+            for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+                fanout[out++] = map->position[circuit->fanout[j]];
+            }
+        }
+        fanout_start[i + 1] = out;
+    }
+
+    chunk.offset = graph->chunk_count > 0 ? graph->chunks[graph->chunk_count - 1].offset +
+                                            (off_t)graph->chunks[graph->chunk_count - 1].size : 0;
+    if (write_fully(graph->fd, base, chunk.size, chunk.offset) != 0) {
+        fprintf(stderr, "Error writing timing partition\n");
+        return -1;
+    }
+    graph->bytes_written += chunk.size;
+    graph->chunks = grow_array(graph->chunks, graph->chunk_count + 1, sizeof(TimingChunk));
+    graph->chunks[graph->chunk_count++] = chunk;
+    if (chunk.count > graph->max_count) graph->max_count = chunk.count;
+    if (chunk.size > graph->max_size) graph->max_size = chunk.size;
+    return 0;
+}
+
+// Renumber the levelized graph into records and write it to a partition
+// file in directory in chunks of about chunk_limit bytes. Returns 0 on
+// success, -1 on error.
+static int partition_timing_graph(const Circuit* circuit, const char* directory, size_t chunk_limit,
+                                  PartitionedGraph* graph) {
+    TRACE_SCOPE("partition_timing_graph");
+    int n = circuit->node_count;
+    int level_count = circuit->level_count;
+
+    int launch_total = 0;
+    for (NodeId node = 0; node < n; node++) {
+        if (circuit->type[node] == GATE_DFF && circuit->fanout_start[node + 1] > circuit->fanout_start[node]) {
+            launch_total++;
+        }
+    }
+    int record_count = n + launch_total;
+    size_t map_size = ((size_t)n * 2 + record_count + 1) * sizeof(int);
+    int map_fd = open_scratch(directory, "records.map", 0);
+    if (map_fd < 0) return -1;
+    int* map_base = ftruncate(map_fd, map_size) == 0
+                  ? mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_SHARED, map_fd, 0) : MAP_FAILED;
+    close(map_fd);
+    if (map_base == MAP_FAILED) {
+        fprintf(stderr, "Cannot map partition scratch space in %s\n", directory);
+        return -1;
+    }
+    RecordMap map = {map_base, map_base + n, map_base + 2 * (size_t)n};
+
+    // Each level's records: the launches it reads first, then its nodes
+    int* launch_count = calloc(level_count + 1, sizeof(int));
+    int* record_start = malloc((level_count + 1) * sizeof(int));
+    for (NodeId node = 0; node < n; node++) {
+        map.launch[node] = -1;
+        if (circuit->type[node] != GATE_DFF) continue;
+        int first = INT_MAX;
+        for (int j = circuit->fanout_start[node]; j < circuit->fanout_start[node + 1]; j++) {
+            if (circuit->level[circuit->fanout[j]] < first) first = circuit->level[circuit->fanout[j]];
+        }
+        if (first == INT_MAX) continue;
+        map.launch[node] = first;
+        launch_count[first]++;
+    }
+    record_start[0] = 0;
+    for (int l = 0; l < level_count; l++) {
+        int nodes = circuit->level_start[l + 1] - circuit->level_start[l];
+        record_start[l + 1] = record_start[l] + launch_count[l] + nodes;
+        for (int k = circuit->level_start[l]; k < circuit->level_start[l + 1]; k++) {
+            int record = record_start[l] + launch_count[l] + (k - circuit->level_start[l]);
+            map.position[circuit->level_order[k]] = record;
+            map.node[record] = circuit->level_order[k];
+        }
+        launch_count[l] = record_start[l];   // Now the next free launch record
+    }
+    for (NodeId node = 0; node < n; node++) {
+        if (map.launch[node] < 0) continue;
+        int record = launch_count[map.launch[node]]++;
+        map.launch[node] = record;
+        map.node[record] = -1 - node;
+    }
+    free(launch_count);
+
+    graph->record_count = record_count;
+    graph->fd = open_scratch(directory, "timing.part", 0);
+    int status = graph->fd < 0 ? -1 : 0;
+    char* buffer = NULL;
+    size_t capacity = 0;
+    int begin = 0;
+    size_t size = 0;
+    for (int l = 0; l < level_count && status == 0; l++) {
+        size_t level_size = 0;
+        for (int r = record_start[l]; r < record_start[l + 1]; r++) level_size += record_size(circuit, &map, r);
+        if (size > 0 && size + level_size > chunk_limit) {
+            status = write_chunk(circuit, &map, graph, &buffer, &capacity, begin, record_start[l]);
+            begin = record_start[l];
+            size = 0;
+        }
+        // Only a level larger than a whole chunk is split
+        for (int r = record_start[l]; r < record_start[l + 1] && status == 0; r++) {
+            size_t bytes = record_size(circuit, &map, r);
+            if (size > 0 && size + bytes > chunk_limit) {
+                status = write_chunk(circuit, &map, graph, &buffer, &capacity, begin, r);
+                begin = r;
+                size = 0;
+            }
+            size += bytes;
+        }
+    }
+    if (status == 0 && begin < record_count) {
+        status = write_chunk(circuit, &map, graph, &buffer, &capacity, begin, record_count);
+    }
+    free(buffer);
+    free(record_start);
+    munmap(map_base, map_size);
+    return status;
+}
+
+// Forward pass over one chunk: arrivals into arrival (rise then fall per
+// record), each record's output time for later readers into output, and
+// the latest endpoint arrival plus margin into reference. Matches
+// node_arrival() and launch_time() operation for operation.
+static void forward_chunk(const ChunkView* view, const TimingChunk* chunk, LiveValues* live,
+                          double* arrival, double* output, double* reference) {
+    int count = chunk->count;
+    int end = chunk->begin + count;
+    for (int i = 0; i < count; i++) {
+        int type = view->type[i];
+        double late[TRANSITION_COUNT];
+        if (type == RECORD_LAUNCH) {
+            // Launch on the clock edge at time zero
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                arrival[t * count + i] = 0.0;
+                output[t * count + i] = 0.0 + view->delay[t][i];
+            }
+        } else {
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                late[t] = type == INPUT ? view->external[i] : 0.0;
+            }
+            // A primary input arrives at its input delay whatever drives it
+            int fanin_end = type == INPUT ? view->fanin_start[i] : view->fanin_start[i + 1];
+            for (int j = view->fanin_start[i]; j < fanin_end; j++) {
+                int source = view->fanin[j];
+                for (int t = 0; t < TRANSITION_COUNT; t++) {
+                    double value = source >= chunk->begin
+                                 ? output[t * count + source - chunk->begin]
+                                 : live->value[(size_t)live_find(live, source) * TRANSITION_COUNT + t];
+                    late[t] = fmax(late[t], value);
+                }
+            }
+            for (int t = 0; t < TRANSITION_COUNT; t++) arrival[t * count + i] = late[t];
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                double launch;
+                switch (gate_unateness[type]) {
+                    case UNATE_POSITIVE: launch = late[t]; break;
+                    case UNATE_NEGATIVE: launch = late[!t]; break;
+                    default: launch = fmax(late[TRANSITION_RISE], late[TRANSITION_FALL]); break;
+                }
+                output[t * count + i] = launch + view->delay[t][i];
+            }
+            if (type == OUTPUT || type == GATE_DFF) {
+                *reference = fmax(*reference, fmax(late[TRANSITION_RISE], late[TRANSITION_FALL]) + view->external[i]);
+            }
+        }
+
+        int last = -1;
+        for (int j = view->fanout_start[i]; j < view->fanout_start[i + 1]; j++) {
+            if (view->fanout[j] > last) last = view->fanout[j];
+        }
+        if (last >= end) {
+            live_push(live, chunk->begin + i, last, output[i], output[count + i]);
+        }
+    }
+}
+
+// Backward pass over one chunk: required times into required, node slack
+// into slack (indexed by node) and endpoint totals into result. Matches
+// node_required() and node_slack() operation for operation.
+static void backward_chunk(const ChunkView* view, const TimingChunk* chunk, LiveValues* live,
+                           const double* arrival, double* required, double reference,
+                           double* slack, OutOfCoreTiming* result) {
+    int count = chunk->count;
+    int end = chunk->begin + count;
+    for (int i = count - 1; i >= 0; i--) {
+        int type = view->type[i];
+        double value[TRANSITION_COUNT];
+        if (type == RECORD_LAUNCH) {
+            // The flip-flop's endpoint record carries its required time
+            required[i] = DBL_MAX;
+            required[count + i] = DBL_MAX;
+            continue;
+        }
+        if (type == OUTPUT || type == GATE_DFF) {
+            value[TRANSITION_RISE] = reference - view->external[i];
+            value[TRANSITION_FALL] = value[TRANSITION_RISE];
+        } else {
+            double output[TRANSITION_COUNT];
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                double node_required_time = DBL_MAX;
+                for (int j = view->fanout_start[i]; j < view->fanout_start[i + 1]; j++) {
+                    int sink = view->fanout[j];
+                    double sink_required = sink < end
+                                         ? required[t * count + sink - chunk->begin]
+                                         : live->value[(size_t)live_find(live, -sink) * TRANSITION_COUNT + t];
+                    node_required_time = fmin(node_required_time, sink_required);
+                }
+                output[t] = node_required_time == DBL_MAX ? DBL_MAX : node_required_time - view->delay[t][i];
+            }
+            switch (gate_unateness[type]) {
+                case UNATE_POSITIVE:
+                    value[TRANSITION_RISE] = output[TRANSITION_RISE];
+                    value[TRANSITION_FALL] = output[TRANSITION_FALL];
+                    break;
+                case UNATE_NEGATIVE:
+                    value[TRANSITION_RISE] = output[TRANSITION_FALL];
+                    value[TRANSITION_FALL] = output[TRANSITION_RISE];
+                    break;
+                default:
+                    value[TRANSITION_RISE] = fmin(output[TRANSITION_RISE], output[TRANSITION_FALL]);
+                    value[TRANSITION_FALL] = value[TRANSITION_RISE];
+                    break;
+            }
+        }
+        required[i] = value[TRANSITION_RISE];
+        required[count + i] = value[TRANSITION_FALL];
+
+        double node_slack = fmin(value[TRANSITION_RISE] - arrival[i], value[TRANSITION_FALL] - arrival[count + i]);
+        slack[view->id[i]] = node_slack;
+        if (type == OUTPUT || type == GATE_DFF) {
+            result->endpoint_count++;
+            result->worst_slack = fmin(result->worst_slack, node_slack);
+            if (node_slack < 0.0) {
+                result->violations++;
+                result->total_negative_slack += node_slack;
+            }
+        }
+
+        int first = INT_MAX;
+        for (int j = view->fanin_start[i]; j < view->fanin_start[i + 1]; j++) {
+            if (view->fanin[j] < first) first = view->fanin[j];
+        }
+        if (first < chunk->begin) {
+            live_push(live, -(chunk->begin + i), -first, value[TRANSITION_RISE], value[TRANSITION_FALL]);
+        }
+    }
+}
+
+// Time the circuit without holding its timing state in memory: partition
+// the graph into directory, stream it forward and backward within about
+// memory_budget bytes, and write every node's slack, identical to
+// compute_slack(), to directory/slack.bin as doubles in node order.
+// Timing exceptions are not supported. Returns 0 on success, -1 on error.
+int compute_out_of_core_timing(Circuit* circuit, const char* directory, size_t memory_budget,
+                               OutOfCoreTiming* result) {
+    TRACE_SCOPE("compute_out_of_core_timing");
+    memset(result, 0, sizeof(*result));
+    if (circuit->exception_count > 0) {
+        fprintf(stderr, "Out-of-core timing does not support timing exceptions\n");
+        return -1;
+    }
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return -1;
+    if (memory_budget < OUT_OF_CORE_MIN_BUDGET) memory_budget = OUT_OF_CORE_MIN_BUDGET;
+    result->memory_budget = memory_budget;
+    result->worst_slack = DBL_MAX;
+
+    PartitionedGraph graph = {0};
+    graph.arrival_fd = -1;
+    if (partition_timing_graph(circuit, directory, memory_budget / OUT_OF_CORE_CHUNK_SHARE, &graph) != 0) {
+        if (graph.fd >= 0) close(graph.fd);
+        free(graph.chunks);
+        return -1;
+    }
+
+    int n = circuit->node_count;
+    size_t slack_size = ((size_t)n + 1) * sizeof(double);
+    int slack_fd = open_scratch(directory, "slack.bin", 1);
+    graph.arrival_fd = open_scratch(directory, "arrival.spill", 0);
+    double* slack = MAP_FAILED;
+    if (slack_fd >= 0 && ftruncate(slack_fd, slack_size) == 0) {
+        slack = mmap(NULL, slack_size, PROT_READ | PROT_WRITE, MAP_SHARED, slack_fd, 0);
+    }
+    if (slack_fd >= 0) close(slack_fd);
+    int status = slack == MAP_FAILED || graph.arrival_fd < 0 ? -1 : 0;
+    if (status != 0) fprintf(stderr, "Cannot set up out-of-core timing files in %s\n", directory);
+
+    // Double buffers: one chunk is timed while the next is read
+    size_t value_size = ((size_t)graph.max_count + 1) * TRANSITION_COUNT * sizeof(double);
+    char* buffer[2];
+    double* arrival[2];
+    for (int b = 0; b < 2; b++) {
+        buffer[b] = grow_array(NULL, graph.max_size + 1, 1);
+        arrival[b] = grow_array(NULL, value_size, 1);
+    }
+    double* values = grow_array(NULL, value_size, 1);
+    result->buffer_bytes = 2 * (graph.max_size + value_size) + value_size;
+
+    LiveValues live = {0};
+    ChunkRead read = {0};
+    double reference = 0.0;
+    int last = graph.chunk_count - 1;
+    if (status == 0 && graph.chunk_count > 0) {
+        TRACE_SCOPE("out_of_core_forward");
+        chunk_read_prepare(&read, &graph, 0, buffer[0], NULL);
+        chunk_read_start(&read);
+        for (int c = 0; c <= last && status == 0; c++) {
+            status = chunk_read_finish(&read);
+            if (status != 0) break;
+            if (c < last) {
+                chunk_read_prepare(&read, &graph, c + 1, buffer[(c + 1) & 1], NULL);
+                chunk_read_start(&read);
+            }
+            const TimingChunk* chunk = &graph.chunks[c];
+            graph.bytes_read += chunk->size;
+            ChunkView view = chunk_view(buffer[c & 1], chunk);
+            forward_chunk(&view, chunk, &live, arrival[0], values, &reference);
+            size_t spill = (size_t)chunk->count * TRANSITION_COUNT * sizeof(double);
+            status = write_fully(graph.arrival_fd, arrival[0], spill, (off_t)chunk->begin * TRANSITION_COUNT * sizeof(double));
+            graph.bytes_written += spill;
+            live_evict(&live, chunk->begin + chunk->count);
+        }
+        if (status == 0 && live.count > 0) status = -1;   // Every value has been read by now
+        chunk_read_finish(&read);
+        result->peak_live = live.peak;
+    }
+
+    // Same reference as endpoint_reference()
+    double required_reference = circuit->clock_period > 0.0 ? circuit->clock_period : reference;
+    live.count = 0;
+    live.peak = 0;
+    if (status == 0 && graph.chunk_count > 0) {
+        TRACE_SCOPE("out_of_core_backward");
+        chunk_read_prepare(&read, &graph, last, buffer[last & 1], arrival[last & 1]);
+        chunk_read_start(&read);
+        for (int c = last; c >= 0 && status == 0; c--) {
+            status = chunk_read_finish(&read);
+            if (status != 0) break;
+            if (c > 0) {
+                chunk_read_prepare(&read, &graph, c - 1, buffer[(c - 1) & 1], arrival[(c - 1) & 1]);
+                chunk_read_start(&read);
+            }
+            const TimingChunk* chunk = &graph.chunks[c];
+            graph.bytes_read += chunk->size + (size_t)chunk->count * TRANSITION_COUNT * sizeof(double);
+            ChunkView view = chunk_view(buffer[c & 1], chunk);
+            backward_chunk(&view, chunk, &live, arrival[c & 1], values, required_reference, slack, result);
+            live_evict(&live, 1 - chunk->begin);
+        }
+        if (status == 0 && live.count > 0) status = -1;
+        chunk_read_finish(&read);
+        if (live.peak > result->peak_live) result->peak_live = live.peak;
+    }
+    if (status != 0 && slack != MAP_FAILED) fprintf(stderr, "Error streaming the timing partition in %s\n", directory);
+    if (result->endpoint_count == 0) result->worst_slack = 0.0;
+
+    result->record_count = graph.record_count;
+    result->chunk_count = graph.chunk_count;
+    result->live_bytes = (size_t)result->peak_live * (2 * sizeof(int) + TRANSITION_COUNT * sizeof(double));
+    result->bytes_read = graph.bytes_read;
+    result->bytes_written = graph.bytes_written + (long long)n * sizeof(double);
+
+    if (slack != MAP_FAILED) munmap(slack, slack_size);
+    for (int b = 0; b < 2; b++) {
+        free(buffer[b]);
+        free(arrival[b]);
+    }
+    free(values);
+    free(live.key);
+    free(live.expires);
+    free(live.value);
+    free(graph.chunks);
+    if (graph.fd >= 0) close(graph.fd);
+    if (graph.arrival_fd >= 0) close(graph.arrival_fd);
+    return status;
+}
+
+void print_out_of_core_timing(const OutOfCoreTiming* timing, const char* directory) {
+    printf("Out-of-Core Timing:\n");
+    printf("---------------------\n");
+    printf("Records: %d in %d chunk(s)  Memory budget: %.1f MB\n",
+           timing->record_count, timing->chunk_count, timing->memory_budget / 1048576.0);
+    printf("Buffers: %.1f MB  Peak live values: %d (%.1f MB)\n",
+           timing->buffer_bytes / 1048576.0, timing->peak_live, timing->live_bytes / 1048576.0);
+    printf("Read: %.1f MB  Written: %.1f MB\n", timing->bytes_read / 1048576.0, timing->bytes_written / 1048576.0);
+    printf("Endpoints: %d  Violations: %d  WNS: %.3f ns  TNS: %.3f ns\n",
+           timing->endpoint_count, timing->violations, timing->worst_slack, timing->total_negative_slack);
+    if (timing->buffer_bytes + timing->live_bytes > timing->memory_budget) {
+        printf("Note: live values across the widest level cut exceeded the budget\n");
+    }
+    printf("Slack per node: %s/slack.bin\n\n", directory);
+}
+
+// Printable name of a gate type
+const char* gate_type_name(GateType type) {
+    switch (type) {
+        case GATE_AND:  return "AND";
+        case GATE_OR:   return "OR";
+        case GATE_NOT:  return "NOT";
+        case GATE_NAND: return "NAND";
+        case GATE_NOR:  return "NOR";
+        case GATE_XOR:  return "XOR";
+        case INPUT:     return "INPUT";
+        case OUTPUT:    return "OUTPUT";
+        case GATE_DFF:  return "DFF";
+    }
+    return "?";
+}
+
+// Open-addressing hash table from names to small integers. Keys are not
+// copied: they point into the memory-mapped netlist (or an arena), so
+// interning a name costs one hash and one probe sequence. Each slot also
+// holds the first eight bytes of its key, so short names (most net
+// names) are compared without a second cache miss into the key text.
+typedef struct {
+    const char* key;         // NULL for an empty slot
+    uint64_t prefix;
+    int length;
+    int value;
+} NameSlot;
+
+typedef struct {
+    NameSlot* slots;
+    int capacity;            // Power of two
+    int count;
+} NameTable;
+
+static unsigned int hash_name(const char* name, int length) {
+    unsigned int hash = 2166136261u;
+    for (int i = 0; i < length; i++) {
+        hash = (hash ^ (unsigned char)name[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static uint64_t name_prefix(const char* name, int length) {
+    uint64_t prefix = 0;
+    memcpy(&prefix, name, length < 8 ? length : 8);
+    return prefix;
+}
+
+static void name_table_clear(NameTable* table) {
+    if (table->slots) memset(table->slots, 0, table->capacity * sizeof(NameSlot));
+    table->count = 0;
+}
+
+static void name_table_free(NameTable* table) {
+    free(table->slots);
+    memset(table, 0, sizeof(NameTable));
+}
+
+// Slot holding the name, or the empty slot where it would go
+static NameSlot* name_table_slot(const NameTable* table, const char* name, int length) {
+    unsigned int mask = table->capacity - 1;
+    uint64_t prefix = name_prefix(name, length);
+    for (unsigned int i = hash_name(name, length) & mask;; i = (i + 1) & mask) {
+        NameSlot* slot = &table->slots[i];
+        if (!slot->key) return slot;
+        if (slot->prefix == prefix && slot->length == length &&
+            (length <= 8 || memcmp(slot->key + 8, name + 8, length - 8) == 0)) {
+            return slot;
+        }
+    }
+}
+
+static int name_table_find(const NameTable* table, const char* name, int length) {
+    if (!table->capacity) return -1;
+    const NameSlot* slot = name_table_slot(table, name, length);
+    return slot->key ? slot->value : -1;
+}
+
+// Value slot for a name, adding the name if it is new. The pointer is
+// valid until the next insertion.
+static int* name_table_intern(NameTable* table, const char* name, int length, int* created) {
+    if (2 * (table->count + 1) > table->capacity) {
+        NameTable grown = {0};
+        grown.capacity = table->capacity ? table->capacity * 2 : 1024;
+        grown.slots = calloc(grown.capacity, sizeof(NameSlot));
+        if (!grown.slots) {
+            fprintf(stderr, "Out of memory growing name table\n");
+            exit(1);
+        }
+        for (int i = 0; i < table->capacity; i++) {
+            const NameSlot* old = &table->slots[i];
+            if (old->key) *name_table_slot(&grown, old->key, old->length) = *old;
+        }
+        grown.count = table->count;
+        name_table_free(table);
+        *table = grown;
+    }
+
+    NameSlot* slot = name_table_slot(table, name, length);
+    *created = !slot->key;
+    if (*created) {
+        table->count++;
+        slot->key = name;
+        slot->prefix = name_prefix(name, length);
+        slot->length = length;
+    }
+    return &slot->value;
+}
+
+static void name_table_insert(NameTable* table, const char* name, int length, int value) {
+    int created;
+    *name_table_intern(table, name, length, &created) = value;
+}
+
+// A net while its module is being read: the driving node once known, and
+// sinks seen before the driver waiting in a linked list
+typedef struct {
+    NodeId driver;
+    int pending;             // Head of the pending-sink list, or -1
+    int bus_msb;             // Declared range when this is a vector name
+    int bus_lsb;
+    int is_bus;
+} NetState;
+
+typedef struct {
+    NodeId node;
+    int next;
+} PendingSink;
+
+// Token kinds: 'i' identifier, 'n' number, 's' string, a punctuation
+// character, or 0 at end of input. Tokens point into the mapped file.
+typedef struct {
+    int kind;
+    const char* start;
+    int length;
+} VerilogToken;
+
+typedef struct {
+    Circuit* circuit;
+    const char* path;
+    const char* text;
+    size_t length;
+    size_t position;
+    int line;
+    int error;
+    VerilogToken token;      // Current token
+    Arena names;             // Generated names such as bus bits
+
+    NameTable net_names;     // Net name -> index into nets
+    NetState* nets;
+    int net_count;
+    int net_capacity;
+    PendingSink* pending;
+    int pending_count;
+    int pending_capacity;
+    NameTable cell_kinds;    // Cell name -> (library cell + 1) * 16 + gate type
+    NameTable instance_names;   // Instance name -> node, per module
+
+    NodeId* terminals;       // Scratch list of nets on one connection
+    int terminal_count;
+    int terminal_capacity;
+
+    int module_count;
+    int gate_count;
+    int assign_count;
+    int skipped_blocks;
+    int undriven_nets;
+    int multiply_driven_nets;
+    int duplicate_instances;
+    int unnamed_instances;
+} VerilogReader;
+
+static int is_identifier_start(char c) {
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+static int is_identifier_char(char c) {
+    return is_identifier_start(c) || (c >= '0' && c <= '9') || c == '$';
+}
+
+static void verilog_next(VerilogReader* reader) {
+    const char* text = reader->text;
+    size_t length = reader->length;
+    size_t p = reader->position;
+
+    // Skip whitespace, comments, attributes and compiler directives
+    for (;;) {
+        while (p < length && (text[p] == ' ' || text[p] == '\t' || text[p] == '\r' || text[p] == '\n')) {
+            if (text[p] == '\n') reader->line++;
+            p++;
+        }
+        if (p + 1 < length && text[p] == '/' && text[p + 1] == '/') {
+            while (p < length && text[p] != '\n') p++;
+        } else if (p + 1 < length && text[p] == '/' && text[p + 1] == '*') {
+            p += 2;
+            while (p + 1 < length && !(text[p] == '*' && text[p + 1] == '/')) {
+                if (text[p] == '\n') reader->line++;
+                p++;
+            }
+            p += 2;
+        } else if (p + 1 < length && text[p] == '(' && text[p + 1] == '*' && (p + 2 >= length || text[p + 2] != ')')) {
+            p += 2;
+            while (p + 1 < length && !(text[p] == '*' && text[p + 1] == ')')) p++;
+            p += 2;
+        } else if (p < length && text[p] == '`') {
+            while (p < length && text[p] != '\n') p++;
+        } else {
+            break;
+        }
+    }
+
+    VerilogToken* token = &reader->token;
+    token->start = text + (p < length ? p : length);
+    if (p >= length) {
+        token->kind = 0;
+        token->length = 0;
+        reader->position = length;
+        return;
+    }
+
+    size_t begin = p;
+    char c = text[p];
+    if (is_identifier_start(c)) {
+        while (p < length && is_identifier_char(text[p])) p++;
+        token->kind = 'i';
+    } else if (c == '\\') {
+        // Escaped identifier: everything up to the next whitespace
+        while (p < length && text[p] != ' ' && text[p] != '\t' && text[p] != '\n' && text[p] != '\r') p++;
+        token->kind = 'i';
+    } else if ((c >= '0' && c <= '9') || (c == '\'' && p + 1 < length && strchr("bBoOdDhHsS", text[p + 1]))) {
+        // Numbers, including sized and based forms such as 4'b10x1
+        while (p < length && (is_identifier_char(text[p]) || text[p] == '\'' || text[p] == '.' || text[p] == '?')) p++;
+        token->kind = 'n';
+    } else if (c == '"') {
+        p++;
+        while (p < length && text[p] != '"' && text[p] != '\n') p++;
+        p++;
+        token->kind = 's';
+    } else {
+        p++;
+        token->kind = c;
+    }
+    token->length = p - begin;
+    reader->position = p;
+}
+
+static int token_is(const VerilogToken* token, const char* word) {
+    int length = strlen(word);
+    return token->kind == 'i' && token->length == length && memcmp(token->start, word, length) == 0;
+}
+
+static void verilog_error(VerilogReader* reader, const char* message) {
+    if (!reader->error) {
+        fprintf(stderr, "%s:%d: %s near '%.*s'\n", reader->path, reader->line, message,
+                reader->token.length > 40 ? 40 : reader->token.length, reader->token.start);
+    }
+    reader->error = 1;
+}
+
+// Skip a balanced (...), [...] or {...} group starting at the current token
+static void verilog_skip_group(VerilogReader* reader) {
+    int depth = 0;
+    do {
+        int kind = reader->token.kind;
+        if (kind == '(' || kind == '[' || kind == '{') depth++;
+        if (kind == ')' || kind == ']' || kind == '}') depth--;
+        if (kind == 0) {
+            verilog_error(reader, "unbalanced brackets");
+            return;
+        }
+        verilog_next(reader);
+    } while (depth > 0);
+}
+
+static void verilog_skip_to_semicolon(VerilogReader* reader) {
+    while (reader->token.kind != ';' && reader->token.kind != 0) {
+        if (token_is(&reader->token, "endmodule")) return;
+        int kind = reader->token.kind;
+        if (kind == '(' || kind == '[' || kind == '{') verilog_skip_group(reader);
+        else verilog_next(reader);
+    }
+    if (reader->token.kind == ';') verilog_next(reader);
+}
+
+// Skip one behavioural statement: begin/end blocks, if/else, case,
+// loops and event or delay controls, nested to any depth
+static void verilog_skip_statement(VerilogReader* reader) {
+    VerilogToken* token = &reader->token;
+    if (reader->error || token->kind == 0) return;
+
+    if (token->kind == '@' || token->kind == '#') {
+        verilog_next(reader);
+        if (token->kind == '(') verilog_skip_group(reader);
+        else verilog_next(reader);
+        verilog_skip_statement(reader);
+    } else if (token_is(token, "begin") || token_is(token, "fork")) {
+        verilog_next(reader);
+        if (token->kind == ':') {
+            verilog_next(reader);
+            verilog_next(reader);
+        }
+        while (!reader->error && token->kind != 0 && !token_is(token, "end") && !token_is(token, "join")) {
+            verilog_skip_statement(reader);
+        }
+        verilog_next(reader);
+        if (token->kind == ':') {
+            verilog_next(reader);
+            verilog_next(reader);
+        }
+    } else if (token_is(token, "if") || token_is(token, "for") || token_is(token, "while") ||
+               token_is(token, "repeat")) {
+        int is_if = token_is(token, "if");
+        verilog_next(reader);
+        if (token->kind == '(') verilog_skip_group(reader);
+        verilog_skip_statement(reader);
+        if (is_if && token_is(token, "else")) {
+            verilog_next(reader);
+            verilog_skip_statement(reader);
+        }
+    } else if (token_is(token, "forever")) {
+        verilog_next(reader);
+        verilog_skip_statement(reader);
+    } else if (token_is(token, "case") || token_is(token, "casez") || token_is(token, "casex")) {
+        int depth = 0;
+        do {
+            if (token_is(token, "case") || token_is(token, "casez") || token_is(token, "casex")) depth++;
+            if (token_is(token, "endcase")) depth--;
+            verilog_next(reader);
+        } while (depth > 0 && token->kind != 0);
+    } else if (token->kind == ';') {
+        verilog_next(reader);
+    } else {
+        verilog_skip_to_semicolon(reader);
+    }
+}
+
+// Skip everything up to and including a closing keyword
+static void verilog_skip_until(VerilogReader* reader, const char* keyword) {
+    while (reader->token.kind != 0 && !token_is(&reader->token, keyword)) {
+        verilog_next(reader);
+    }
+    verilog_next(reader);
+}
+
+// Look up or create the net for a name
+static int reader_net(VerilogReader* reader, const char* name, int length) {
+    int created;
+    int* value = name_table_intern(&reader->net_names, name, length, &created);
+    if (!created) return *value;
+
+    if (reader->net_count == reader->net_capacity) {
+        reader->net_capacity = reader->net_capacity ? reader->net_capacity * 2 : 1024;
+        reader->nets = grow_array(reader->nets, reader->net_capacity, sizeof(NetState));
+    }
+    int net = reader->net_count++;
+    reader->nets[net].driver = -1;
+    reader->nets[net].pending = -1;
+    reader->nets[net].is_bus = 0;
+    *value = net;
+    return net;
+}
+
+// Net for bit `bit` of a vector, named like "data[3]"
+static int reader_bus_bit(VerilogReader* reader, const char* name, int length, int bit) {
+    char buffer[32];
+    int suffix = snprintf(buffer, sizeof(buffer), "[%d]", bit);
+    char* bit_name = arena_alloc(&reader->names, length + suffix + 1);
+    memcpy(bit_name, name, length);
+    memcpy(bit_name + length, buffer, suffix + 1);
+    return reader_net(reader, bit_name, length + suffix);
+}
+
+static void reader_add_terminal(VerilogReader* reader, int net) {
+    if (reader->terminal_count == reader->terminal_capacity) {
+        reader->terminal_capacity = reader->terminal_capacity ? reader->terminal_capacity * 2 : 64;
+        reader->terminals = grow_array(reader->terminals, reader->terminal_capacity, sizeof(int));
+    }
+    reader->terminals[reader->terminal_count++] = net;
+}
+
+// Parse "[msb:lsb]" or "[bit]" with literal bounds. Returns the number of
+// bounds read (0 when they are not plain integers) and consumes the group.
+static int verilog_parse_range(VerilogReader* reader, int* msb, int* lsb) {
+    VerilogToken* token = &reader->token;
+    int bounds = 0;
+
+    verilog_next(reader);
+    if (token->kind == 'n') {
+        *msb = *lsb = atoi(token->start);
+        bounds = 1;
+        verilog_next(reader);
+        if (token->kind == ':') {
+            verilog_next(reader);
+            if (token->kind == 'n') {
+                *lsb = atoi(token->start);
+                bounds = 2;
+                verilog_next(reader);
+            } else {
+                bounds = 0;
+            }
+        }
+    }
+    if (token->kind != ']') {
+        // Parameterised or expression bounds: skip the rest of the group
+        bounds = 0;
+        int depth = 1;
+        while (depth > 0 && token->kind != 0) {
+            if (token->kind == '[') depth++;
+            if (token->kind == ']') depth--;
+            if (depth > 0) verilog_next(reader);
+        }
+    }
+    verilog_next(reader);
+    return bounds;
+}
+
+// Read one net reference (name, bit select, part select, whole vector or
+// concatenation) and append the nets it names to the terminal list
+static void verilog_read_reference(VerilogReader* reader) {
+    VerilogToken* token = &reader->token;
+
+    if (token->kind == '{') {
+        verilog_next(reader);
+        while (!reader->error && token->kind != '}' && token->kind != 0) {
+            if (token->kind == ',') {
+                verilog_next(reader);
+                continue;
+            }
+            verilog_read_reference(reader);
+        }
+        verilog_next(reader);
+        return;
+    }
+    if (token->kind != 'i') {
+        // Constants and operators name no nets
+        if (token->kind == '(' || token->kind == '[') verilog_skip_group(reader);
+        else verilog_next(reader);
+        return;
+    }
+
+    const char* name = token->start;
+    int length = token->length;
+    if (name[0] == '\\') {
+        name++;
+        length--;
+    }
+    verilog_next(reader);
+
+    // Hierarchical and interface member names such as bus.req
+    while (token->kind == '.' && token->start == name + length) {
+        verilog_next(reader);
+        if (token->kind != 'i') break;
+        length = token->start + token->length - name;
+        verilog_next(reader);
+    }
+
+    if (token->kind == '[') {
+        int msb, lsb;
+        int bounds = verilog_parse_range(reader, &msb, &lsb);
+        if (bounds == 0) {
+            reader_add_terminal(reader, reader_net(reader, name, length));
+        } else {
+            int step = msb >= lsb ? -1 : 1;
+            for (int bit = msb;; bit += step) {
+                reader_add_terminal(reader, reader_bus_bit(reader, name, length, bit));
+                if (bit == lsb) break;
+            }
+        }
+        return;
+    }
+
+    int net = reader_net(reader, name, length);
+    if (reader->nets[net].is_bus) {
+        int msb = reader->nets[net].bus_msb;
+        int lsb = reader->nets[net].bus_lsb;
+        int step = msb >= lsb ? -1 : 1;
+        for (int bit = msb;; bit += step) {
+            reader_add_terminal(reader, reader_bus_bit(reader, name, length, bit));
+            if (bit == lsb) break;
+        }
+    } else {
+        reader_add_terminal(reader, net);
+    }
+}
+
+// Connect a node as the driver of a net, releasing any sinks that were
+// waiting for it
+static void reader_drive(VerilogReader* reader, int net, NodeId node) {
+    NetState* state = &reader->nets[net];
+    if (state->driver >= 0) {
+        reader->multiply_driven_nets++;
+        return;
+    }
+    state->driver = node;
+    for (int p = state->pending; p >= 0; p = reader->pending[p].next) {
+        add_connection(reader->circuit, node, reader->pending[p].node);
+    }
+    state->pending = -1;
+}
+
+// Connect a node as a sink of a net, or queue it until the driver is seen
+static void reader_sink(VerilogReader* reader, int net, NodeId node) {
+    NetState* state = &reader->nets[net];
+    if (state->driver >= 0) {
+        add_connection(reader->circuit, state->driver, node);
+        return;
+    }
+    if (reader->pending_count == reader->pending_capacity) {
+        reader->pending_capacity = reader->pending_capacity ? reader->pending_capacity * 2 : 1024;
+        reader->pending = grow_array(reader->pending, reader->pending_capacity, sizeof(PendingSink));
+    }
+    reader->pending[reader->pending_count].node = node;
+    reader->pending[reader->pending_count].next = state->pending;
+    state->pending = reader->pending_count++;
+}
+
+// Node name from a token, without the escape character
+static NodeId reader_create_node(VerilogReader* reader, const char* name, int length, GateType type) {
+    if (length > 0 && name[0] == '\\') {
+        name++;
+        length--;
+    }
+    return create_node_named(reader->circuit, name, length, type);
+}
+
+// Create the node of a named instance. Instance names are interned per
+// module, so a second instance of the same name is reported; it still
+// gets its own node.
+static NodeId reader_create_instance(VerilogReader* reader, const char* name, int length, GateType type) {
+    NodeId node = reader_create_node(reader, name, length, type);
+    int escaped = length > 0 && name[0] == '\\';
+    int created;
+    int* value = name_table_intern(&reader->instance_names, name + escaped, length - escaped, &created);
+    if (created) {
+        *value = node;
+    } else if (reader->duplicate_instances++ < 10) {
+        fprintf(stderr, "%s:%d: duplicate instance name %.*s\n", reader->path, reader->line,
+                length - escaped, name + escaped);
+    }
+    return node;
+}
+
+static NodeId reader_create_unnamed(VerilogReader* reader, const char* prefix, GateType type) {
+    char buffer[64];
+    int length = snprintf(buffer, sizeof(buffer), "%s_%d", prefix, reader->unnamed_instances++);
+    return reader_create_node(reader, buffer, length, type);
+}
+
+// Port declaration: input/output/inout [type] [range] names
+static void verilog_read_port_names(VerilogReader* reader, GateType direction, int in_header) {
+    VerilogToken* token = &reader->token;
+    int msb = 0, lsb = 0, bounds = 0;
+
+    for (;;) {
+        while (token_is(token, "wire") || token_is(token, "reg") || token_is(token, "logic") ||
+               token_is(token, "signed") || token_is(token, "unsigned") || token_is(token, "tri")) {
+            verilog_next(reader);
+        }
+        if (token->kind == '[') {
+            bounds = verilog_parse_range(reader, &msb, &lsb);
+            if (bounds == 1) bounds = 0;
+            continue;
+        }
+        if (token->kind != 'i') break;
+        if (in_header && (token_is(token, "input") || token_is(token, "output") || token_is(token, "inout"))) break;
+
+        const char* name = token->start;
+        int length = token->length;
+        if (name[0] == '\\') {
+            name++;
+            length--;
+        }
+        int net = reader_net(reader, name, length);
+        verilog_next(reader);
+
+        if (bounds == 2) {
+            reader->nets[net].is_bus = 1;
+            reader->nets[net].bus_msb = msb;
+            reader->nets[net].bus_lsb = lsb;
+        }
+
+        // One port node per bit; inouts are treated as inputs
+        int step = msb >= lsb ? -1 : 1;
+        for (int bit = msb;; bit += step) {
+            int bit_net = bounds == 2 ? reader_bus_bit(reader, name, length, bit) : net;
+            NodeId node;
+            if (bounds == 2) {
+                char buffer[300];
+                int bit_length = snprintf(buffer, sizeof(buffer), "%.*s[%d]", length, name, bit);
+                node = reader_create_node(reader, buffer, bit_length, direction);
+            } else {
+                node = reader_create_node(reader, name, length, direction);
+            }
+            if (direction == INPUT) reader_drive(reader, bit_net, node);
+            else reader_sink(reader, bit_net, node);
+            if (bounds != 2 || bit == lsb) break;
+        }
+
+        // Skip default values in ANSI headers
+        if (token->kind == '=') {
+            while (token->kind != ',' && token->kind != ';' && token->kind != ')' && token->kind != 0) {
+                if (token->kind == '(' || token->kind == '[' || token->kind == '{') verilog_skip_group(reader);
+                else verilog_next(reader);
+            }
+        }
+        if (token->kind != ',') break;
+        verilog_next(reader);
+    }
+}
+
+// Gate type for a continuous assignment from its top-level operator
+static GateType assign_gate_type(const char* start, const char* end, int* inverted) {
+    GateType type = GATE_AND;
+    int binary = 0;
+    *inverted = 0;
+    for (const char* c = start; c < end; c++) {
+        if (*c == '^') { type = GATE_XOR; binary = 1; break; }
+        if (*c == '|' && !binary) { type = GATE_OR; binary = 1; }
+        if (*c == '&' && !binary) { type = GATE_AND; binary = 1; }
+        if ((*c == '+' || *c == '-' || *c == '*' || *c == '<' || *c == '>' || *c == '=') && !binary) {
+            type = GATE_XOR;
+            binary = 1;
+        }
+        if (*c == '?' && !binary) { type = GATE_OR; binary = 1; }
+    }
+    while (start < end && (*start == ' ' || *start == '\t')) start++;
+    if (start < end && (*start == '~' || *start == '!')) *inverted = 1;
+    if (*inverted) {
+        if (!binary) return GATE_NOT;
+        if (type == GATE_AND) return GATE_NAND;
+        if (type == GATE_OR) return GATE_NOR;
+    }
+    return type;
+}
+
+// assign lhs = expression; becomes one node driving every bit of lhs and
+// fed by every net the expression reads
+static void verilog_read_assign(VerilogReader* reader) {
+    VerilogToken* token = &reader->token;
+
+    for (;;) {
+        reader->terminal_count = 0;
+        verilog_read_reference(reader);
+        int output_count = reader->terminal_count;
+        if (token->kind == ',') {
+            // Plain declaration in a list that also has initialisers
+            verilog_next(reader);
+            continue;
+        }
+        if (token->kind != '=') {
+            verilog_error(reader, "expected '=' in assignment");
+            return;
+        }
+        verilog_next(reader);
+
+        const char* expression_start = token->start;
+        while (token->kind != ';' && token->kind != ',' && token->kind != 0) {
+            if (token->kind == '(' || token->kind == '{' || token->kind == '[') {
+                // References inside groups still feed the node
+                int depth = 0;
+                do {
+                    if (token->kind == '(' || token->kind == '{' || token->kind == '[') depth++;
+                    if (token->kind == ')' || token->kind == '}' || token->kind == ']') depth--;
+                    if (token->kind == 'i') verilog_read_reference(reader);
+                    else verilog_next(reader);
+                } while (depth > 0 && token->kind != 0);
+            } else if (token->kind == 'i') {
+                verilog_read_reference(reader);
+            } else {
+                verilog_next(reader);
+            }
+        }
+        const char* expression_end = token->start;
+
+        int inverted;
+        GateType type = assign_gate_type(expression_start, expression_end, &inverted);
+        NodeId node = reader_create_unnamed(reader, "assign", type);
+        for (int i = 0; i < output_count; i++) reader_drive(reader, reader->terminals[i], node);
+        for (int i = output_count; i < reader->terminal_count; i++) reader_sink(reader, reader->terminals[i], node);
+        reader->assign_count++;
+
+        if (token->kind != ',') break;
+        verilog_next(reader);
+    }
+    if (token->kind == ';') verilog_next(reader);
+}
+
+static GateType primitive_gate_type(const VerilogToken* token) {
+    if (token_is(token, "and")) return GATE_AND;
+    if (token_is(token, "or")) return GATE_OR;
+    if (token_is(token, "not")) return GATE_NOT;
+    if (token_is(token, "nand")) return GATE_NAND;
+    if (token_is(token, "nor")) return GATE_NOR;
+    if (token_is(token, "xor") || token_is(token, "xnor")) return GATE_XOR;
+    if (token_is(token, "buf")) return GATE_AND;   // Single-input AND
+    return INPUT;
+}
+
+// Gate type from a cell name prefix such as NAND2_X1 or INVX2
+static GateType cell_name_gate_type(const char* name, int length) {
+    char upper[16];
+    int n = length < 15 ? length : 15;
+    for (int i = 0; i < n; i++) upper[i] = (name[i] >= 'a' && name[i] <= 'z') ? name[i] - 32 : name[i];
+    upper[n] = '\0';
+    if (strstr(upper, "DFF") || strstr(upper, "FLOP") || strncmp(upper, "FD", 2) == 0) return GATE_DFF;
+    if (strncmp(upper, "NAND", 4) == 0) return GATE_NAND;
+    if (strncmp(upper, "NOR", 3) == 0) return GATE_NOR;
+    if (strncmp(upper, "XNOR", 4) == 0 || strncmp(upper, "XOR", 3) == 0) return GATE_XOR;
+    if (strncmp(upper, "AND", 3) == 0) return GATE_AND;
+    if (strncmp(upper, "OR", 2) == 0) return GATE_OR;
+    if (strncmp(upper, "INV", 3) == 0 || strncmp(upper, "NOT", 3) == 0) return GATE_NOT;
+    return GATE_AND;
+}
+
+// Whether a cell pin drives its net: the library's output pin when the
+// cell is known, otherwise the usual output pin names
+static int is_output_pin(const LibertyCell* cell, const char* pin, int length) {
+    if (cell && cell->output_pin) {
+        return (int)strlen(cell->output_pin) == length && memcmp(cell->output_pin, pin, length) == 0;
+    }
+    static const char* outputs[] = {"Y", "Z", "ZN", "Q", "QN", "O", "OUT", "X", "CO", "S", NULL};
+    for (int i = 0; outputs[i]; i++) {
+        if ((int)strlen(outputs[i]) == length && memcmp(outputs[i], pin, length) == 0) return 1;
+    }
+    return 0;
+}
+
+// Whether a flip-flop pin is its clock. Clocks are ideal, so the clock
+// net is not part of the data graph.
+static int is_clock_pin(const char* pin, int length) {
+    static const char* clocks[] = {"CK", "CLK", "CP", "C", "CLOCK", "G", NULL};
+    for (int i = 0; clocks[i]; i++) {
+        if ((int)strlen(clocks[i]) == length && memcmp(clocks[i], pin, length) == 0) return 1;
+    }
+    return 0;
+}
+
+// Primitive gates:  and [#delay] [name] (out, in, ...), ...;
+// Cell instances:   CELL [#(params)] name (.A(n1), .Y(n2)) or positional
+static void verilog_read_instances(VerilogReader* reader, int primitive) {
+    VerilogToken* token = &reader->token;
+    const CellLibrary* library = reader->circuit->library;
+    const LibertyCell* cell = NULL;
+    GateType type;
+
+    if (primitive) {
+        type = primitive_gate_type(token);
+    } else {
+        // Resolve the cell kind once and cache it by name
+        int cached = name_table_find(&reader->cell_kinds, token->start, token->length);
+        if (cached < 0) {
+            cached = 0;
+            if (library) {
+                for (int c = 0; c < library->cell_count; c++) {
+                    if ((int)strlen(library->cells[c].name) == token->length &&
+                        memcmp(library->cells[c].name, token->start, token->length) == 0) {
+                        cached = (c + 1) * 16 + library->cells[c].type;
+                    }
+                }
+            }
+            if (!cached) cached = cell_name_gate_type(token->start, token->length);
+            name_table_insert(&reader->cell_kinds, token->start, token->length, cached);
+        }
+        type = cached & 15;
+        if (cached >= 16) cell = &library->cells[cached / 16 - 1];
+    }
+    int buffer_like = token_is(token, "buf") || token_is(token, "not");
+    verilog_next(reader);
+
+    // Delay or parameter overrides
+    if (token->kind == '#') {
+        verilog_next(reader);
+        if (token->kind == '(') verilog_skip_group(reader);
+        else verilog_next(reader);
+    }
+
+    for (;;) {
+        NodeId node;
+        if (token->kind == 'i') {
+            node = reader_create_instance(reader, token->start, token->length, type);
+            verilog_next(reader);
+            if (token->kind == '[') verilog_skip_group(reader);
+        } else {
+            node = reader_create_unnamed(reader, gate_type_name(type), type);
+        }
+        if (token->kind == ';' || token->kind == ',' || token->kind == '=') {
+            // A declaration with a user-defined type, not an instance
+            verilog_skip_to_semicolon(reader);
+            return;
+        }
+        if (token->kind != '(') {
+            verilog_error(reader, "expected instance connections");
+            return;
+        }
+        verilog_next(reader);
+
+        // Positional terminals are collected first: a gate drives its first
+        // terminal, while buf and not drive every terminal but the last
+        int first_end = -1;
+        int last_start = 0;
+        reader->terminal_count = 0;
+        while (!reader->error && token->kind != ')' && token->kind != 0) {
+            if (token->kind == ',') {
+                verilog_next(reader);
+                continue;
+            }
+            if (token->kind == '.') {
+                verilog_next(reader);
+                const char* pin = token->start;
+                int pin_length = token->length;
+                verilog_next(reader);
+                if (token->kind != '(') {
+                    verilog_error(reader, "expected '(' after pin name");
+                    return;
+                }
+                verilog_next(reader);
+                reader->terminal_count = 0;
+                while (token->kind != ')' && token->kind != 0) verilog_read_reference(reader);
+                verilog_next(reader);
+                int drives = is_output_pin(cell, pin, pin_length);
+                if (type == GATE_DFF && !drives && is_clock_pin(pin, pin_length)) reader->terminal_count = 0;
+                for (int i = 0; i < reader->terminal_count; i++) {
+                    if (drives) reader_drive(reader, reader->terminals[i], node);
+                    else reader_sink(reader, reader->terminals[i], node);
+                }
+                reader->terminal_count = 0;
+            } else {
+                last_start = reader->terminal_count;
+                while (token->kind != ',' && token->kind != ')' && token->kind != 0) verilog_read_reference(reader);
+                if (first_end < 0) first_end = reader->terminal_count;
+            }
+        }
+        verilog_next(reader);
+
+        int output_end = buffer_like ? last_start : first_end;
+        for (int i = 0; i < reader->terminal_count; i++) {
+            if (i < output_end) reader_drive(reader, reader->terminals[i], node);
+            else reader_sink(reader, reader->terminals[i], node);
+        }
+        reader->gate_count++;
+
+        if (token->kind != ',') break;
+        verilog_next(reader);
+    }
+    if (token->kind == ';') verilog_next(reader);
+}
+
+// Close the current module: report undriven nets and reset the net and
+// instance scope
+static void verilog_end_module(VerilogReader* reader, int module_skipped) {
+    // Nets assigned inside skipped always blocks have no structural
+    // driver, so only name them for purely structural modules
+    const NameTable* names = &reader->net_names;
+    for (int i = 0; i < names->capacity; i++) {
+        const NameSlot* slot = &names->slots[i];
+        if (!slot->key) continue;
+        const NetState* net = &reader->nets[slot->value];
+        if (net->driver >= 0 || net->pending < 0) continue;
+        if (reader->undriven_nets++ < 10 && reader->skipped_blocks == module_skipped) {
+            fprintf(stderr, "%s: net %.*s has no driver\n", reader->path, slot->length, slot->key);
+        }
+    }
+    name_table_clear(&reader->net_names);
+    name_table_clear(&reader->instance_names);
+    reader->net_count = 0;
+    reader->pending_count = 0;
+}
+
+static void verilog_read_module(VerilogReader* reader) {
+    VerilogToken* token = &reader->token;
+    verilog_next(reader);   // module name
+    verilog_next(reader);
+    reader->module_count++;
+    int module_skipped = reader->skipped_blocks;
+
+    if (token->kind == '#') {
+        verilog_next(reader);
+        verilog_skip_group(reader);
+    }
+
+    // Port list: plain names, or ANSI declarations
+    if (token->kind == '(') {
+        verilog_next(reader);
+        while (!reader->error && token->kind != ')' && token->kind != 0) {
+            if (token_is(token, "input") || token_is(token, "inout")) {
+                verilog_next(reader);
+                verilog_read_port_names(reader, INPUT, 1);
+            } else if (token_is(token, "output")) {
+                verilog_next(reader);
+                verilog_read_port_names(reader, OUTPUT, 1);
+            } else if (token->kind == '(' || token->kind == '[' || token->kind == '{') {
+                verilog_skip_group(reader);
+            } else {
+                verilog_next(reader);
+            }
+        }
+        verilog_next(reader);
+    }
+    if (token->kind == ';') verilog_next(reader);
+
+    while (!reader->error && token->kind != 0) {
+        if (token_is(token, "endmodule")) {
+            verilog_next(reader);
+            break;
+        } else if (token_is(token, "input") || token_is(token, "inout")) {
+            verilog_next(reader);
+            verilog_read_port_names(reader, INPUT, 0);
+            verilog_skip_to_semicolon(reader);
+        } else if (token_is(token, "output")) {
+            verilog_next(reader);
+            verilog_read_port_names(reader, OUTPUT, 0);
+            verilog_skip_to_semicolon(reader);
+        } else if (token_is(token, "assign")) {
+            verilog_next(reader);
+            verilog_read_assign(reader);
+        } else if (token_is(token, "wire") || token_is(token, "reg") || token_is(token, "logic") ||
+                   token_is(token, "tri") || token_is(token, "wand") || token_is(token, "wor")) {
+            // Declarations; one with an initialiser is also an assignment
+            verilog_next(reader);
+            while (token_is(token, "signed") || token_is(token, "unsigned")) verilog_next(reader);
+            int msb = 0, lsb = 0, bounds = 0;
+            if (token->kind == '[') bounds = verilog_parse_range(reader, &msb, &lsb);
+            size_t start = reader->position;
+            int line = reader->line;
+            VerilogToken first = *token;
+            while (bounds == 2 && token->kind == 'i') {
+                int escaped = token->start[0] == '\\';
+                int net = reader_net(reader, token->start + escaped, token->length - escaped);
+                reader->nets[net].is_bus = 1;
+                reader->nets[net].bus_msb = msb;
+                reader->nets[net].bus_lsb = lsb;
+                verilog_next(reader);
+                while (token->kind != ',' && token->kind != ';' && token->kind != 0) {
+                    if (token->kind == '(' || token->kind == '[' || token->kind == '{') verilog_skip_group(reader);
+                    else verilog_next(reader);
+                }
+                if (token->kind != ',') break;
+                verilog_next(reader);
+            }
+            reader->position = start;
+            reader->line = line;
+            reader->token = first;
+            while (token->kind != ';' && token->kind != '=' && token->kind != 0) verilog_next(reader);
+            if (token->kind == '=') {
+                reader->position = start;
+                reader->line = line;
+                reader->token = first;
+                verilog_read_assign(reader);
+            } else {
+                verilog_skip_to_semicolon(reader);
+            }
+        } else if (token_is(token, "always") || token_is(token, "always_ff") ||
+                   token_is(token, "always_comb") || token_is(token, "always_latch") ||
+                   token_is(token, "initial")) {
+            verilog_next(reader);
+            verilog_skip_statement(reader);
+            reader->skipped_blocks++;
+        } else if (token_is(token, "function")) {
+            verilog_skip_until(reader, "endfunction");
+            reader->skipped_blocks++;
+        } else if (token_is(token, "task")) {
+            verilog_skip_until(reader, "endtask");
+            reader->skipped_blocks++;
+        } else if (token_is(token, "generate")) {
+            verilog_skip_until(reader, "endgenerate");
+            reader->skipped_blocks++;
+        } else if (token_is(token, "specify")) {
+            verilog_skip_until(reader, "endspecify");
+        } else if (primitive_gate_type(token) != INPUT) {
+            verilog_read_instances(reader, 1);
+        } else if (token_is(token, "parameter") || token_is(token, "localparam") ||
+                   token_is(token, "integer") || token_is(token, "real") || token_is(token, "genvar") ||
+                   token_is(token, "defparam") || token_is(token, "supply0") || token_is(token, "supply1") ||
+                   token_is(token, "time") || token_is(token, "event") || token_is(token, "typedef") ||
+                   token_is(token, "import") || token_is(token, "bit") || token_is(token, "int")) {
+            verilog_skip_to_semicolon(reader);
+        } else if (token->kind == 'i') {
+            verilog_read_instances(reader, 0);
+        } else {
+            verilog_skip_to_semicolon(reader);
+        }
+    }
+
+    verilog_end_module(reader, module_skipped);
+}
+
+// Read a structural Verilog netlist into the circuit in one streaming
+// pass over the memory-mapped file. Each module's ports become INPUT and
+// OUTPUT nodes, every gate primitive, cell instance and continuous
+// assignment becomes a gate node, and nets are resolved through a hash
+// table with sinks queued until their driver appears. Behavioural blocks
+// are skipped and counted. Returns 0 on success, -1 on error.
+int read_verilog_netlist(Circuit* circuit, const char* path) {
+    TRACE_SCOPE("read_verilog");
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open netlist %s\n", path);
+        return -1;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        fprintf(stderr, "Cannot stat netlist %s\n", path);
+        close(fd);
+        return -1;
+    }
+
+    const char* text = "";
+    if (info.st_size > 0) {
+        text = mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (text == MAP_FAILED) {
+            fprintf(stderr, "Cannot map netlist %s\n", path);
+            close(fd);
+            return -1;
+        }
+        madvise((void*)text, info.st_size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    VerilogReader reader;
+    memset(&reader, 0, sizeof(reader));
+    reader.circuit = circuit;
+    reader.path = path;
+    reader.text = text;
+    reader.length = info.st_size;
+    reader.line = 1;
+
+    int first_node = circuit->node_count;
+    int first_edge = circuit->edge_count;
+
+    verilog_next(&reader);
+    while (!reader.error && reader.token.kind != 0) {
+        if (token_is(&reader.token, "module") || token_is(&reader.token, "macromodule")) {
+            verilog_read_module(&reader);
+        } else {
+            verilog_next(&reader);
+        }
+    }
+
+    if (!reader.error) {
+        printf("Read %s: %d module(s), %d node(s), %d connection(s), %d gate instance(s), %d assignment(s)\n",
+               path, reader.module_count, circuit->node_count - first_node,
+               circuit->edge_count - first_edge, reader.gate_count, reader.assign_count);
+        if (reader.skipped_blocks > 0) {
+            printf("  Skipped %d behavioural block(s)\n", reader.skipped_blocks);
+        }
+        if (reader.undriven_nets > 0) {
+            printf("  %d net(s) with sinks but no structural driver\n", reader.undriven_nets);
+        }
+        if (reader.multiply_driven_nets > 0) {
+            printf("  %d extra driver(s) ignored on multiply driven nets\n", reader.multiply_driven_nets);
+        }
+        if (reader.duplicate_instances > 0) {
+            printf("  %d instance(s) reuse a name in their module\n", reader.duplicate_instances);
+        }
+    }
+
+    name_table_free(&reader.net_names);
+    name_table_free(&reader.cell_kinds);
+    name_table_free(&reader.instance_names);
+    free(reader.nets);
+    free(reader.pending);
+    free(reader.terminals);
+    arena_release(&reader.names);
+    if (info.st_size > 0) munmap((void*)text, info.st_size);
+    return reader.error ? -1 : 0;
+}
+
+// Timing constraints: a subset of SDC. create_clock sets the clock period
+// every register-to-register, input-to-register, register-to-output and
+// input-to-output path is checked against; set_input_delay and
+// set_output_delay give ports their external delay within that period.
+// Commands are split Tcl-style into words; [command] and {list} words are
+// kept whole.
+
+typedef struct {
+    char* words[MAX_SDC_WORDS];
+    int count;
+} SdcCommand;
+
+// Match a name against a pattern with * and ? wildcards
+static int glob_match(const char* pattern, const char* name) {
+    if (*pattern == '\0') return *name == '\0';
+    if (*pattern == '*') {
+        for (const char* rest = name; ; rest++) {
+            if (glob_match(pattern + 1, rest)) return 1;
+            if (*rest == '\0') return 0;
+        }
+    }
+    if (*name == '\0') return 0;
+    return (*pattern == '?' || *pattern == *name) && glob_match(pattern + 1, name + 1);
+}
+
+// Read one command from text starting at *position. Returns 0 at the end
+// of the text. Words are copied into the arena.
+static int sdc_next_command(const char* text, size_t length, size_t* position, int* line,
+                            Arena* arena, SdcCommand* command) {
+    size_t i = *position;
+    command->count = 0;
+
+    while (i < length) {
+        char c = text[i];
+        if (c == '\\' && i + 1 < length && text[i + 1] == '\n') {
+            i += 2;
+            (*line)++;
+            continue;
+        }
+        if (c == ' ' || c == '\t' || c == '\r') {
+            i++;
+            continue;
+        }
+        if (c == '\n' || c == ';') {
+            // A command's newline is consumed by the next call, so *line
+            // still names the command's last line for its messages
+            if (c == '\n' && command->count > 0) break;
+            if (c == '\n') (*line)++;
+            i++;
+            if (command->count > 0) break;
+            continue;
+        }
+        if (c == '#' && command->count == 0) {
+            while (i < length && text[i] != '\n') i++;
+            continue;
+        }
+
+        // One word: a bracketed command keeps its '[' as a marker, a
+        // braced list or quoted string loses its delimiters
+        size_t start = i;
+        if (c == '[' || c == '{') {
+            char open = c, close = c == '[' ? ']' : '}';
+            int depth = 0;
+            for (; i < length; i++) {
+                if (text[i] == open) depth++;
+                if (text[i] == close && --depth == 0) break;
+                if (text[i] == '\n') (*line)++;
+            }
+            if (open == '{') start++;
+            i = i < length ? i + 1 : i;
+        } else if (c == '"') {
+            start = ++i;
+            while (i < length && text[i] != '"') i++;
+            i = i < length ? i + 1 : i;
+        } else {
+            while (i < length && !strchr(" \t\r\n;", text[i])) i++;
+        }
+        size_t end = i;
+        if (c == '[' || c == '{' || c == '"') end = end > start ? end - 1 : start;
+
+        if (command->count < MAX_SDC_WORDS) {
+            char* word = arena_alloc(arena, end - start + 1);
+            memcpy(word, text + start, end - start);
+            word[end - start] = '\0';
+            command->words[command->count++] = word;
+        }
+    }
+
+    *position = i;
+    return command->count > 0;
+}
+
+// Append the nodes selected by an SDC object word to list: [get_ports ...],
+// [get_cells ...], [get_pins ...], [get_nets ...], [get_clocks ...],
+// [all_inputs], [all_outputs], [all_registers] or a plain list of names.
+// A pin or net stands for the node driving it, so r1/Q selects r1, and a
+// clock selects every startpoint. Returns the number of nodes appended.
+static int sdc_select_nodes(const Circuit* circuit, char* objects, NodeList* list) {
+    int every = -1;          // Select every node of this type
+    int startpoints = 0;
+    int ports = 0;
+    int pins = 0;
+    char* patterns = objects;
+    if (objects[0] == '[') {
+        patterns = objects + 1;
+        while (*patterns == ' ') patterns++;
+        if (strncmp(patterns, "all_inputs", 10) == 0) {
+            every = INPUT;
+        } else if (strncmp(patterns, "all_outputs", 11) == 0) {
+            every = OUTPUT;
+        } else if (strncmp(patterns, "all_registers", 13) == 0) {
+            every = GATE_DFF;
+        } else if (strncmp(patterns, "get_clocks", 10) == 0) {
+            startpoints = 1;
+        } else if (strncmp(patterns, "get_ports", 9) == 0 || strncmp(patterns, "get_cells", 9) == 0) {
+            ports = patterns[4] == 'p';
+            patterns += 9;
+        } else if (strncmp(patterns, "get_pins", 8) == 0 || strncmp(patterns, "get_nets", 8) == 0) {
+            pins = 1;
+            patterns += 8;
+        }
+    }
+
+    int count = list->count;
+    if (every >= 0 || startpoints) {
+        for (NodeId node = 0; node < circuit->node_count; node++) {
+            int type = circuit->type[node];
+            if (startpoints ? type == INPUT || type == GATE_DFF : type == every) node_list_push(list, node);
+        }
+        return list->count - count;
+    }
+
+    char* save = NULL;
+    for (char* pattern = strtok_r(patterns, " \t{}]", &save); pattern; pattern = strtok_r(NULL, " \t{}]", &save)) {
+        if (pattern[0] == '-') continue;   // Options such as -quiet
+        char* slash = pins ? strrchr(pattern, '/') : NULL;
+        if (slash) *slash = '\0';
+        for (NodeId node = 0; node < circuit->node_count; node++) {
+            if (ports && circuit->type[node] != INPUT && circuit->type[node] != OUTPUT) continue;
+            if (glob_match(pattern, node_name(circuit, node))) node_list_push(list, node);
+        }
+    }
+    return list->count - count;
+}
+
+// Set the external delay of every port of the given type selected by an
+// SDC object word. Returns the number of ports matched.
+static int sdc_set_port_delay(Circuit* circuit, char* objects, GateType type, double value) {
+    NodeList selected = {0};
+    sdc_select_nodes(circuit, objects, &selected);
+    int matched = 0;
+    for (int i = 0; i < selected.count; i++) {
+        NodeId node = selected.items[i];
+        if (circuit->type[node] != type) continue;
+        circuit->port_delay[node] = value;
+        matched++;
+    }
+    free(selected.items);
+    return matched;
+}
+
+// Add a set_false_path, set_max_delay or set_multicycle_path command as a
+// timing exception. Exceptions apply to setup analysis; -hold exceptions,
+// transition-specific ones (-rise_to, -fall_from, ...) and ones with an
+// object list that matches nothing are skipped with a note. -from objects
+// that cannot start a path (anything but inputs and flip-flops) are left
+// out with a warning. Returns 0 on success, -1 on error.
+static int sdc_add_exception(Circuit* circuit, ExceptionType type, SdcCommand* command,
+                             const char* path, int line) {
+    const char* name = command->words[0];
+    TimingException exception = {0};
+    exception.type = type;
+    NodeList from = {0}, to = {0}, through = {0};
+    int* through_start = grow_array(NULL, 1, sizeof(int));
+    through_start[0] = 0;
+    const char* value = NULL;
+    const char* unsupported = NULL;
+    int from_given = 0, to_given = 0, empty = 0, setup = 0, hold = 0;
+    int not_startpoints = 0;
+    int result = 0;
+
+    for (int w = 1; w < command->count && result == 0; w++) {
+        const char* word = command->words[w];
+        int has_objects = w + 1 < command->count;
+        if (strcmp(word, "-from") == 0 && has_objects) {
+            from_given = 1;
+            if (sdc_select_nodes(circuit, command->words[++w], &from) == 0) empty = 1;
+        } else if (strcmp(word, "-to") == 0 && has_objects) {
+            to_given = 1;
+            if (sdc_select_nodes(circuit, command->words[++w], &to) == 0) empty = 1;
+        } else if (strcmp(word, "-through") == 0 && has_objects) {
+            if (sdc_select_nodes(circuit, command->words[++w], &through) == 0) empty = 1;
+            exception.through_count++;
+            through_start = grow_array(through_start, exception.through_count + 1, sizeof(int));
+            through_start[exception.through_count] = through.count;
+        } else if (strcmp(word, "-setup") == 0) {
+            setup = 1;
+        } else if (strcmp(word, "-hold") == 0) {
+            hold = 1;
+        } else if (strcmp(word, "-comment") == 0) {
+            w++;
+        } else if (strstr(word, "_from") || strstr(word, "_to") || strstr(word, "_through")) {
+            unsupported = word;   // Transition-specific exceptions
+            w++;
+        } else if (word[0] == '-' && !(word[1] >= '0' && word[1] <= '9') && word[1] != '.') {
+            continue;   // -start, -end, -rise, -fall and the like
+        } else if (!value && type != EXCEPTION_FALSE_PATH) {
+            value = word;
+        } else {
+            fprintf(stderr, "%s:%d: %s: unexpected argument %s\n", path, line, name, word);
+            result = -1;
+        }
+    }
+
+    if (result == 0 && type != EXCEPTION_FALSE_PATH) {
+        exception.value = value ? atof(value) : 0.0;
+        if (!value || (type == EXCEPTION_MULTICYCLE && exception.value < 1.0)) {
+            fprintf(stderr, "%s:%d: %s expects a %s\n", path, line, name,
+                    type == EXCEPTION_MULTICYCLE ? "cycle count of at least 1" : "delay");
+            result = -1;
+        }
+    }
+    if (result == 0 && from_given && !empty) {
+        int kept = 0;
+        for (int i = 0; i < from.count; i++) {
+            NodeId node = from.items[i];
+            if (circuit->type[node] == INPUT || circuit->type[node] == GATE_DFF) from.items[kept++] = node;
+        }
+        not_startpoints = from.count - kept;
+        from.count = kept;
+    }
+    if (result == 0 && (hold && !setup)) {
+        fprintf(stderr, "%s:%d: note: %s -hold skipped (hold checks take no exceptions)\n", path, line, name);
+    } else if (result == 0 && unsupported) {
+        fprintf(stderr, "%s:%d: warning: %s %s is not supported and is skipped\n", path, line, name, unsupported);
+    } else if (result == 0 && empty) {
+        fprintf(stderr, "%s:%d: warning: %s matched no objects and is skipped\n", path, line, name);
+    } else if (result == 0 && from_given && from.count == 0) {
+        fprintf(stderr, "%s:%d: warning: %s -from matched no startpoints and is skipped\n", path, line, name);
+    } else if (result == 0) {
+        if (not_startpoints > 0) {
+            fprintf(stderr, "%s:%d: warning: %s -from skips %d object(s) that are not startpoints\n",
+                    path, line, name, not_startpoints);
+        }
+        exception.from = from.items;
+        exception.from_count = from_given ? from.count : 0;
+        exception.to = to.items;
+        exception.to_count = to_given ? to.count : 0;
+        exception.through = through.items;
+        exception.through_start = through_start;
+        exception.first_bit = circuit->exception_bits;
+        circuit->exception_bits += exception.through_count + 1;
+        circuit->exceptions = grow_array(circuit->exceptions, circuit->exception_count + 1, sizeof(TimingException));
+        circuit->exceptions[circuit->exception_count++] = exception;
+        circuit->exception_nodes = -1;
+        return 0;
+    }
+    free(from.items);
+    free(to.items);
+    free(through.items);
+    free(through_start);
+    return result;
+}
+
+// Apply set_disable_timing: every timing arc into the selected cells is
+// left out of the timing graph, which is how the user chooses where a
+// combinational loop is cut. Arcs are per cell here, so -from and -to pin
+// options disable the whole cell with a note. Returns the number of arcs
+// disabled, or -1 on error.
+static int sdc_disable_timing(Circuit* circuit, SdcCommand* command, const char* path, int line) {
+    char* objects = NULL;
+    int pin_options = 0;
+    for (int w = 1; w < command->count; w++) {
+        const char* word = command->words[w];
+        if ((strcmp(word, "-from") == 0 || strcmp(word, "-to") == 0) && w + 1 < command->count) {
+            pin_options = 1;
+            w++;
+        } else if (word[0] != '-') {
+            objects = command->words[w];
+        }
+    }
+    if (!objects) {
+        fprintf(stderr, "%s:%d: set_disable_timing expects an object list\n", path, line);
+        return -1;
+    }
+    if (pin_options) {
+        fprintf(stderr, "%s:%d: note: set_disable_timing -from/-to disables every arc of the cell\n", path, line);
+    }
+
+    NodeList selected = {0};
+    if (sdc_select_nodes(circuit, objects, &selected) == 0) {
+        fprintf(stderr, "%s:%d: warning: set_disable_timing matched no cells\n", path, line);
+        free(selected.items);
+        return 0;
+    }
+    if (circuit->snapshot) detach_snapshot(circuit);
+    unsigned char* chosen = calloc(circuit->node_count + 1, 1);
+    for (int i = 0; i < selected.count; i++) chosen[selected.items[i]] = 1;
+    int disabled = 0;
+    for (EdgeChunk* chunk = circuit->edges_head; chunk; chunk = chunk->next) {
+        for (int e = 0; e < chunk->count; e++) {
+            if (chunk->disabled[e] || !chosen[chunk->destination[e]]) continue;
+            chunk->disabled[e] = 1;
+            disabled++;
+        }
+    }
+    if (disabled > 0) {
+        circuit->graph_built = 0;
+        circuit->levelized = 0;
+    }
+    free(chosen);
+    free(selected.items);
+    return disabled;
+}
+
+// Read timing constraints from an SDC file. Unsupported commands are
+// counted and skipped. Returns 0 on success, -1 on error.
+int read_constraints(Circuit* circuit, const char* path) {
+    TRACE_SCOPE("read_constraints");
+    size_t size;
+    char* text = read_whole_file(path, "constraints", &size);
+    if (!text) return -1;
+
+    Arena words = {0};
+    SdcCommand command;
+    size_t position = 0;
+    int line = 1;
+    int ignored = 0;
+    int disabled = 0;
+    int error = 0;
+
+    while (!error && sdc_next_command(text, size, &position, &line, &words, &command)) {
+        const char* name = command.words[0];
+        int is_clock = strcmp(name, "create_clock") == 0;
+        int is_input = strcmp(name, "set_input_delay") == 0;
+        int is_output = strcmp(name, "set_output_delay") == 0;
+
+        if (is_clock) {
+            double period = 0.0;
+            for (int w = 1; w + 1 < command.count; w++) {
+                if (strcmp(command.words[w], "-period") == 0) period = atof(command.words[w + 1]);
+            }
+            if (period <= 0.0) {
+                fprintf(stderr, "%s:%d: create_clock needs a positive -period\n", path, line);
+                error = 1;
+            }
+            circuit->clock_period = period;
+        } else if (strcmp(name, "set_false_path") == 0) {
+            error = sdc_add_exception(circuit, EXCEPTION_FALSE_PATH, &command, path, line) != 0;
+        } else if (strcmp(name, "set_max_delay") == 0) {
+            error = sdc_add_exception(circuit, EXCEPTION_MAX_DELAY, &command, path, line) != 0;
+        } else if (strcmp(name, "set_multicycle_path") == 0) {
+            error = sdc_add_exception(circuit, EXCEPTION_MULTICYCLE, &command, path, line) != 0;
+        } else if (strcmp(name, "set_disable_timing") == 0) {
+            int arcs = sdc_disable_timing(circuit, &command, path, line);
+            if (arcs < 0) error = 1;
+            else disabled += arcs;
+        } else if (is_input || is_output) {
+            // set_*_delay [-clock name] [-max|-min|...] value objects
+            const char* value = NULL;
+            char* objects = NULL;
+            for (int w = 1; w < command.count; w++) {
+                const char* word = command.words[w];
+                if (strcmp(word, "-clock") == 0 || strcmp(word, "-reference_pin") == 0) {
+                    w++;
+                } else if (word[0] == '-' && !(word[1] >= '0' && word[1] <= '9') && word[1] != '.') {
+                    continue;
+                } else if (!value) {
+                    value = word;
+                } else {
+                    objects = command.words[w];
+                }
+            }
+            if (!value || !objects) {
+                fprintf(stderr, "%s:%d: %s expects a delay and a port list\n", path, line, name);
+                error = 1;
+            } else if (sdc_set_port_delay(circuit, objects, is_input ? INPUT : OUTPUT, atof(value)) == 0) {
+                fprintf(stderr, "%s:%d: warning: %s matched no ports\n", path, line, name);
+            }
+        } else {
+            ignored++;
+        }
+        arena_reset(&words);
+    }
+
+    arena_release(&words);
+    free(text);
+    if (error) return -1;
+
+    printf("Read %s: clock period %.3f ns", path, circuit->clock_period);
+    if (circuit->exception_count > 0) printf(", %d timing exception(s)", circuit->exception_count);
+    if (disabled > 0) printf(", %d timing arc(s) disabled", disabled);
+    if (ignored > 0) printf(", %d unsupported command(s) ignored", ignored);
+    printf("\n");
+
+    // Constraints move every required time
+    circuit->timing_valid = 0;
+    return 0;
+}
+
+// Size in bytes of each snapshot section for the given header counts
+static void snapshot_section_sizes(const SnapshotHeader* header, uint64_t* sizes) {
+    uint64_t n = header->node_count;
+    uint64_t m = (uint64_t)header->edge_count - header->disabled_count;   // Arcs in the CSR
+    sizes[SNAPSHOT_TYPE] = n * sizeof(unsigned char);
+    sizes[SNAPSHOT_RISE_DELAY] = n * sizeof(double);
+    sizes[SNAPSHOT_FALL_DELAY] = n * sizeof(double);
+    sizes[SNAPSHOT_LEVEL] = n * sizeof(int);
+    sizes[SNAPSHOT_NAME_OFFSET] = n * sizeof(size_t);
+    sizes[SNAPSHOT_NAME_POOL] = header->name_pool_size;
+    sizes[SNAPSHOT_FANIN_START] = (n + 1) * sizeof(int);
+    sizes[SNAPSHOT_FANIN] = m * sizeof(NodeId);
+    sizes[SNAPSHOT_FANOUT_START] = (n + 1) * sizeof(int);
+    sizes[SNAPSHOT_FANOUT] = m * sizeof(NodeId);
+    sizes[SNAPSHOT_ENDPOINTS] = header->endpoint_count * sizeof(NodeId);
+    sizes[SNAPSHOT_LEVEL_ORDER] = n * sizeof(NodeId);
+    sizes[SNAPSHOT_LEVEL_START] = (header->level_count + 1) * sizeof(int);
+    sizes[SNAPSHOT_DISABLED_SOURCE] = header->disabled_count * sizeof(NodeId);
+    sizes[SNAPSHOT_DISABLED_DESTINATION] = header->disabled_count * sizeof(NodeId);
+}
+
+// Write the built and levelized timing graph with its delays and names
+// to a snapshot file that load_snapshot() can map without parsing.
+// Returns 0 on success, -1 on error.
+int write_snapshot(Circuit* circuit, const char* path) {
+    TRACE_SCOPE("write_snapshot");
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) return -1;
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.byte_order = 0x01020304;
+    header.word_size = sizeof(size_t);
+    header.node_count = circuit->node_count;
+    header.edge_count = circuit->edge_count;
+    header.endpoint_count = circuit->endpoint_count;
+    header.level_count = circuit->level_count;
+    header.disabled_count = circuit->disabled_count;
+    header.name_pool_size = circuit->name_pool_size;
+
+    const void* sections[SNAPSHOT_SECTION_COUNT] = {
+        circuit->type, circuit->delay[TRANSITION_RISE], circuit->delay[TRANSITION_FALL], circuit->level, circuit->name_offset, circuit->name_pool,
+        circuit->fanin_start, circuit->fanin, circuit->fanout_start, circuit->fanout,
+        circuit->endpoints, circuit->level_order, circuit->level_start,
+        circuit->disabled_source, circuit->disabled_destination
+    };
+    uint64_t sizes[SNAPSHOT_SECTION_COUNT];
+    snapshot_section_sizes(&header, sizes);
+
+    uint64_t offset = sizeof(SnapshotHeader);
+    for (int s = 0; s < SNAPSHOT_SECTION_COUNT; s++) {
+        offset = (offset + SNAPSHOT_ALIGN - 1) & ~(uint64_t)(SNAPSHOT_ALIGN - 1);
+        header.section_offset[s] = offset;
+        offset += sizes[s];
+    }
+    header.file_size = offset;
+
+    FILE* file = fopen(path, "wb");
+    if (!file) {
+        fprintf(stderr, "Cannot create snapshot %s\n", path);
+        return -1;
+    }
+    static const char padding[SNAPSHOT_ALIGN];
+    int ok = fwrite(&header, sizeof(header), 1, file) == 1;
+    uint64_t written = sizeof(header);
+    for (int s = 0; s < SNAPSHOT_SECTION_COUNT && ok; s++) {
+        ok = fwrite(padding, 1, header.section_offset[s] - written, file) == header.section_offset[s] - written &&
+             fwrite(sections[s], 1, sizes[s], file) == sizes[s];
+        written = header.section_offset[s] + sizes[s];
+    }
+    if (fclose(file) != 0) ok = 0;
+    if (!ok) {
+        fprintf(stderr, "Error writing snapshot %s\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+// Check that index arrays point only where they should
+static int snapshot_ids_in_range(const NodeId* ids, int count, int node_count) {
+    for (int i = 0; i < count; i++) {
+        if (ids[i] < 0 || ids[i] >= node_count) return 0;
+    }
+    return 1;
+}
+
+// Check that a CSR start array runs from 0 up to total without stepping back
+static int snapshot_starts_valid(const int* start, int count, int total) {
+    if (start[0] != 0 || start[count] != total) return 0;
+    for (int i = 0; i < count; i++) {
+        if (start[i] > start[i + 1]) return 0;
+    }
+    return 1;
+}
+
+// Check every value the timing code uses as an index, so a damaged or
+// hostile file is rejected instead of sending a traversal out of bounds.
+// Costs one pass over the index sections.
+static int snapshot_sections_valid(const char* base, const SnapshotHeader* header) {
+    const uint64_t* offset = header->section_offset;
+    int n = header->node_count;
+    int m = header->edge_count - header->disabled_count;
+    const unsigned char* type = (const unsigned char*)(base + offset[SNAPSHOT_TYPE]);
+    const int* level = (const int*)(base + offset[SNAPSHOT_LEVEL]);
+    const size_t* name_offset = (const size_t*)(base + offset[SNAPSHOT_NAME_OFFSET]);
+    const char* name_pool = base + offset[SNAPSHOT_NAME_POOL];
+
+    if (header->name_pool_size == 0 ? n > 0 : name_pool[header->name_pool_size - 1] != '\0') return 0;
+    for (int i = 0; i < n; i++) {
+        if (type[i] > GATE_DFF || level[i] < 0 || level[i] >= header->level_count ||
+            name_offset[i] >= header->name_pool_size) {
+            return 0;
+        }
+    }
+    return snapshot_starts_valid((const int*)(base + offset[SNAPSHOT_FANIN_START]), n, m) &&
+           snapshot_starts_valid((const int*)(base + offset[SNAPSHOT_FANOUT_START]), n, m) &&
+           snapshot_starts_valid((const int*)(base + offset[SNAPSHOT_LEVEL_START]), header->level_count, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_FANIN]), m, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_FANOUT]), m, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_ENDPOINTS]), header->endpoint_count, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_LEVEL_ORDER]), n, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_DISABLED_SOURCE]), header->disabled_count, n) &&
+           snapshot_ids_in_range((const NodeId*)(base + offset[SNAPSHOT_DISABLED_DESTINATION]), header->disabled_count, n);
+}
+
+// Map a snapshot written by write_snapshot() and return a circuit whose
+// graph, schedule, delays and names point straight into the mapping.
+// Only the timing results are allocated, so loading costs one mmap and
+// one validating pass over the index sections. Returns NULL on error.
+Circuit* load_snapshot(const char* path) {
+    TRACE_SCOPE("load_snapshot");
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "Cannot open snapshot %s\n", path);
+        return NULL;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || (size_t)info.st_size < sizeof(SnapshotHeader)) {
+        fprintf(stderr, "%s is not a timing graph snapshot\n", path);
+        close(fd);
+        return NULL;
+    }
+
+    // Private and writable: delays and levels can be changed in place
+    // without touching the file
+    char* base = mmap(NULL, info.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED) {
+        fprintf(stderr, "Cannot map snapshot %s\n", path);
+        return NULL;
+    }
+
+    const SnapshotHeader* header = (const SnapshotHeader*)base;
+    const char* problem = NULL;
+    uint64_t sizes[SNAPSHOT_SECTION_COUNT];
+    if (memcmp(header->magic, SNAPSHOT_MAGIC, sizeof(header->magic)) != 0) {
+        problem = "not a timing graph snapshot";
+    } else if (header->version != SNAPSHOT_VERSION) {
+        problem = "unsupported snapshot version";
+    } else if (header->byte_order != 0x01020304 || header->word_size != sizeof(size_t)) {
+        problem = "snapshot written on an incompatible host";
+    } else if (header->file_size != (uint64_t)info.st_size || header->node_count < 0 ||
+               header->edge_count < 0 || header->endpoint_count < 0 || header->level_count < 0 ||
+               header->disabled_count < 0 || header->disabled_count > header->edge_count) {
+        problem = "truncated or corrupt snapshot";
+    } else {
+        snapshot_section_sizes(header, sizes);
+        for (int s = 0; s < SNAPSHOT_SECTION_COUNT && !problem; s++) {
+            // Compared without adding, so a huge offset cannot wrap around
+            if (header->section_offset[s] % SNAPSHOT_ALIGN != 0 || header->section_offset[s] > header->file_size ||
+                sizes[s] > header->file_size - header->section_offset[s]) {
+                problem = "truncated or corrupt snapshot";
+            }
+        }
+        if (!problem && !snapshot_sections_valid(base, header)) problem = "truncated or corrupt snapshot";
+    }
+    if (problem) {
+        fprintf(stderr, "%s: %s\n", path, problem);
+        munmap(base, info.st_size);
+        return NULL;
+    }
+
+    Circuit* circuit = create_circuit();
+    int n = header->node_count;
+    const uint64_t* offset = header->section_offset;
+    circuit->snapshot = base;
+    circuit->snapshot_size = info.st_size;
+    circuit->node_count = n;
+    circuit->node_capacity = n;
+    circuit->edge_count = header->edge_count;
+    circuit->type = (unsigned char*)(base + offset[SNAPSHOT_TYPE]);
+    circuit->delay[TRANSITION_RISE] = (double*)(base + offset[SNAPSHOT_RISE_DELAY]);
+    circuit->delay[TRANSITION_FALL] = (double*)(base + offset[SNAPSHOT_FALL_DELAY]);
+    circuit->level = (int*)(base + offset[SNAPSHOT_LEVEL]);
+    circuit->name_offset = (size_t*)(base + offset[SNAPSHOT_NAME_OFFSET]);
+    circuit->name_pool = base + offset[SNAPSHOT_NAME_POOL];
+    circuit->name_pool_size = header->name_pool_size;
+    circuit->name_pool_capacity = header->name_pool_size;
+    circuit->fanin_start = (int*)(base + offset[SNAPSHOT_FANIN_START]);
+    circuit->fanin = (NodeId*)(base + offset[SNAPSHOT_FANIN]);
+    circuit->fanout_start = (int*)(base + offset[SNAPSHOT_FANOUT_START]);
+    circuit->fanout = (NodeId*)(base + offset[SNAPSHOT_FANOUT]);
+    circuit->endpoints = (NodeId*)(base + offset[SNAPSHOT_ENDPOINTS]);
+    circuit->endpoint_count = header->endpoint_count;
+    circuit->level_order = (NodeId*)(base + offset[SNAPSHOT_LEVEL_ORDER]);
+    circuit->level_start = (int*)(base + offset[SNAPSHOT_LEVEL_START]);
+    circuit->level_count = header->level_count;
+    circuit->disabled_source = (NodeId*)(base + offset[SNAPSHOT_DISABLED_SOURCE]);
+    circuit->disabled_destination = (NodeId*)(base + offset[SNAPSHOT_DISABLED_DESTINATION]);
+    circuit->disabled_count = header->disabled_count;
+    circuit->graph_built = 1;
+    circuit->levelized = 1;
+
+    // Timing results are recomputed on every run
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        circuit->arrival_time[t] = grow_array(NULL, n + 1, sizeof(double));
+        circuit->required_time[t] = grow_array(NULL, n + 1, sizeof(double));
+        circuit->early_arrival[t] = grow_array(NULL, n + 1, sizeof(double));
+    }
+    circuit->slack = grow_array(NULL, n + 1, sizeof(double));
+    circuit->port_delay = calloc(n + 1, sizeof(double));
+    circuit->delay_sigma = grow_array(NULL, n + 1, sizeof(double));
+    for (int i = 0; i < n; i++) {
+        circuit->delay_sigma[i] = circuit->type[i] == INPUT ? 0.0 : DEFAULT_DELAY_SIGMA;
+    }
+    circuit->queued = calloc(n + 1, sizeof(unsigned char));
+    if (!circuit->queued || !circuit->port_delay) {
+        fprintf(stderr, "Out of memory loading snapshot %s\n", path);
+        exit(1);
+    }
+    return circuit;
+}
+
+// Column value kinds of a report table
+typedef enum {
+    COLUMN_NODE,             // Node name (node index in binary reports)
+    COLUMN_TEXT,
+    COLUMN_INT,
+    COLUMN_REAL
+} ColumnType;
+
+typedef struct {
+    const char* title;       // Text report heading
+    const char* key;         // CSV, JSON and binary name
+    ColumnType type;
+    int width;               // Text report width; negative to left-align
+    int text_only;           // Decoration left out of machine-readable formats
+} ReportColumn;
+
+// Buffered writer behind every report format. Each section is a table
+// whose cells are encoded per format, and numbers are formatted by hand:
+// on large designs printf's format parsing costs more than the analysis.
+typedef struct {
+    FILE* file;
+    ReportFormat format;
+    int failed;
+    char* buffer;
+    size_t used;
+    const Circuit* circuit;
+    const char* table;
+    const ReportColumn* columns;
+    int column_count;
+    int column;
+    long long row;
+    int table_count;
+    unsigned char* referenced;  // Binary: nodes whose names are written last
+} ReportWriter;
+
+static void report_flush(ReportWriter* writer) {
+    if (writer->used > 0 && fwrite(writer->buffer, 1, writer->used, writer->file) != writer->used) {
+        writer->failed = 1;
+    }
+    writer->used = 0;
+}
+
+static void report_bytes(ReportWriter* writer, const void* data, size_t length) {
+    if (writer->used + length > REPORT_BUFFER_SIZE) {
+        report_flush(writer);
+        if (length > REPORT_BUFFER_SIZE) {
+            if (fwrite(data, 1, length, writer->file) != length) writer->failed = 1;
+            return;
+        }
+    }
+    memcpy(writer->buffer + writer->used, data, length);
+    writer->used += length;
+}
+
+static void report_text(ReportWriter* writer, const char* text) {
+    report_bytes(writer, text, strlen(text));
+}
+
+// Write text in a field of |width| columns, right-aligned for a positive
+// width and left-aligned for a negative one
+static void report_padded(ReportWriter* writer, const char* text, size_t length, int width) {
+    static const char spaces[] = "                                ";
+    size_t columns = width < 0 ? -(size_t)width : (size_t)width;
+    size_t pad = columns > length ? columns - length : 0;
+    if (width < 0) report_bytes(writer, text, length);
+    while (pad > 0) {
+        size_t chunk = pad < sizeof(spaces) - 1 ? pad : sizeof(spaces) - 1;
+        report_bytes(writer, spaces, chunk);
+        pad -= chunk;
+    }
+    if (width >= 0) report_bytes(writer, text, length);
+}
+
+// Format value with a fixed number of decimals (at most 6) and return its
+// length. Magnitudes from 1e12 up, such as the required time of a node
+// with no path to an endpoint, are written as inf.
+static int format_fixed(char* text, double value, int decimals) {
+    static const double scale[] = {1.0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6};
+    if (isnan(value)) {
+        memcpy(text, "nan", 3);
+        return 3;
+    }
+    if (fabs(value) >= 1e12) {
+        memcpy(text, value < 0.0 ? "-inf" : "inf", value < 0.0 ? 4 : 3);
+        return value < 0.0 ? 4 : 3;
+    }
+
+    unsigned long long scaled = llround(fabs(value) * scale[decimals]);
+    char digits[24];
+    int count = 0;
+    do {
+        digits[count++] = '0' + scaled % 10;
+        scaled /= 10;
+    } while (scaled > 0 || count <= decimals);
+
+    int length = 0;
+    if (value < 0.0 && (count > 1 || digits[0] != '0')) text[length++] = '-';
+    while (count > 0) {
+        if (count == decimals) text[length++] = '.';
+        text[length++] = digits[--count];
+    }
+    return length;
+}
+
+static int format_int(char* text, long long value) {
+    char digits[24];
+    int count = 0;
+    unsigned long long magnitude = value < 0 ? -(unsigned long long)value : (unsigned long long)value;
+    do {
+        digits[count++] = '0' + magnitude % 10;
+        magnitude /= 10;
+    } while (magnitude > 0);
+
+    int length = 0;
+    if (value < 0) text[length++] = '-';
+    while (count > 0) text[length++] = digits[--count];
+    return length;
+}
+
+// Write a string as a quoted JSON string or, when needed, a quoted CSV field
+static void report_quoted(ReportWriter* writer, const char* text) {
+    size_t length = strlen(text);
+    if (writer->format == REPORT_CSV && !strpbrk(text, ",\"\n")) {
+        report_bytes(writer, text, length);
+        return;
+    }
+    report_bytes(writer, "\"", 1);
+    size_t start = 0;
+    for (size_t i = 0; i < length; i++) {
+        unsigned char c = text[i];
+        if (c != '"' && (writer->format == REPORT_CSV || (c != '\\' && c >= 0x20))) continue;
+        report_bytes(writer, text + start, i - start);
+        if (writer->format == REPORT_CSV) {
+            report_bytes(writer, "\"\"", 2);
+        } else if (c == '"' || c == '\\') {
+            char escape[2] = {'\\', c};
+            report_bytes(writer, escape, 2);
+        } else {
+            char escape[8];
+            snprintf(escape, sizeof(escape), "\\u%04x", c);
+            report_bytes(writer, escape, 6);
+        }
+        start = i + 1;
+    }
+    report_bytes(writer, text + start, length - start);
+    report_bytes(writer, "\"", 1);
+}
+
+// Start a table of row_count rows. Text tables get a title and a header
+// line; CSV rows are prefixed with the table key; binary tables are
+// described by their column names and types.
+static void report_begin_table(ReportWriter* writer, const char* title, const char* key,
+                               const ReportColumn* columns, int column_count, long long row_count) {
+    writer->table = key;
+    writer->columns = columns;
+    writer->column_count = column_count;
+    writer->row = 0;
+
+    switch (writer->format) {
+        case REPORT_TEXT:
+            report_text(writer, title);
+            report_text(writer, ":\n---------------------\n");
+            for (int c = 0; c < column_count; c++) {
+                if (!columns[c].title[0]) continue;
+                if (c > 0) report_bytes(writer, "  ", 2);
+                report_padded(writer, columns[c].title, strlen(columns[c].title),
+                              c == column_count - 1 && columns[c].width < 0 ? 0 : columns[c].width);
+            }
+            report_bytes(writer, "\n", 1);
+            break;
+        case REPORT_CSV:
+            report_text(writer, key);
+            for (int c = 0; c < column_count; c++) {
+                if (columns[c].text_only) continue;
+                report_bytes(writer, ",", 1);
+                report_text(writer, columns[c].key);
+            }
+            report_bytes(writer, "\n", 1);
+            break;
+        case REPORT_JSON:
+            if (writer->table_count > 0) report_bytes(writer, ",\n", 2);
+            report_quoted(writer, key);
+            report_bytes(writer, ": [", 3);
+            break;
+        case REPORT_BINARY: {
+            uint32_t length = strlen(key);
+            uint32_t count = 0;
+            for (int c = 0; c < column_count; c++) count += !columns[c].text_only;
+            report_bytes(writer, &length, sizeof(length));
+            report_bytes(writer, key, length);
+            report_bytes(writer, &count, sizeof(count));
+            for (int c = 0; c < column_count; c++) {
+                if (columns[c].text_only) continue;
+                unsigned char type = columns[c].type;
+                length = strlen(columns[c].key);
+                report_bytes(writer, &type, 1);
+                report_bytes(writer, &length, sizeof(length));
+                report_bytes(writer, columns[c].key, length);
+            }
+            uint64_t rows = row_count;
+            report_bytes(writer, &rows, sizeof(rows));
+            break;
+        }
+    }
+    writer->table_count++;
+}
+
+static void report_begin_row(ReportWriter* writer) {
+    writer->column = 0;
+    if (writer->format == REPORT_CSV) {
+        report_text(writer, writer->table);
+    } else if (writer->format == REPORT_JSON) {
+        report_text(writer, writer->row > 0 ? ",\n  {" : "\n  {");
+    }
+}
+
+static void report_end_row(ReportWriter* writer) {
+    if (writer->format == REPORT_TEXT || writer->format == REPORT_CSV) {
+        report_bytes(writer, "\n", 1);
+    } else if (writer->format == REPORT_JSON) {
+        report_bytes(writer, "}", 1);
+    }
+    writer->row++;
+}
+
+static void report_end_table(ReportWriter* writer) {
+    if (writer->format == REPORT_TEXT) {
+        report_bytes(writer, "\n", 1);
+    } else if (writer->format == REPORT_JSON) {
+        report_text(writer, writer->row > 0 ? "\n]" : "]");
+    }
+}
+
+// Start the next cell of the current row. Returns the column, or NULL
+// when the column is left out of this format.
+static const ReportColumn* report_next_cell(ReportWriter* writer) {
+    const ReportColumn* column = &writer->columns[writer->column++];
+    if (column->text_only && writer->format != REPORT_TEXT) return NULL;
+
+    switch (writer->format) {
+        case REPORT_TEXT:
+            break;           // Separated by report_text_field()
+        case REPORT_CSV:
+            report_bytes(writer, ",", 1);
+            break;
+        case REPORT_JSON:
+            // Keys are plain identifiers and need no escaping
+            report_text(writer, writer->column > 1 ? ", \"" : "\"");
+            report_text(writer, column->key);
+            report_bytes(writer, "\": ", 3);
+            break;
+        case REPORT_BINARY:
+            break;
+    }
+    return column;
+}
+
+// Write a cell of a text report in its column. Nothing trails the last
+// column, so lines carry no trailing blanks.
+static void report_text_field(ReportWriter* writer, const ReportColumn* column, const char* text, size_t length) {
+    int last = writer->column == writer->column_count;
+    if (last && length == 0) return;
+    if (writer->column > 1) report_bytes(writer, "  ", 2);
+    report_padded(writer, text, length, last && column->width < 0 ? 0 : column->width);
+}
+
+static void report_cell_text(ReportWriter* writer, const char* text) {
+    const ReportColumn* column = report_next_cell(writer);
+    if (!column) return;
+    if (writer->format == REPORT_TEXT) {
+        report_text_field(writer, column, text, strlen(text));
+    } else if (writer->format == REPORT_BINARY) {
+        uint16_t length = strlen(text);
+        report_bytes(writer, &length, sizeof(length));
+        report_bytes(writer, text, length);
+    } else {
+        report_quoted(writer, text);
+    }
+}
+
+static void report_cell_node(ReportWriter* writer, NodeId node) {
+    if (writer->format != REPORT_BINARY) {
+        report_cell_text(writer, node_name(writer->circuit, node));
+        return;
+    }
+    if (!report_next_cell(writer)) return;
+    int32_t index = node;
+    report_bytes(writer, &index, sizeof(index));
+    writer->referenced[node] = 1;
+}
+
+static void report_cell_int(ReportWriter* writer, long long value) {
+    const ReportColumn* column = report_next_cell(writer);
+    if (!column) return;
+    if (writer->format == REPORT_BINARY) {
+        int64_t raw = value;
+        report_bytes(writer, &raw, sizeof(raw));
+        return;
+    }
+    char text[24];
+    int length = format_int(text, value);
+    if (writer->format == REPORT_TEXT) {
+        report_text_field(writer, column, text, length);
+    } else {
+        report_bytes(writer, text, length);
+    }
+}
+
+// Text reports round to REPORT_TEXT_DECIMALS, CSV and JSON keep
+// REPORT_DATA_DECIMALS, and binary reports the raw double
+static void report_cell_real(ReportWriter* writer, double value) {
+    const ReportColumn* column = report_next_cell(writer);
+    if (!column) return;
+    if (writer->format == REPORT_BINARY) {
+        report_bytes(writer, &value, sizeof(value));
+        return;
+    }
+    if (writer->format == REPORT_JSON && !(fabs(value) < 1e12)) {
+        report_bytes(writer, "null", 4);
+        return;
+    }
+    char text[40];
+    if (writer->format == REPORT_TEXT) {
+        report_text_field(writer, column, text, format_fixed(text, value, REPORT_TEXT_DECIMALS));
+    } else {
+        report_bytes(writer, text, format_fixed(text, value, REPORT_DATA_DECIMALS));
+    }
+}
+
+static void report_summary(ReportWriter* writer, const EndpointSlack* sorted, int endpoint_count) {
+    static const ReportColumn columns[] = {
+        {"Nodes", "nodes", COLUMN_INT, 10, 0}, {"Edges", "edges", COLUMN_INT, 10, 0}, {"Levels", "levels", COLUMN_INT, 8, 0},
+        {"Endpoints", "endpoints", COLUMN_INT, 10, 0}, {"Violations", "violations", COLUMN_INT, 10, 0},
+        {"WNS (ns)", "wns", COLUMN_REAL, 10, 0}, {"TNS (ns)", "tns", COLUMN_REAL, 12, 0}
+    };
+    const Circuit* circuit = writer->circuit;
+    int violations = 0;
+    double total = 0.0;
+    for (int i = 0; i < endpoint_count && sorted[i].slack < 0.0; i++) {
+        violations++;
+        total += sorted[i].slack;
+    }
+
+    report_begin_table(writer, "Timing Summary", "summary", columns, 7, 1);
+    report_begin_row(writer);
+    report_cell_int(writer, circuit->node_count);
+    report_cell_int(writer, circuit->edge_count);
+    report_cell_int(writer, circuit->level_count);
+    report_cell_int(writer, endpoint_count);
+    report_cell_int(writer, violations);
+    report_cell_real(writer, endpoint_count > 0 ? sorted[0].slack : 0.0);
+    report_cell_real(writer, total);
+    report_end_row(writer);
+    report_end_table(writer);
+}
+
+// Endpoint count per equal-width slack interval, from the sorted slacks
+static void report_histogram(ReportWriter* writer, const EndpointSlack* sorted, int endpoint_count) {
+    static const ReportColumn columns[] = {
+        {"From (ns)", "from", COLUMN_REAL, 10, 0}, {"To (ns)", "to", COLUMN_REAL, 10, 0},
+        {"Endpoints", "endpoints", COLUMN_INT, 10, 0}, {"", "bar", COLUMN_TEXT, -REPORT_BAR_WIDTH, 1}
+    };
+    if (endpoint_count == 0) return;
+    double low = sorted[0].slack;
+    double high = sorted[endpoint_count - 1].slack;
+    int bin_count = high > low ? REPORT_HISTOGRAM_BINS : 1;
+    double width = (high - low) / bin_count;
+
+    int counts[REPORT_HISTOGRAM_BINS] = {0};
+    int largest = 0;
+    for (int i = 0, bin = 0; i < endpoint_count; i++) {
+        while (bin < bin_count - 1 && sorted[i].slack >= low + (bin + 1) * width) bin++;
+        counts[bin]++;
+        if (counts[bin] > largest) largest = counts[bin];
+    }
+
+    char bar[REPORT_BAR_WIDTH + 1];
+    report_begin_table(writer, "Endpoint Slack Histogram", "histogram", columns, 4, bin_count);
+    for (int bin = 0; bin < bin_count; bin++) {
+        int length = (int)((long long)counts[bin] * REPORT_BAR_WIDTH / largest);
+        if (length == 0 && counts[bin] > 0) length = 1;
+        memset(bar, '#', length);
+        bar[length] = '\0';
+        report_begin_row(writer);
+        report_cell_real(writer, low + bin * width);
+        report_cell_real(writer, bin == bin_count - 1 ? high : low + (bin + 1) * width);
+        report_cell_int(writer, counts[bin]);
+        report_cell_text(writer, bar);
+        report_end_row(writer);
+    }
+    report_end_table(writer);
+}
+
+static void report_worst_endpoints(ReportWriter* writer, const EndpointSlack* sorted, int endpoint_count,
+                                   int worst_count) {
+    static const ReportColumn columns[] = {
+        {"Rank", "rank", COLUMN_INT, 6, 0}, {"Endpoint", "endpoint", COLUMN_NODE, -24, 0}, {"Type", "type", COLUMN_TEXT, -6, 0},
+        {"Slack (ns)", "slack", COLUMN_REAL, 10, 0}, {"Arrival (ns)", "arrival", COLUMN_REAL, 12, 0},
+        {"Required (ns)", "required", COLUMN_REAL, 13, 0}
+    };
+    const Circuit* circuit = writer->circuit;
+    int count = worst_count < endpoint_count ? worst_count : endpoint_count;
+
+    report_begin_table(writer, "Worst Endpoints", "endpoints", columns, 6, count);
+    for (int i = 0; i < count; i++) {
+        NodeId endpoint = sorted[i].node;
+        report_begin_row(writer);
+        report_cell_int(writer, i + 1);
+        report_cell_node(writer, endpoint);
+        report_cell_text(writer, gate_type_name(circuit->type[endpoint]));
+        report_cell_real(writer, sorted[i].slack);
+        report_cell_real(writer, worst_arrival(circuit, endpoint));
+        report_cell_real(writer, circuit->required_time[TRANSITION_RISE][endpoint]);
+        report_end_row(writer);
+    }
+    report_end_table(writer);
+}
+
+// One table of paths and one of their steps, each step with the time
+// its transition arrives at the node
+static void report_paths(ReportWriter* writer, const CriticalPaths* paths) {
+    static const ReportColumn path_columns[] = {
+        {"Path", "path", COLUMN_INT, 6, 0}, {"Startpoint", "startpoint", COLUMN_NODE, -24, 0}, {"Endpoint", "endpoint", COLUMN_NODE, -24, 0},
+        {"Slack (ns)", "slack", COLUMN_REAL, 10, 0}, {"Arrival (ns)", "arrival", COLUMN_REAL, 12, 0}, {"Depth", "depth", COLUMN_INT, 6, 0}
+    };
+    static const ReportColumn step_columns[] = {
+        {"Path", "path", COLUMN_INT, 6, 0}, {"Node", "node", COLUMN_NODE, -24, 0}, {"Type", "type", COLUMN_TEXT, -6, 0},
+        {"Edge", "transition", COLUMN_TEXT, -4, 0}, {"Time (ns)", "time", COLUMN_REAL, 10, 0}
+    };
+    const Circuit* circuit = writer->circuit;
+
+    report_begin_table(writer, "Critical Paths", "paths", path_columns, 6, paths->path_count);
+    for (int p = 0; p < paths->path_count; p++) {
+        int first = paths->path_start[p];
+        int last = paths->path_start[p + 1] - 1;
+        report_begin_row(writer);
+        report_cell_int(writer, p + 1);
+        report_cell_node(writer, paths->nodes[first]);
+        report_cell_node(writer, paths->nodes[last]);
+        report_cell_real(writer, paths->slack[p]);
+        report_cell_real(writer, paths->arrival[p]);
+        report_cell_int(writer, last - first + 1);
+        report_end_row(writer);
+    }
+    report_end_table(writer);
+
+    report_begin_table(writer, "Critical Path Steps", "path_steps", step_columns, 5,
+                       paths->path_start[paths->path_count]);
+    const unsigned char* transition = paths->transitions;
+    for (int p = 0; p < paths->path_count; p++) {
+        int first = paths->path_start[p];
+        int last = paths->path_start[p + 1] - 1;
+        double time = launch_time(circuit, circuit->arrival_time, paths->nodes[first], transition[first], 1);
+        for (int i = first; i <= last; i++) {
+            NodeId node = paths->nodes[i];
+            if (i > first) time += circuit->delay[transition[i]][paths->nodes[i - 1]];
+            report_begin_row(writer);
+            report_cell_int(writer, p + 1);
+            report_cell_node(writer, node);
+            report_cell_text(writer, gate_type_name(circuit->type[node]));
+            report_cell_text(writer, transition[i] == TRANSITION_RISE ? "rise" : "fall");
+            report_cell_real(writer, time);
+            report_end_row(writer);
+        }
+    }
+    report_end_table(writer);
+}
+
+// Every node's rise/fall timing and its slack in each corner
+static void report_nodes(ReportWriter* writer) {
+    static const ReportColumn base_columns[] = {
+        {"Node", "node", COLUMN_NODE, -24, 0}, {"Type", "type", COLUMN_TEXT, -6, 0},
+        {"Rise Delay", "rise_delay", COLUMN_REAL, 10, 0}, {"Fall Delay", "fall_delay", COLUMN_REAL, 10, 0},
+        {"Rise Arrival", "rise_arrival", COLUMN_REAL, 12, 0}, {"Fall Arrival", "fall_arrival", COLUMN_REAL, 12, 0},
+        {"Rise Required", "rise_required", COLUMN_REAL, 13, 0}, {"Fall Required", "fall_required", COLUMN_REAL, 13, 0},
+        {"Slack", "slack", COLUMN_REAL, 10, 0}
+    };
+    enum { BASE_COLUMNS = sizeof(base_columns) / sizeof(base_columns[0]) };
+    const Circuit* circuit = writer->circuit;
+    int corner_count = circuit->corner_slack ? circuit->corner_count : 0;
+
+    ReportColumn columns[BASE_COLUMNS + MAX_CORNERS];
+    char corner_titles[MAX_CORNERS][MAX_CORNER_NAME + 8];
+    char corner_keys[MAX_CORNERS][MAX_CORNER_NAME + 8];
+    memcpy(columns, base_columns, sizeof(base_columns));
+    for (int c = 0; c < corner_count; c++) {
+        snprintf(corner_titles[c], sizeof(corner_titles[c]), "Slack %s", circuit->corners[c].name);
+        snprintf(corner_keys[c], sizeof(corner_keys[c]), "slack_%s", circuit->corners[c].name);
+        columns[BASE_COLUMNS + c] = (ReportColumn){corner_titles[c], corner_keys[c], COLUMN_REAL, 10, 0};
+    }
+
+    report_begin_table(writer, "Node Timing (ns)", "nodes", columns, BASE_COLUMNS + corner_count,
+                       circuit->node_count);
+    for (int i = 0; i < circuit->node_count; i++) {
+        report_begin_row(writer);
+        report_cell_node(writer, i);
+        report_cell_text(writer, gate_type_name(circuit->type[i]));
+        for (int t = 0; t < TRANSITION_COUNT; t++) report_cell_real(writer, circuit->delay[t][i]);
+        for (int t = 0; t < TRANSITION_COUNT; t++) report_cell_real(writer, circuit->arrival_time[t][i]);
+        for (int t = 0; t < TRANSITION_COUNT; t++) report_cell_real(writer, circuit->required_time[t][i]);
+        report_cell_real(writer, circuit->slack[i]);
+        for (int c = 0; c < corner_count; c++) {
+            report_cell_real(writer, circuit->corner_slack[(size_t)i * MAX_CORNERS + c]);
+        }
+        report_end_row(writer);
+    }
+    report_end_table(writer);
+}
+
+// Binary reports refer to nodes by index; name every node they mention
+static void report_node_names(ReportWriter* writer) {
+    static const ReportColumn columns[] = {
+        {"Node", "node", COLUMN_INT, 0, 0}, {"Name", "name", COLUMN_TEXT, 0, 0}
+    };
+    const Circuit* circuit = writer->circuit;
+    long long count = 0;
+    for (int i = 0; i < circuit->node_count; i++) count += writer->referenced[i];
+
+    report_begin_table(writer, "Names", "names", columns, 2, count);
+    for (int i = 0; i < circuit->node_count; i++) {
+        if (!writer->referenced[i]) continue;
+        report_begin_row(writer);
+        report_cell_int(writer, i);
+        report_cell_text(writer, node_name(circuit, i));
+        report_end_row(writer);
+    }
+    report_end_table(writer);
+}
+
+// Open a report on path, or on stdout when path is NULL, and write the
+// format's preamble. circuit names the nodes of node cells and may be
+// NULL for reports without any. Returns 0 on success, -1 on error.
+static int report_open(ReportWriter* writer, const Circuit* circuit, ReportFormat format, const char* path) {
+    memset(writer, 0, sizeof(*writer));
+    writer->file = path ? fopen(path, format == REPORT_BINARY ? "wb" : "w") : stdout;
+    if (!writer->file) {
+        fprintf(stderr, "Cannot write report %s\n", path);
+        return -1;
+    }
+    writer->format = format;
+    writer->circuit = circuit;
+    writer->buffer = malloc(REPORT_BUFFER_SIZE);
+    if (format == REPORT_BINARY && circuit) writer->referenced = calloc(circuit->node_count + 1, 1);
+    if (!writer->buffer || (format == REPORT_BINARY && circuit && !writer->referenced)) {
+        fprintf(stderr, "Out of memory writing report\n");
+        exit(1);
+    }
+
+    if (format == REPORT_JSON) {
+        report_bytes(writer, "{\n", 2);
+    } else if (format == REPORT_BINARY) {
+        uint32_t header[2] = {REPORT_VERSION, 0x01020304};
+        report_bytes(writer, REPORT_MAGIC, 8);
+        report_bytes(writer, header, sizeof(header));
+    }
+    return 0;
+}
+
+// Finish and close a report opened by report_open(). Returns 0 on
+// success, -1 if anything could not be written.
+static int report_close(ReportWriter* writer, const char* path) {
+    if (writer->format == REPORT_JSON) {
+        report_bytes(writer, "\n}\n", 3);
+    } else if (writer->format == REPORT_BINARY && writer->circuit) {
+        report_node_names(writer);
+    }
+    report_flush(writer);
+
+    if (path && fclose(writer->file) != 0) writer->failed = 1;
+    if (writer->failed) fprintf(stderr, "Error writing report %s\n", path ? path : "to standard output");
+    free(writer->buffer);
+    free(writer->referenced);
+    return writer->failed ? -1 : 0;
+}
+
+// Write the timing report for an analyzed circuit to path, or to stdout
+// when path is NULL: a summary, the endpoint slack histogram, the worst
+// endpoints, the given critical paths (may be NULL) and, when requested,
+// every node. Returns 0 on success, -1 on error.
+int write_timing_report(Circuit* circuit, const CriticalPaths* paths, const ReportOptions* options,
+                        const char* path) {
+    TRACE_SCOPE("write_timing_report");
+    ReportWriter writer;
+    if (report_open(&writer, circuit, options->format, path) != 0) return -1;
+    EndpointSlack* sorted = malloc((circuit->endpoint_count + 1) * sizeof(EndpointSlack));
+    if (!sorted) {
+        fprintf(stderr, "Out of memory writing report\n");
+        exit(1);
+    }
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        sorted[i].node = circuit->endpoints[i];
+        sorted[i].slack = circuit->slack[sorted[i].node];
+    }
+    qsort(sorted, circuit->endpoint_count, sizeof(EndpointSlack), compare_endpoint_slack);
+
+    // Endpoints reached only by false paths sort last with infinite slack
+    // and are left out of the histogram and the worst endpoints
+    int constrained = circuit->endpoint_count;
+    while (constrained > 0 && sorted[constrained - 1].slack == DBL_MAX) constrained--;
+
+    report_summary(&writer, sorted, circuit->endpoint_count);
+    report_histogram(&writer, sorted, constrained);
+    report_worst_endpoints(&writer, sorted, constrained, options->worst_count);
+    if (paths) report_paths(&writer, paths);
+    if (options->include_nodes) report_nodes(&writer);
+
+    free(sorted);
+    return report_close(&writer, path);
+}
+
+// Summarize setup checks at every endpoint and hold checks at every
+// flip-flop, listing the endpoints that violate either
+void print_timing_checks(const Circuit* circuit) {
+    double setup_worst = DBL_MAX, setup_total = 0.0;
+    double hold_worst = DBL_MAX, hold_total = 0.0;
+    int setup_violations = 0, hold_violations = 0, hold_checks = 0;
+
+    printf("Timing Checks:\n");
+    printf("---------------------\n");
+    if (circuit->clock_period > 0.0) {
+        printf("Clock period: %.3f ns  Setup: %.3f ns  Hold: %.3f ns\n",
+               circuit->clock_period, circuit->setup_time, circuit->hold_time);
+    } else {
+        printf("No clock constraint: setup slack is relative to the worst endpoint\n");
+    }
+
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        NodeId endpoint = circuit->endpoints[i];
+        double slack = circuit->slack[endpoint];
+        setup_worst = fmin(setup_worst, slack);
+        if (slack < 0.0) {
+            setup_total += slack;
+            setup_violations++;
+            printf("  VIOLATED setup %-24s required %8.2f ns  arrival %8.2f ns  slack %8.2f ns\n",
+                   node_name(circuit, endpoint), circuit->required_time[TRANSITION_RISE][endpoint],
+                   worst_arrival(circuit, endpoint), slack);
+        }
+        if (circuit->type[endpoint] != GATE_DFF) continue;
+
+        slack = hold_slack(circuit, endpoint);
+        hold_worst = fmin(hold_worst, slack);
+        hold_checks++;
+        if (slack < 0.0) {
+            hold_total += slack;
+            hold_violations++;
+            printf("  VIOLATED hold  %-24s required %8.2f ns  arrival %8.2f ns  slack %8.2f ns\n",
+                   node_name(circuit, endpoint), circuit->hold_time,
+                   fmin(circuit->early_arrival[TRANSITION_RISE][endpoint],
+                        circuit->early_arrival[TRANSITION_FALL][endpoint]), slack);
+        }
+    }
+
+    if (circuit->endpoint_count > 0) {
+        printf("Setup: %d endpoint(s)  WNS %.2f ns  TNS %.2f ns  %d violation(s)\n",
+               circuit->endpoint_count, setup_worst, setup_total, setup_violations);
+    }
+    if (hold_checks > 0) {
+        printf("Hold:  %d endpoint(s)  WNS %.2f ns  TNS %.2f ns  %d violation(s)\n",
+               hold_checks, hold_worst, hold_total, hold_violations);
+    }
+    printf("\n");
+}
+
+// Wall-clock time in seconds
+static double elapsed_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+// Build a random layered netlist: 1% primary inputs, 1% primary outputs,
+// and gates that take 1-3 fan-ins from a sliding window of earlier nodes
+Circuit* generate_random_circuit(int gate_count, unsigned int seed) {
+    Circuit* circuit = create_circuit();
+    int input_count = gate_count / 100 + 1;
+    int output_count = gate_count / 100 + 1;
+    int window = 2000;
+    char name[32];
+
+    srand(seed);
+    for (int i = 0; i < input_count; i++) {
+        snprintf(name, sizeof(name), "in%d", i);
+        create_node(circuit, name, INPUT);
+    }
+    for (int i = 0; i < gate_count; i++) {
+        snprintf(name, sizeof(name), "g%d", i);
+        NodeId gate = create_node(circuit, name, (GateType)(rand() % (GATE_XOR + 1)));
+        int lowest = gate > window ? gate - window : 0;
+        int fanin_count = 1 + rand() % 3;
+        for (int j = 0; j < fanin_count; j++) {
+            add_connection(circuit, lowest + rand() % (gate - lowest), gate);
+        }
+    }
+    for (int i = 0; i < output_count; i++) {
+        snprintf(name, sizeof(name), "out%d", i);
+        NodeId output = create_node(circuit, name, OUTPUT);
+        add_connection(circuit, output - 1 - rand() % (gate_count < window ? gate_count : window), output);
+    }
+    return circuit;
+}
+
+// Uniform double in [0, 1) from a SplitMix64 stream
+static inline double next_uniform(uint64_t* state) {
+    *state += 0x9E3779B97F4A7C15ULL;
+    return (mix_bits(*state) >> 11) / 9007199254740992.0;
+}
+
+// Build a layered netlist shaped by profile. Gates fill depth levels of
+// equal width above a level of inputs. Each gate's first fan-in comes from
+// the level just below, so every level is populated; further fan-ins come
+// from up to BENCH_FANIN_SPAN levels below or, with probability
+// reconvergence, from the first fan-in's own first fan-in, closing a
+// reconvergent pair of paths at the gate. Within a level a source is
+// picked at position width * u^fanout_skew, so a skew above 1 piles the
+// fan-out onto a few nets. Every node left without fan-out drives its
+// own OUTPUT.
+Circuit* generate_synthetic_circuit(const NetlistProfile* profile) {
+    Circuit* circuit = create_circuit();
+    int gate_count = profile->gate_count;
+    int depth = profile->depth < 1 ? 1 : profile->depth > gate_count ? gate_count : profile->depth;
+    int width = (gate_count + depth - 1) / depth;
+    int* first_fanin = malloc((gate_count + 1) * sizeof(int));
+    unsigned char* has_fanout = calloc(width + gate_count + 1, 1);
+    uint64_t state = profile->seed;
+    char name[32];
+
+    // Level 0 holds the inputs at [0, width); level l > 0 holds gates
+    // [width * l, width * (l + 1)), the last level possibly partial
+    for (int i = 0; i < width; i++) {
+        snprintf(name, sizeof(name), "in%d", i);
+        create_node(circuit, name, INPUT);
+    }
+    for (int i = 0; i < gate_count; i++) {
+        snprintf(name, sizeof(name), "g%d", i);
+        NodeId gate = create_node(circuit, name, (GateType)(mix_bits(state + i) % (GATE_XOR + 1)));
+        int level = gate / width;
+        int fanin_count = 1 + (int)(next_uniform(&state) * 3);
+
+        for (int j = 0; j < fanin_count; j++) {
+            NodeId source;
+            if (j > 0 && first_fanin[i] >= width && next_uniform(&state) < profile->reconvergence) {
+                source = first_fanin[first_fanin[i] - width];
+            } else {
+                int span = level < BENCH_FANIN_SPAN ? level : BENCH_FANIN_SPAN;
+                int source_level = j == 0 ? level - 1 : level - 1 - (int)(next_uniform(&state) * span);
+                source = source_level * width + (int)(width * pow(next_uniform(&state), profile->fanout_skew));
+            }
+            if (j == 0) first_fanin[i] = source;
+            add_connection(circuit, source, gate);
+            has_fanout[source] = 1;
+        }
+    }
+
+    int output_count = 0;
+    for (NodeId node = 0; node < width + gate_count; node++) {
+        if (has_fanout[node]) continue;
+        snprintf(name, sizeof(name), "out%d", output_count++);
+        add_connection(circuit, node, create_node(circuit, name, OUTPUT));
+    }
+    free(first_fanin);
+    free(has_fanout);
+    return circuit;
+}
+
+// Compare update_timing() after single-gate delay edits with a full
+// re-time, and check that both give the same slack
+int run_incremental_benchmark(int gate_count, int thread_count) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    circuit->thread_count = thread_count;
+
+    double start = elapsed_seconds();
+    compute_arrival_times(circuit);
+    compute_required_times(circuit);
+    compute_slack(circuit);
+    double full_time = elapsed_seconds() - start;
+
+    start = elapsed_seconds();
+    for (int i = 0; i < BENCH_INCREMENTAL_EDITS; i++) {
+        NodeId gate = rand() % circuit->node_count;
+        if (circuit->type[gate] == INPUT) continue;
+        // Scale the two transitions independently so the tracks diverge
+        double rise = circuit->delay[TRANSITION_RISE][gate] * (0.5 + rand() / (double)RAND_MAX);
+        double fall = circuit->delay[TRANSITION_FALL][gate] * (0.5 + rand() / (double)RAND_MAX);
+        set_node_delay(circuit, gate, rise, fall);
+        update_timing(circuit);
+    }
+    double incremental_time = (elapsed_seconds() - start) / BENCH_INCREMENTAL_EDITS;
+
+    // Cross-check against a from-scratch analysis
+    double* slack = malloc(circuit->node_count * sizeof(double));
+    memcpy(slack, circuit->slack, circuit->node_count * sizeof(double));
+    compute_arrival_times(circuit);
+    compute_required_times(circuit);
+    compute_slack(circuit);
+    int mismatches = 0;
+    for (int i = 0; i < circuit->node_count; i++) {
+        if (slack[i] != circuit->slack[i]) mismatches++;
+    }
+
+    printf("Incremental Timing Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d\n",
+           circuit->node_count, circuit->edge_count, circuit->level_count);
+    printf("Full re-time:       %.3f ms\n", full_time * 1e3);
+    printf("Incremental update: %.3f ms (average of %d edits)\n",
+           incremental_time * 1e3, BENCH_INCREMENTAL_EDITS);
+    printf("Speedup:            %.1fx\n", full_time / incremental_time);
+    printf("Slack mismatches:   %d\n", mismatches);
+
+    free(slack);
+    free_circuit(circuit);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Time MAX_CORNERS derated corners as separate single-corner analyses
+// and as one multi-corner pass, and check that both give the same slack
+int run_corner_benchmark(int gate_count, int thread_count) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    circuit->thread_count = thread_count;
+    if (levelize_circuit(circuit) != 0) return 1;
+
+    char name[MAX_CORNER_NAME];
+    for (int c = 0; c < MAX_CORNERS; c++) {
+        snprintf(name, sizeof(name), "derate%d", c);
+        add_corner(circuit, name, 0.8 + 0.1 * c, NULL);
+    }
+
+    int n = circuit->node_count;
+    double* base_delay[TRANSITION_COUNT];
+    double* corner_slack = malloc((size_t)n * MAX_CORNERS * sizeof(double));
+    for (int t = 0; t < TRANSITION_COUNT; t++) {
+        base_delay[t] = malloc(n * sizeof(double));
+        memcpy(base_delay[t], circuit->delay[t], n * sizeof(double));
+    }
+
+    double start = elapsed_seconds();
+    for (int run = 0; run < BENCH_CORNER_RUNS; run++) {
+        for (int c = 0; c < MAX_CORNERS; c++) {
+            for (int t = 0; t < TRANSITION_COUNT; t++) {
+                for (int i = 0; i < n; i++) circuit->delay[t][i] = base_delay[t][i] * circuit->corners[c].derate;
+            }
+            compute_arrival_times(circuit);
+            compute_required_times(circuit);
+            compute_slack(circuit);
+            for (int i = 0; i < n; i++) corner_slack[(size_t)i * MAX_CORNERS + c] = circuit->slack[i];
+        }
+    }
+    double separate_time = (elapsed_seconds() - start) / BENCH_CORNER_RUNS;
+    for (int t = 0; t < TRANSITION_COUNT; t++) memcpy(circuit->delay[t], base_delay[t], n * sizeof(double));
+
+    start = elapsed_seconds();
+    for (int run = 0; run < BENCH_CORNER_RUNS; run++) {
+        compute_corner_timing(circuit);
+    }
+    double combined_time = (elapsed_seconds() - start) / BENCH_CORNER_RUNS;
+
+    int mismatches = 0;
+    for (size_t k = 0; k < (size_t)n * MAX_CORNERS; k++) {
+        if (corner_slack[k] != circuit->corner_slack[k]) mismatches++;
+    }
+
+    printf("Multi-Corner Timing Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d  Corners: %d\n",
+           n, circuit->edge_count, circuit->level_count, circuit->corner_count);
+    printf("Separate runs:      %.3f ms\n", separate_time * 1e3);
+    printf("Multi-corner pass:  %.3f ms\n", combined_time * 1e3);
+    printf("Speedup:            %.1fx\n", separate_time / combined_time);
+    printf("Slack mismatches:   %d\n", mismatches);
+
+    for (int t = 0; t < TRANSITION_COUNT; t++) free(base_delay[t]);
+    free(corner_slack);
+    free_circuit(circuit);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Time BENCH_MC_SAMPLES Monte Carlo samples and check that with the delay
+// variation switched off every sample reproduces the nominal slack
+int run_statistical_benchmark(int gate_count, int thread_count) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    circuit->thread_count = thread_count;
+    if (levelize_circuit(circuit) != 0) return 1;
+    int n = circuit->node_count;
+
+    double* sigma = malloc(n * sizeof(double));
+    memcpy(sigma, circuit->delay_sigma, n * sizeof(double));
+    memset(circuit->delay_sigma, 0, n * sizeof(double));
+    StatisticalTiming* stats = compute_statistical_timing(circuit, MC_BATCH, MC_DEFAULT_SEED);
+
+    // Sample lanes are single precision, so allow rounding relative to the
+    // size of the arrival times rather than of the slack
+    double tolerance = 1e-5 * (1.0 + endpoint_reference(circuit));
+    int mismatches = 0;
+    for (int e = 0; e < stats->endpoint_count; e++) {
+        double nominal = circuit->slack[circuit->endpoints[e]];
+        if (fabs(stats->slack_mean[e] - nominal) > tolerance || stats->slack_sigma[e] > tolerance) {
+            mismatches++;
+        }
+    }
+    free_statistical_timing(stats);
+    memcpy(circuit->delay_sigma, sigma, n * sizeof(double));
+
+    double start = elapsed_seconds();
+    stats = compute_statistical_timing(circuit, BENCH_MC_SAMPLES, MC_DEFAULT_SEED);
+    double sample_time = (elapsed_seconds() - start) / BENCH_MC_SAMPLES;
+
+    printf("Statistical Timing Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d  Endpoints: %d\n",
+           n, circuit->edge_count, circuit->level_count, circuit->endpoint_count);
+    printf("Samples:            %d (%d per pass)\n", BENCH_MC_SAMPLES, MC_BATCH);
+    printf("Time per sample:    %.3f ms\n", sample_time * 1e3);
+    printf("10k samples:        %.1f s (projected)\n", sample_time * 1e4);
+    printf("Design yield:       %.2f%%\n", stats->design_yield * 100.0);
+    printf("Nominal mismatches: %d\n", mismatches);
+
+    free_statistical_timing(stats);
+    free(sigma);
+    free_circuit(circuit);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Time path-based refinement of the worst endpoints serially and on
+// thread_count threads. Both runs must agree, and no path-based slack
+// may fall below its graph-based slack. Without a library every delay is
+// fixed, so the refinement can only confirm the graph-based slack.
+int run_path_based_benchmark(int gate_count, int thread_count, const char* liberty_path) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    if (liberty_path) {
+        circuit->library = load_liberty(liberty_path);
+        if (!circuit->library) return 1;
+    }
+    if (levelize_circuit(circuit) != 0) return 1;
+
+    double start = elapsed_seconds();
+    compute_delays(circuit);
+    compute_arrival_times(circuit);
+    compute_required_times(circuit);
+    compute_slack(circuit);
+    double graph_time = elapsed_seconds() - start;
+
+    circuit->thread_count = 1;
+    start = elapsed_seconds();
+    PathBasedTiming* serial = compute_path_based_timing(circuit, BENCH_PBA_ENDPOINTS, PBA_DEFAULT_PATHS);
+    double serial_time = elapsed_seconds() - start;
+
+    circuit->thread_count = thread_count;
+    start = elapsed_seconds();
+    PathBasedTiming* parallel = compute_path_based_timing(circuit, BENCH_PBA_ENDPOINTS, PBA_DEFAULT_PATHS);
+    double parallel_time = elapsed_seconds() - start;
+
+    int mismatches = 0;
+    int recovered = 0;
+    int exact = 0;
+    int paths = 0;
+    for (int e = 0; e < serial->endpoint_count; e++) {
+        if (serial->path_slack[e] != parallel->path_slack[e] || serial->exact[e] != parallel->exact[e]) mismatches++;
+        if (serial->path_slack[e] < serial->graph_slack[e] - 1e-9) mismatches++;
+        if (serial->path_slack[e] > serial->graph_slack[e] + 1e-9) recovered++;
+        if (serial->exact[e]) exact++;
+        paths += serial->path_count[e];
+    }
+
+    printf("Path-Based Timing Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d  Endpoints: %d\n",
+           circuit->node_count, circuit->edge_count, circuit->level_count, circuit->endpoint_count);
+    printf("Refined endpoints:  %d (%d paths, %d exact, %d with recovered slack)\n",
+           serial->endpoint_count, paths, exact, recovered);
+    printf("Gate evaluations:   %lld of %lld (shared prefixes)\n", serial->evaluations, serial->path_nodes);
+    printf("Graph-based run:    %.3f ms\n", graph_time * 1e3);
+    printf("Refinement:         %.3f ms (1 thread), %.3f ms (%d threads)\n",
+           serial_time * 1e3, parallel_time * 1e3, thread_count);
+    printf("Mismatches:         %d\n", mismatches);
+
+    free_path_based_timing(serial);
+    free_path_based_timing(parallel);
+    free_liberty(circuit->library);
+    free_circuit(circuit);
+    return mismatches == 0 ? 0 : 1;
+}
+
+// Time a random circuit in memory and out of core within memory_budget
+// bytes, and check that every node's slack is identical. Every
+// BENCH_OOC_REGISTER_STRIDE-th gate is made a flip-flop so register
+// launches and endpoints are covered. The last gate also drives a primary
+// input of its own, which must keep its input delay as its arrival.
+int run_out_of_core_benchmark(int gate_count, size_t memory_budget) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    NodeId last_gate = -1;
+    for (NodeId node = 0; node < circuit->node_count; node++) {
+        if (node % BENCH_OOC_REGISTER_STRIDE == BENCH_OOC_REGISTER_STRIDE - 1 && circuit->type[node] <= GATE_XOR) {
+            circuit->type[node] = GATE_DFF;
+        }
+        if (circuit->type[node] <= GATE_XOR) last_gate = node;
+    }
+    if (last_gate >= 0) {
+        NodeId driven = create_node(circuit, "in_driven", INPUT);
+        NodeId output = create_node(circuit, "out_driven", OUTPUT);
+        circuit->port_delay[driven] = 0.5;
+        add_connection(circuit, last_gate, driven);
+        add_connection(circuit, driven, output);
+    }
+    if (levelize_circuit(circuit) != 0) return 1;
+
+    double start = elapsed_seconds();
+    compute_arrival_times(circuit);
+    compute_required_times(circuit);
+    compute_slack(circuit);
+    double memory_time = elapsed_seconds() - start;
+
+    char directory[] = "/tmp/sta-out-of-core-XXXXXX";
+    if (!mkdtemp(directory)) {
+        fprintf(stderr, "Cannot create a scratch directory\n");
+        return 1;
+    }
+    OutOfCoreTiming timing;
+    start = elapsed_seconds();
+    int status = compute_out_of_core_timing(circuit, directory, memory_budget, &timing);
+    double out_of_core_time = elapsed_seconds() - start;
+
+    int mismatches = 0;
+    char path[PATH_MAX];
+    snprintf(path, sizeof(path), "%s/slack.bin", directory);
+    FILE* file = status == 0 ? fopen(path, "rb") : NULL;
+    if (file) {
+        for (NodeId node = 0; node < circuit->node_count; node++) {
+            double slack;
+            if (fread(&slack, sizeof(slack), 1, file) != 1 || slack != circuit->slack[node]) mismatches++;
+        }
+        fclose(file);
+    } else {
+        mismatches = circuit->node_count;
+    }
+    unlink(path);
+    rmdir(directory);
+
+    printf("Out-of-Core Timing Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d  Endpoints: %d\n",
+           circuit->node_count, circuit->edge_count, circuit->level_count, circuit->endpoint_count);
+    printf("Chunks:        %d for %d records within %.1f MB (buffers %.1f MB, peak live %d values, %.1f MB)\n",
+           timing.chunk_count, timing.record_count, timing.memory_budget / 1048576.0,
+           timing.buffer_bytes / 1048576.0, timing.peak_live, timing.live_bytes / 1048576.0);
+    printf("I/O:           %.1f MB read, %.1f MB written\n", timing.bytes_read / 1048576.0, timing.bytes_written / 1048576.0);
+    printf("In memory:     %.3f ms\n", memory_time * 1e3);
+    printf("Out of core:   %.3f ms (including partitioning)\n", out_of_core_time * 1e3);
+    printf("Mismatches:    %d\n", mismatches);
+
+    free_circuit(circuit);
+    return status == 0 && mismatches == 0 ? 0 : 1;
+}
+
+// Close BENCH_LOOP_COUNT combinational loops in a random netlist, each
+// from a gate back to the node BENCH_LOOP_DEPTH fan-in steps above it, and
+// compare levelizing with loop detection and cutting against levelizing
+// the same netlist before the loops were added
+int run_loop_benchmark(int gate_count) {
+    Circuit* circuit = generate_random_circuit(gate_count, 1);
+    double start = elapsed_seconds();
+    if (levelize_circuit(circuit) != 0) return 1;
+    double acyclic_time = elapsed_seconds() - start;
+
+    int added = 0;
+    for (int i = 0; i < BENCH_LOOP_COUNT; i++) {
+        NodeId gate = rand() % circuit->node_count;
+        NodeId ancestor = gate;
+        for (int step = 0; step < BENCH_LOOP_DEPTH; step++) {
+            if (circuit->fanin_start[ancestor] == circuit->fanin_start[ancestor + 1]) break;
+            ancestor = circuit->fanin[circuit->fanin_start[ancestor]];
+        }
+        if (ancestor == gate || circuit->type[ancestor] == INPUT) continue;
+        add_connection(circuit, gate, ancestor);
+        added++;
+    }
+
+    start = elapsed_seconds();
+    int status = levelize_circuit(circuit);
+    double loop_time = elapsed_seconds() - start;
+
+    printf("Combinational Loop Benchmark:\n");
+    printf("---------------------\n");
+    printf("Nodes: %d  Edges: %d  Levels: %d\n",
+           circuit->node_count, circuit->edge_count, circuit->level_count);
+    printf("Back edges added:   %d\n", added);
+    printf("Loops found:        %d (%d arc(s) cut)\n", circuit->loop_count, circuit->disabled_count);
+    printf("Levelize, acyclic:  %.3f ms\n", acyclic_time * 1e3);
+    printf("Levelize, loops:    %.3f ms (detection, cutting and rebuild included)\n", loop_time * 1e3);
+
+    int found = circuit->loop_count;
+    free_circuit(circuit);
+    return status == 0 && (added == 0 || found > 0) ? 0 : 1;
+}
+
+// Time every phase of a full analysis on synthetic netlists of 1K gates
+// and every tenfold size up to max_gates. Each phase but the load keeps
+// the best of enough runs to cover BENCH_SUITE_WORK nodes, so small
+// sizes are not lost in timer noise. Results are written as a report
+// table, so CSV or JSON output can be tracked from commit to commit.
+int run_benchmark_suite(const NetlistProfile* profile, int max_gates, int thread_count,
+                        ReportFormat format, const char* path) {
+    static const ReportColumn columns[] = {
+        {"Gates", "gates", COLUMN_INT, 10, 0}, {"Nodes", "nodes", COLUMN_INT, 10, 0},
+        {"Edges", "edges", COLUMN_INT, 10, 0}, {"Levels", "levels", COLUMN_INT, 6, 0},
+        {"Load ms", "load_ms", COLUMN_REAL, 10, 0}, {"Levelize ms", "levelize_ms", COLUMN_REAL, 11, 0},
+        {"Forward ms", "forward_ms", COLUMN_REAL, 10, 0}, {"Backward ms", "backward_ms", COLUMN_REAL, 11, 0},
+        {"Slack ms", "slack_ms", COLUMN_REAL, 9, 0}, {"Report ms", "report_ms", COLUMN_REAL, 9, 0},
+        {"Mnodes/s", "mnodes_per_s", COLUMN_REAL, 9, 0}, {"Peak RSS MB", "peak_rss_mb", COLUMN_REAL, 11, 0}
+    };
+    enum { PHASE_LEVELIZE, PHASE_FORWARD, PHASE_BACKWARD, PHASE_SLACK, PHASE_REPORT, PHASE_COUNT };
+    ReportOptions report = {REPORT_TEXT, REPORT_DEFAULT_WORST, 0};
+
+    int size_count = 0;
+    for (long long gates = BENCH_SUITE_MIN_GATES; gates <= max_gates; gates *= 10) size_count++;
+
+    ReportWriter writer;
+    if (report_open(&writer, NULL, format, path) != 0) return 1;
+    report_begin_table(&writer, "STA Benchmark Suite", "benchmark", columns, 12, size_count);
+    if (format == REPORT_TEXT) report_flush(&writer);
+
+    for (long long gates = BENCH_SUITE_MIN_GATES; gates <= max_gates; gates *= 10) {
+        NetlistProfile size = *profile;
+        size.gate_count = gates;
+
+        double start = elapsed_seconds();
+        Circuit* circuit = generate_synthetic_circuit(&size);
+        double load_time = elapsed_seconds() - start;
+        circuit->thread_count = thread_count;
+
+        double best[PHASE_COUNT];
+        for (int phase = 0; phase < PHASE_COUNT; phase++) best[phase] = DBL_MAX;
+        long long runs = BENCH_SUITE_WORK / gates > 1 ? BENCH_SUITE_WORK / gates : 1;
+        for (long long run = 0; run < runs; run++) {
+            double time[PHASE_COUNT + 1];
+            circuit->graph_built = 0;
+            time[PHASE_LEVELIZE] = elapsed_seconds();
+            if (levelize_circuit(circuit) != 0) return 1;
+            time[PHASE_FORWARD] = elapsed_seconds();
+            compute_arrival_times(circuit);
+            time[PHASE_BACKWARD] = elapsed_seconds();
+            compute_required_times(circuit);
+            time[PHASE_SLACK] = elapsed_seconds();
+            compute_slack(circuit);
+            time[PHASE_REPORT] = elapsed_seconds();
+            if (write_timing_report(circuit, NULL, &report, "/dev/null") != 0) return 1;
+            time[PHASE_COUNT] = elapsed_seconds();
+            for (int phase = 0; phase < PHASE_COUNT; phase++) {
+                best[phase] = fmin(best[phase], time[phase + 1] - time[phase]);
+            }
+        }
+
+        // Throughput of the analysis proper, from levelization to slack
+        double analysis_time = best[PHASE_LEVELIZE] + best[PHASE_FORWARD] + best[PHASE_BACKWARD] + best[PHASE_SLACK];
+        struct rusage usage;
+        getrusage(RUSAGE_SELF, &usage);
+
+        report_begin_row(&writer);
+        report_cell_int(&writer, gates);
+        report_cell_int(&writer, circuit->node_count);
+        report_cell_int(&writer, circuit->edge_count);
+        report_cell_int(&writer, circuit->level_count);
+        report_cell_real(&writer, load_time * 1e3);
+        for (int phase = 0; phase < PHASE_COUNT; phase++) report_cell_real(&writer, best[phase] * 1e3);
+        report_cell_real(&writer, circuit->node_count / analysis_time * 1e-6);
+        report_cell_real(&writer, usage.ru_maxrss / 1024.0);     // Kilobytes on Linux
+        report_end_row(&writer);
+        if (format == REPORT_TEXT) report_flush(&writer);
+        free_circuit(circuit);
+    }
+    report_end_table(&writer);
+    return report_close(&writer, path) == 0 ? 0 : 1;
+}
+
+// Parse a --corner argument NAME=SPEC, where SPEC is a derate, a Liberty
+// file, or LIBERTY:DERATE. Returns the corner index or -1.
+static int parse_corner(Circuit* circuit, const char* argument) {
+    const char* equals = strchr(argument, '=');
+    if (!equals || equals == argument) {
+        fprintf(stderr, "--corner expects NAME=DERATE, NAME=LIBERTY or NAME=LIBERTY:DERATE\n");
+        return -1;
+    }
+    char name[MAX_CORNER_NAME];
+    snprintf(name, sizeof(name), "%.*s", (int)(equals - argument), argument);
+    const char* spec = equals + 1;
+
+    char* end;
+    double derate = strtod(spec, &end);
+    if (end != spec && *end == '\0') {
+        return add_corner(circuit, name, derate, NULL);
+    }
+
+    // Library, with an optional derate after the last colon
+    derate = 1.0;
+    size_t length = strlen(spec);
+    const char* colon = strrchr(spec, ':');
+    if (colon) {
+        double value = strtod(colon + 1, &end);
+        if (end != colon + 1 && *end == '\0') {
+            derate = value;
+            length = colon - spec;
+        }
+    }
+    char* path = malloc(length + 1);
+    memcpy(path, spec, length);
+    path[length] = '\0';
+    CellLibrary* library = load_liberty(path);
+    free(path);
+    if (!library) return -1;
+    int corner = add_corner(circuit, name, derate, library);
+    if (corner < 0) free_liberty(library);
+    return corner;
+}
+
+// Example usage
+int main(int argc, char** argv) {
+    int thread_count = 1;
+    int bench_incremental = 0;
+    int bench_corners = 0;
+    int bench_statistical = 0;
+    int bench_path_based = 0;
+    int bench_suite = 0;
+    int bench_out_of_core = 0;
+    int bench_loops = 0;
+    NetlistProfile profile = {0, BENCH_DEFAULT_DEPTH, 1.0, 0.2, 1};
+    int sample_count = 0;
+    double delay_sigma = -1.0;
+    int pba_endpoints = 0;
+    int pba_paths = PBA_DEFAULT_PATHS;
+    const char* report_path = NULL;
+    ReportOptions report = {REPORT_TEXT, REPORT_DEFAULT_WORST, 0};
+    int path_count = 0;
+    const char* liberty_path = NULL;
+    const char** verilog_paths = NULL;
+    int verilog_count = 0;
+    const char* snapshot_path = NULL;
+    const char* write_snapshot_path = NULL;
+    const char* sdc_path = NULL;
+    double clock_period = 0.0;
+    const char** corner_specs = NULL;
+    int corner_spec_count = 0;
+    const char* trace_path = NULL;
+    int trace_counters = 0;
+    const char* out_of_core_directory = NULL;
+    double memory_budget_mb = OUT_OF_CORE_DEFAULT_BUDGET_MB;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) {
+            thread_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--paths") == 0 && i + 1 < argc) {
+            path_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--liberty") == 0 && i + 1 < argc) {
+            liberty_path = argv[++i];
+        } else if (strcmp(argv[i], "--verilog") == 0 && i + 1 < argc) {
+            verilog_paths = grow_array(verilog_paths, verilog_count + 1, sizeof(const char*));
+            verilog_paths[verilog_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--snapshot") == 0 && i + 1 < argc) {
+            snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--write-snapshot") == 0 && i + 1 < argc) {
+            write_snapshot_path = argv[++i];
+        } else if (strcmp(argv[i], "--sdc") == 0 && i + 1 < argc) {
+            sdc_path = argv[++i];
+        } else if (strcmp(argv[i], "--period") == 0 && i + 1 < argc) {
+            clock_period = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--corner") == 0 && i + 1 < argc) {
+            corner_specs = grow_array(corner_specs, corner_spec_count + 1, sizeof(const char*));
+            corner_specs[corner_spec_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--monte-carlo") == 0 && i + 1 < argc) {
+            sample_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--sigma") == 0 && i + 1 < argc) {
+            delay_sigma = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--pba") == 0 && i + 1 < argc) {
+            pba_endpoints = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--pba-paths") == 0 && i + 1 < argc) {
+            pba_paths = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--report") == 0 && i + 1 < argc) {
+            report_path = argv[++i];
+        } else if (strcmp(argv[i], "--report-format") == 0 && i + 1 < argc) {
+            const char* format = argv[++i];
+            if (strcmp(format, "text") == 0) {
+                report.format = REPORT_TEXT;
+            } else if (strcmp(format, "csv") == 0) {
+                report.format = REPORT_CSV;
+            } else if (strcmp(format, "json") == 0) {
+                report.format = REPORT_JSON;
+            } else if (strcmp(format, "binary") == 0) {
+                report.format = REPORT_BINARY;
+            } else {
+                fprintf(stderr, "--report-format must be text, csv, json or binary\n");
+                return 1;
+            }
+        } else if (strcmp(argv[i], "--report-worst") == 0 && i + 1 < argc) {
+            report.worst_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--report-nodes") == 0) {
+            report.include_nodes = 1;
+        } else if (strcmp(argv[i], "--out-of-core") == 0 && i + 1 < argc) {
+            out_of_core_directory = argv[++i];
+        } else if (strcmp(argv[i], "--memory-budget") == 0 && i + 1 < argc) {
+            memory_budget_mb = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--trace") == 0 && i + 1 < argc) {
+            trace_path = argv[++i];
+        } else if (strcmp(argv[i], "--trace-counters") == 0) {
+            trace_counters = 1;
+        } else if (strcmp(argv[i], "--bench-incremental") == 0 && i + 1 < argc) {
+            bench_incremental = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-corners") == 0 && i + 1 < argc) {
+            bench_corners = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-monte-carlo") == 0 && i + 1 < argc) {
+            bench_statistical = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-pba") == 0 && i + 1 < argc) {
+            bench_path_based = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-out-of-core") == 0 && i + 1 < argc) {
+            bench_out_of_core = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-loops") == 0 && i + 1 < argc) {
+            bench_loops = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-suite") == 0 && i + 1 < argc) {
+            bench_suite = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-depth") == 0 && i + 1 < argc) {
+            profile.depth = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-fanout-skew") == 0 && i + 1 < argc) {
+            profile.fanout_skew = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--bench-reconvergence") == 0 && i + 1 < argc) {
+            profile.reconvergence = atof(argv[++i]);
+        } else {
+            fprintf(stderr, "Usage: %s [--threads N] [--paths K] [--liberty FILE] [--verilog FILE]...\n"
+                    "       [--sdc FILE] [--period NS] [--corner NAME=DERATE|LIBERTY[:DERATE]]...\n"
+                    "       [--monte-carlo SAMPLES] [--sigma FRACTION]\n"
+                    "       [--pba ENDPOINTS] [--pba-paths K]\n"
+                    "       [--report FILE] [--report-format text|csv|json|binary]\n"
+                    "       [--report-worst N] [--report-nodes]\n"
+                    "       [--snapshot FILE] [--write-snapshot FILE]\n"
+                    "       [--out-of-core DIRECTORY] [--memory-budget MB]\n"
+                    "       [--trace FILE] [--trace-counters]\n"
+                    "       [--bench-incremental GATES] [--bench-corners GATES]\n"
+                    "       [--bench-monte-carlo GATES] [--bench-pba GATES]\n"
+                    "       [--bench-out-of-core GATES] [--bench-loops GATES]\n"
+                    "       [--bench-suite MAX_GATES] [--bench-depth LEVELS]\n"
+                    "       [--bench-fanout-skew EXPONENT] [--bench-reconvergence PROBABILITY]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (thread_count < 1) {
+        fprintf(stderr, "--threads must be at least 1\n");
+        return 1;
+    }
+    if (report.format != REPORT_TEXT && !report_path) {
+        // Progress and summaries share standard output with a text report
+        fprintf(stderr, "--report-format csv, json and binary need --report FILE\n");
+        return 1;
+    }
+    if (!(memory_budget_mb > 0.0)) {
+        fprintf(stderr, "--memory-budget must be positive\n");
+        return 1;
+    }
+    size_t memory_budget = (size_t)(memory_budget_mb * 1048576.0);
+    if (out_of_core_directory && (path_count > 0 || pba_endpoints > 0 || sample_count > 0 ||
+                                  corner_spec_count > 0 || report_path)) {
+        // Those analyses need every node's timing in memory
+        fprintf(stderr, "--out-of-core reports endpoint slack only and cannot be combined with\n"
+                "--paths, --pba, --monte-carlo, --corner or --report\n");
+        return 1;
+    }
+    if (trace_counters && !trace_path) {
+        fprintf(stderr, "--trace-counters needs --trace FILE\n");
+        return 1;
+    }
+    if (trace_path) {
+        // Written at exit so every return below still produces a trace
+        if (trace_start(trace_path, trace_counters) != 0) return 1;
+        atexit(trace_stop);
+    }
+    if (bench_incremental > 0) {
+        return run_incremental_benchmark(bench_incremental, thread_count);
+    }
+    if (bench_corners > 0) {
+        return run_corner_benchmark(bench_corners, thread_count);
+    }
+    if (bench_statistical > 0) {
+        return run_statistical_benchmark(bench_statistical, thread_count);
+    }
+    if (bench_path_based > 0) {
+        return run_path_based_benchmark(bench_path_based, thread_count, liberty_path);
+    }
+    if (bench_out_of_core > 0) {
+        return run_out_of_core_benchmark(bench_out_of_core, memory_budget);
+    }
+    if (bench_loops > 0) {
+        return run_loop_benchmark(bench_loops);
+    }
+    if (bench_suite > 0) {
+        if (profile.depth < 1 || !(profile.fanout_skew > 0.0)) {
+            fprintf(stderr, "--bench-depth must be at least 1 and --bench-fanout-skew positive\n");
+            return 1;
+        }
+        return run_benchmark_suite(&profile, bench_suite, thread_count, report.format, report_path);
+    }
+
+    Circuit* circuit;
+    if (snapshot_path) {
+        // A snapshot holds the complete graph, so it replaces any netlist
+        circuit = load_snapshot(snapshot_path);
+        if (!circuit) return 1;
+        printf("Loaded %s: %d node(s), %d connection(s), %d level(s)\n",
+               snapshot_path, circuit->node_count, circuit->edge_count, circuit->level_count);
+    } else {
+        circuit = create_circuit();
+    }
+    circuit->thread_count = thread_count;
+    if (liberty_path) {
+        circuit->library = load_liberty(liberty_path);
+        if (!circuit->library) return 1;
+    }
+    for (int i = 0; i < corner_spec_count; i++) {
+        if (parse_corner(circuit, corner_specs[i]) < 0) return 1;
+    }
+    free(corner_specs);
+
+    if (snapshot_path) {
+        free(verilog_paths);
+    } else if (verilog_count > 0) {
+        // Netlists replace the built-in example circuit
+        for (int i = 0; i < verilog_count; i++) {
+            if (read_verilog_netlist(circuit, verilog_paths[i]) != 0) return 1;
+        }
+        free(verilog_paths);
+    } else {
+        // Create nodes
+        NodeId input1 = create_node(circuit, "IN1", INPUT);
+        NodeId input2 = create_node(circuit, "IN2", INPUT);
+        NodeId and_gate = create_node(circuit, "AND1", GATE_AND);
+        NodeId not_gate = create_node(circuit, "NOT1", GATE_NOT);
+        NodeId output = create_node(circuit, "OUT", OUTPUT);
+
+        // Connect nodes
+        add_connection(circuit, input1, and_gate);
+        add_connection(circuit, input2, and_gate);
+        add_connection(circuit, and_gate, not_gate);
+        add_connection(circuit, not_gate, output);
+    }
+
+    // Perform STA. Constraints come first so set_disable_timing can choose
+    // where combinational loops are cut.
+    if (sdc_path && read_constraints(circuit, sdc_path) != 0) {
+        return 1;
+    }
+    if (!circuit->levelized && levelize_circuit(circuit) != 0) {
+        return 1;
+    }
+    compute_delays(circuit);
+    if (clock_period > 0.0) {
+        circuit->clock_period = clock_period;
+    }
+    if (write_snapshot_path && write_snapshot(circuit, write_snapshot_path) != 0) {
+        return 1;
+    }
+    if (out_of_core_directory) {
+        OutOfCoreTiming timing;
+        if (compute_out_of_core_timing(circuit, out_of_core_directory, memory_budget, &timing) != 0) return 1;
+        print_out_of_core_timing(&timing, out_of_core_directory);
+        free_liberty(circuit->library);
+        free_circuit(circuit);
+        return 0;
+    }
+    if (delay_sigma >= 0.0) {
+        for (int i = 0; i < circuit->node_count; i++) {
+            if (circuit->type[i] != INPUT) circuit->delay_sigma[i] = delay_sigma;
+        }
+    }
+    compute_arrival_times(circuit);
+    compute_required_times(circuit);
+    compute_slack(circuit);
+    compute_corner_timing(circuit);
+
+    // Report results
+    CriticalPaths* paths = path_count > 0 ? find_critical_paths(circuit, path_count) : NULL;
+    if (write_timing_report(circuit, paths, &report, report_path) != 0) return 1;
+    free_critical_paths(paths);
+    int has_flops = 0;
+    for (int i = 0; i < circuit->endpoint_count; i++) {
+        if (circuit->type[circuit->endpoints[i]] == GATE_DFF) has_flops = 1;
+    }
+    if (circuit->clock_period > 0.0 || has_flops) print_timing_checks(circuit);
+    if (circuit->corner_count > 0) print_corner_summary(circuit);
+    if (sample_count > 0) {
+        StatisticalTiming* stats = compute_statistical_timing(circuit, sample_count, MC_DEFAULT_SEED);
+        if (stats) print_statistical_timing(circuit, stats);
+        free_statistical_timing(stats);
+    }
+    if (pba_endpoints > 0) {
+        PathBasedTiming* refined = compute_path_based_timing(circuit, pba_endpoints, pba_paths);
+        if (refined) print_path_based_timing(circuit, refined);
+        free_path_based_timing(refined);
+    }
+
+    free_liberty(circuit->library);
+    for (int c = 0; c < circuit->corner_count; c++) {
+        free_liberty(circuit->corners[c].library);
+    }
+    free_circuit(circuit);
     return 0;
 }
@@ -0,0 +1,283 @@
+// Lightweight phase tracing shared by the tools in this directory.
+//
+// Each tool includes this header once, after its system headers, and calls
+// trace_start() before the work it wants traced and trace_stop() at the
+// end. Phases are marked with TRACE_SCOPE("name") at the top of a block;
+// the scope closes when the block exits. Every closed scope becomes one
+// complete event in a Chrome trace JSON file (chrome://tracing or
+// https://ui.perfetto.dev), carrying:
+//   - wall-clock start and duration
+//   - heap allocations and bytes requested while the scope was open
+//     (malloc, calloc, realloc and aligned_alloc are counted through the
+//     macros at the end of this header)
+//   - with hardware counters requested and permitted by the kernel,
+//     instructions, cycles and cache misses from perf_event_open
+//
+// Scope names must be string literals (or outlive the trace). While no
+// trace is running a scope costs one flag test.
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+#endif
+
+#define TRACE_INITIAL_EVENTS 256
+
+// Hardware counters read around every scope
+enum {
+    TRACE_INSTRUCTIONS,
+    TRACE_CYCLES,
+    TRACE_CACHE_MISSES,
+    TRACE_COUNTER_COUNT
+};
+
+typedef struct {
+    const char* name;
+    double start;            // Microseconds since trace_start()
+    double duration;
+    int thread;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t counters[TRACE_COUNTER_COUNT];
+} TraceEvent;
+
+// An open scope: the starting values of everything it measures
+typedef struct {
+    const char* name;
+    int active;
+    double start;
+    uint64_t allocations;
+    uint64_t allocated_bytes;
+    uint64_t counters[TRACE_COUNTER_COUNT];
+} TraceScope;
+
+typedef struct {
+    int enabled;
+    FILE* file;
+    double origin;           // Seconds
+    TraceEvent* events;
+    int event_count;
+    int event_capacity;
+    char lock;               // Spin lock guarding the event array
+    int counter_fds[TRACE_COUNTER_COUNT];
+    int counters_open;
+    int counter_errno;       // Why hardware counters are unavailable
+    uint64_t allocations;    // Updated atomically from any thread
+    uint64_t allocated_bytes;
+} TraceState;
+
+static TraceState trace_state = {0};
+
+static inline double trace_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec + now.tv_nsec * 1e-9;
+}
+
+static inline int trace_thread_id(void) {
+#ifdef __linux__
+    return (int)syscall(SYS_gettid);
+#else
+    return 0;
+#endif
+}
+
+#ifdef __linux__
+// Open one counter for this process and every thread it creates later.
+// Counting user space only keeps the default perf_event_paranoid happy.
+static inline int trace_open_counter(uint64_t config) {
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.inherit = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+#endif
+
+static inline void trace_read_counters(uint64_t* values) {
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++) {
+        values[c] = 0;
+        if (trace_state.counters_open && read(trace_state.counter_fds[c], &values[c], sizeof(values[c])) != sizeof(values[c])) {
+            values[c] = 0;
+        }
+    }
+}
+
+// Start tracing to path. With hardware_counters set, also try to open
+// the perf counters; if the kernel refuses, the trace is written without
+// them and records why. Returns 0 on success, -1 if path cannot be written.
+static inline int trace_start(const char* path, int hardware_counters) {
+    FILE* file = fopen(path, "w");
+    if (!file) {
+        fprintf(stderr, "Cannot write trace %s\n", path);
+        return -1;
+    }
+    trace_state.file = file;
+    trace_state.counters_open = 0;
+    trace_state.counter_errno = 0;
+
+#ifdef __linux__
+    if (hardware_counters) {
+        static const uint64_t configs[TRACE_COUNTER_COUNT] = {
+            PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_CACHE_MISSES
+        };
+        int opened = 0;
+        for (int c = 0; c < TRACE_COUNTER_COUNT; c++) {
+            trace_state.counter_fds[c] = trace_open_counter(configs[c]);
+            if (trace_state.counter_fds[c] < 0) {
+                trace_state.counter_errno = errno;
+                break;
+            }
+            opened++;
+        }
+        if (opened == TRACE_COUNTER_COUNT) {
+            trace_state.counters_open = 1;
+        } else {
+            while (opened > 0) close(trace_state.counter_fds[--opened]);
+            fprintf(stderr, "Hardware counters unavailable: %s\n", strerror(trace_state.counter_errno));
+        }
+    }
+#else
+    if (hardware_counters) {
+        trace_state.counter_errno = ENOSYS;
+        fprintf(stderr, "Hardware counters unavailable on this platform\n");
+    }
+#endif
+
+    trace_state.origin = trace_seconds();
+    trace_state.enabled = 1;
+    return 0;
+}
+
+static inline TraceScope trace_begin(const char* name) {
+    TraceScope scope = {0};
+    if (!trace_state.enabled) return scope;
+    scope.name = name;
+    scope.active = 1;
+    scope.allocations = __atomic_load_n(&trace_state.allocations, __ATOMIC_RELAXED);
+    scope.allocated_bytes = __atomic_load_n(&trace_state.allocated_bytes, __ATOMIC_RELAXED);
+    trace_read_counters(scope.counters);
+    scope.start = trace_seconds();
+    return scope;
+}
+
+static inline void trace_end(TraceScope* scope) {
+    if (!scope->active || !trace_state.enabled) return;
+    double end = trace_seconds();
+    TraceEvent event;
+    trace_read_counters(event.counters);
+    for (int c = 0; c < TRACE_COUNTER_COUNT; c++) event.counters[c] -= scope->counters[c];
+    event.name = scope->name;
+    event.start = (scope->start - trace_state.origin) * 1e6;
+    event.duration = (end - scope->start) * 1e6;
+    event.thread = trace_thread_id();
+    event.allocations = __atomic_load_n(&trace_state.allocations, __ATOMIC_RELAXED) - scope->allocations;
+    event.allocated_bytes = __atomic_load_n(&trace_state.allocated_bytes, __ATOMIC_RELAXED) - scope->allocated_bytes;
+
+    while (__atomic_test_and_set(&trace_state.lock, __ATOMIC_ACQUIRE)) {
+    }
+    if (trace_state.event_count == trace_state.event_capacity) {
+        int capacity = trace_state.event_capacity ? trace_state.event_capacity * 2 : TRACE_INITIAL_EVENTS;
+        TraceEvent* events = (realloc)(trace_state.events, capacity * sizeof(TraceEvent));
+        if (events) {
+            trace_state.events = events;
+            trace_state.event_capacity = capacity;
+        }
+    }
+    if (trace_state.event_count < trace_state.event_capacity) {
+        trace_state.events[trace_state.event_count++] = event;
+    }
+    __atomic_clear(&trace_state.lock, __ATOMIC_RELEASE);
+}
+
+// Write every recorded event and close the trace
+static inline void trace_stop(void) {
+    if (!trace_state.enabled) return;
+    trace_state.enabled = 0;
+    FILE* file = trace_state.file;
+    int pid = (int)getpid();
+
+    fprintf(file, "{\"displayTimeUnit\": \"ms\",\n\"otherData\": {\"hardware_counters\": \"%s\"},\n",
+            trace_state.counters_open ? "enabled"
+            : trace_state.counter_errno ? strerror(trace_state.counter_errno) : "not requested");
+    fprintf(file, "\"traceEvents\": [");
+    for (int i = 0; i < trace_state.event_count; i++) {
+        const TraceEvent* event = &trace_state.events[i];
+        fprintf(file, "%s\n {\"name\": \"%s\", \"cat\": \"phase\", \"ph\": \"X\", \"pid\": %d, \"tid\": %d, "
+                "\"ts\": %.3f, \"dur\": %.3f, \"args\": {\"allocations\": %llu, \"allocated_bytes\": %llu",
+                i > 0 ? "," : "", event->name, pid, event->thread, event->start, event->duration,
+                (unsigned long long)event->allocations, (unsigned long long)event->allocated_bytes);
+        if (trace_state.counters_open) {
+            fprintf(file, ", \"instructions\": %llu, \"cycles\": %llu, \"cache_misses\": %llu",
+                    (unsigned long long)event->counters[TRACE_INSTRUCTIONS],
+                    (unsigned long long)event->counters[TRACE_CYCLES],
+                    (unsigned long long)event->counters[TRACE_CACHE_MISSES]);
+        }
+        fprintf(file, "}}");
+    }
+    fprintf(file, "\n]}\n");
+    if (fclose(file) != 0) fprintf(stderr, "Error writing trace\n");
+
+    if (trace_state.counters_open) {
+        for (int c = 0; c < TRACE_COUNTER_COUNT; c++) close(trace_state.counter_fds[c]);
+    }
+    (free)(trace_state.events);
+    trace_state.events = NULL;
+    trace_state.event_count = 0;
+    trace_state.event_capacity = 0;
+}
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+// Trace the rest of the enclosing block as one phase
+#define TRACE_SCOPE(name) \
+    TraceScope TRACE_CONCAT(trace_scope_, __LINE__) __attribute__((cleanup(trace_end))) = trace_begin(name)
+
+// Allocation counting. The tool's own calls below the include go through
+// these wrappers; the parenthesized names call the real functions.
+static inline void trace_count_allocation(size_t bytes) {
+    __atomic_fetch_add(&trace_state.allocations, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&trace_state.allocated_bytes, bytes, __ATOMIC_RELAXED);
+}
+
+static inline void* trace_malloc(size_t bytes) {
+    trace_count_allocation(bytes);
+    return (malloc)(bytes);
+}
+
+static inline void* trace_calloc(size_t count, size_t bytes) {
+    trace_count_allocation(count * bytes);
+    return (calloc)(count, bytes);
+}
+
+static inline void* trace_realloc(void* pointer, size_t bytes) {
+    trace_count_allocation(bytes);
+    return (realloc)(pointer, bytes);
+}
+
+static inline void* trace_aligned_alloc(size_t alignment, size_t bytes) {
+    trace_count_allocation(bytes);
+    return (aligned_alloc)(alignment, bytes);
+}
+
+#define malloc(bytes) trace_malloc(bytes)
+#define calloc(count, bytes) trace_calloc(count, bytes)
+#define realloc(pointer, bytes) trace_realloc(pointer, bytes)
+#define aligned_alloc(alignment, bytes) trace_aligned_alloc(alignment, bytes)
+
+#endif